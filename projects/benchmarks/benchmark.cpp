@@ -0,0 +1,390 @@
+#include "benchmark.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <regex>
+#include <thread>
+#include <memory>
+
+namespace Benchmark
+{
+	State::State(const std::vector<int64_t>& args, int64_t iterations)
+		: args(args), maxIterations(iterations)
+	{
+	}
+
+	State::Iterator State::begin()
+	{
+		StartTimer();
+		return { this, maxIterations };
+	}
+
+	void State::PauseTiming()
+	{
+		StopTimer();
+	}
+
+	void State::ResumeTiming()
+	{
+		StartTimer();
+	}
+
+	void State::StartTimer()
+	{
+		if (running)
+			return;
+
+		running = true;
+		realStart = std::chrono::steady_clock::now();
+		cpuStart = std::clock();
+	}
+
+	void State::StopTimer()
+	{
+		if (!running)
+			return;
+
+		running = false;
+		realSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+		cpuSeconds += (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	}
+
+	Registration::Registration(const std::string& name, Function function)
+		: name(name), function(std::move(function))
+	{
+	}
+
+	Registration* Registration::Arg(int64_t arg)
+	{
+		args.push_back({ arg });
+		return this;
+	}
+
+	Registration* Registration::Args(std::initializer_list<int64_t> values)
+	{
+		args.push_back(values);
+		return this;
+	}
+
+	Registration* Registration::Range(int64_t start, int64_t limit, int64_t multiplier)
+	{
+		for (int64_t arg = start; arg <= limit; arg *= multiplier)
+			args.push_back({ arg });
+		return this;
+	}
+
+	Registration* Registration::ArgNames(std::initializer_list<std::string> names)
+	{
+		argNames = names;
+		return this;
+	}
+
+	Registration* Registration::Iterations(int64_t value)
+	{
+		iterations = value;
+		return this;
+	}
+
+	Registration* Registration::Unit(TimeUnit value)
+	{
+		unit = value;
+		return this;
+	}
+
+	static std::vector<std::unique_ptr<Registration>>& GetRegistrations()
+	{
+		// function static, registrations are created during static initialization of other files
+		static std::vector<std::unique_ptr<Registration>> registrations;
+		return registrations;
+	}
+
+	static std::map<std::string, std::string>& GetContext()
+	{
+		static std::map<std::string, std::string> context;
+		return context;
+	}
+
+	Registration* Register(const std::string& name, Function function)
+	{
+		GetRegistrations().push_back(std::make_unique<Registration>(name, std::move(function)));
+		return GetRegistrations().back().get();
+	}
+
+	void AddContext(const std::string& key, const std::string& value)
+	{
+		GetContext()[key] = value;
+	}
+
+	struct Result
+	{
+		std::string name;
+		int64_t iterations = 0;
+		double realSeconds = 0.0;
+		double cpuSeconds = 0.0;
+		int64_t itemsProcessed = 0;
+		std::string label;
+		std::string error;
+		std::map<std::string, double> counters;
+		TimeUnit unit = TimeUnit::Nanosecond;
+	};
+
+	static double GetUnitMultiplier(TimeUnit unit)
+	{
+		switch (unit)
+		{
+		case TimeUnit::Nanosecond: return 1e9;
+		case TimeUnit::Microsecond: return 1e6;
+		case TimeUnit::Millisecond: return 1e3;
+		case TimeUnit::Second: return 1.0;
+		}
+		return 1.0;
+	}
+
+	static const char* GetUnitName(TimeUnit unit)
+	{
+		switch (unit)
+		{
+		case TimeUnit::Nanosecond: return "ns";
+		case TimeUnit::Microsecond: return "us";
+		case TimeUnit::Millisecond: return "ms";
+		case TimeUnit::Second: return "s";
+		}
+		return "";
+	}
+
+	static std::string GetRunName(const Registration& registration, const std::vector<int64_t>& args)
+	{
+		std::string result = registration.name;
+		for (size_t i = 0; i < args.size(); i++)
+		{
+			result += "/";
+			if (i < registration.argNames.size())
+				result += registration.argNames[i] + ":";
+			result += std::to_string(args[i]);
+		}
+		return result;
+	}
+
+	struct Runner
+	{
+		double minTime = 0.5;
+
+		Result Run(const Registration& registration, const std::vector<int64_t>& args)
+		{
+			Result result;
+			result.name = GetRunName(registration, args);
+			result.unit = registration.unit;
+
+			int64_t iterations = registration.iterations > 0 ? registration.iterations : 1;
+
+			while (true)
+			{
+				State state(args, iterations);
+				registration.function(state);
+
+				const double seconds = state.realSeconds;
+				const bool done = registration.iterations > 0 || !state.error.empty() || seconds >= minTime || iterations >= 1000000000;
+
+				if (done)
+				{
+					result.iterations = iterations;
+					result.realSeconds = state.realSeconds;
+					result.cpuSeconds = state.cpuSeconds;
+					result.itemsProcessed = state.itemsProcessed;
+					result.label = state.label;
+					result.error = state.error;
+					result.counters = state.counters;
+					return result;
+				}
+
+				// predict iterations needed for minimal time with some margin, grow at most 10x per try
+				double multiplier = seconds > 0.0 ? minTime * 1.4 / seconds : 10.0;
+				multiplier = std::clamp(multiplier, 2.0, 10.0);
+				iterations = (int64_t)std::ceil((double)iterations * multiplier);
+			}
+		}
+	};
+
+	static void PrintResult(const Result& result)
+	{
+		const double multiplier = GetUnitMultiplier(result.unit);
+		const double iterations = (double)std::max<int64_t>(result.iterations, 1);
+
+		std::cout << std::left << std::setw(56) << result.name << std::right;
+
+		if (!result.error.empty())
+		{
+			std::cout << " ERROR: " << result.error << "\n";
+			return;
+		}
+
+		// nanoseconds without decimals, larger units with two
+		const int32_t precision = result.unit == TimeUnit::Nanosecond ? 0 : 2;
+
+		std::cout << std::setw(14) << std::fixed << std::setprecision(precision) << result.realSeconds * multiplier / iterations << " " << GetUnitName(result.unit)
+				  << std::setw(14) << result.cpuSeconds * multiplier / iterations << " " << GetUnitName(result.unit)
+				  << std::setw(12) << result.iterations;
+
+		std::cout << std::defaultfloat << std::setprecision(4);
+		if (result.itemsProcessed > 0 && result.realSeconds > 0.0)
+			std::cout << " items/s=" << (double)result.itemsProcessed / result.realSeconds;
+		for (const auto& [key, value] : result.counters)
+			std::cout << " " << key << "=" << value;
+		if (!result.label.empty())
+			std::cout << " " << result.label;
+
+		std::cout << "\n";
+	}
+
+	static nlohmann::json ToJson(const Result& result)
+	{
+		const double multiplier = GetUnitMultiplier(result.unit);
+		const double iterations = (double)std::max<int64_t>(result.iterations, 1);
+
+		nlohmann::json json;
+		json["name"] = result.name;
+		json["run_name"] = result.name;
+		json["run_type"] = "iteration";
+		json["iterations"] = result.iterations;
+		json["real_time"] = result.realSeconds * multiplier / iterations;
+		json["cpu_time"] = result.cpuSeconds * multiplier / iterations;
+		json["time_unit"] = GetUnitName(result.unit);
+
+		if (!result.error.empty())
+		{
+			json["error_occurred"] = true;
+			json["error_message"] = result.error;
+		}
+		if (result.itemsProcessed > 0 && result.realSeconds > 0.0)
+			json["items_per_second"] = (double)result.itemsProcessed / result.realSeconds;
+		if (!result.label.empty())
+			json["label"] = result.label;
+
+		for (const auto& [key, value] : result.counters)
+			json[key] = value;
+
+		return json;
+	}
+
+	static std::string GetDate()
+	{
+		std::time_t now = std::time(nullptr);
+		std::tm tm{};
+#ifdef _WIN32
+		localtime_s(&tm, &now);
+#else
+		localtime_r(&now, &tm);
+#endif
+		std::ostringstream stream;
+		stream << std::put_time(&tm, "%Y-%m-%dT%H:%M:%S");
+		return stream.str();
+	}
+
+	static bool ParseFlag(const std::string& arg, const std::string& name, std::string& value)
+	{
+		const std::string prefix = "--" + name + "=";
+		if (arg.rfind(prefix, 0) != 0)
+			return false;
+		value = arg.substr(prefix.size());
+		return true;
+	}
+
+	int Run(int argc, char** argv)
+	{
+		Runner runner;
+		std::string filter = ".";
+		std::string output;
+		bool listOnly = false;
+
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			std::string value;
+
+			if (ParseFlag(arg, "benchmark_filter", value))
+				filter = value;
+			else if (ParseFlag(arg, "benchmark_min_time", value))
+				runner.minTime = std::stod(value);
+			else if (ParseFlag(arg, "benchmark_out", value))
+				output = value;
+			else if (ParseFlag(arg, "benchmark_context", value))
+			{
+				auto separator = value.find('=');
+				if (separator == std::string::npos)
+				{
+					std::cerr << "invalid context " << value << ", expected key=value\n";
+					return 1;
+				}
+				AddContext(value.substr(0, separator), value.substr(separator + 1));
+			}
+			else if (arg == "--benchmark_list_tests")
+				listOnly = true;
+			else
+			{
+				std::cerr << "unknown argument " << arg << "\n";
+				return 1;
+			}
+		}
+
+		const std::regex filterRegex(filter);
+		std::vector<Result> results;
+
+		for (const auto& registration : GetRegistrations())
+		{
+			auto argsList = registration->args;
+			if (argsList.empty())
+				argsList.push_back({});
+
+			for (const auto& args : argsList)
+			{
+				std::string name = GetRunName(*registration, args);
+				if (!std::regex_search(name, filterRegex))
+					continue;
+
+				if (listOnly)
+				{
+					std::cout << name << "\n";
+					continue;
+				}
+
+				results.push_back(runner.Run(*registration, args));
+				PrintResult(results.back());
+			}
+		}
+
+		if (listOnly || output.empty())
+			return 0;
+
+		nlohmann::json json;
+		auto& context = json["context"];
+		context["date"] = GetDate();
+		context["executable"] = argc > 0 ? argv[0] : "";
+		context["num_cpus"] = (int64_t)std::thread::hardware_concurrency();
+#ifdef NDEBUG
+		context["library_build_type"] = "release";
+#else
+		context["library_build_type"] = "debug";
+#endif
+		for (const auto& [key, value] : GetContext())
+			context[key] = value;
+
+		auto benchmarks = nlohmann::json::array();
+		for (const auto& result : results)
+			benchmarks.push_back(ToJson(result));
+		json["benchmarks"] = benchmarks;
+
+		std::ofstream file(output);
+		if (!file)
+		{
+			std::cerr << "can't write " << output << "\n";
+			return 1;
+		}
+		file << json.dump(2) << "\n";
+
+		return 0;
+	}
+}
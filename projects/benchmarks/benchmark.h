@@ -0,0 +1,135 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+#include <initializer_list>
+
+// Small benchmark harness with interface of Google Benchmark (BENCHMARK macros, State, flags),
+// so there is no external dependency. Each benchmark runs with growing number of iterations until
+// it takes at least minimal time. Results can be written as JSON in the layout of Google Benchmark
+// (--benchmark_out=<file>), tools comparing its outputs of two commits work also for these.
+namespace Benchmark
+{
+	struct State
+	{
+		// value of range for loop over state, the loop variable is never used
+		struct [[maybe_unused]] Value {};
+
+		struct Iterator
+		{
+			State* state;
+			int64_t remaining;
+
+			bool operator!=(const Iterator&)
+			{
+				if (remaining > 0)
+					return true;
+				state->StopTimer();
+				return false;
+			}
+			void operator++() { remaining--; }
+			Value operator*() const { return {}; }
+		};
+
+		State(const std::vector<int64_t>& args, int64_t iterations);
+
+		Iterator begin();
+		Iterator end() { return { this, 0 }; }
+
+		// exclude setup inside of the loop from measured time
+		void PauseTiming();
+		void ResumeTiming();
+
+		int64_t range(size_t index = 0) const { return args.at(index); }
+		int64_t iterations() const { return maxIterations; }
+
+		void SetItemsProcessed(int64_t items) { itemsProcessed = items; }
+		void SetLabel(const std::string& text) { label = text; }
+		void SkipWithError(const std::string& message) { error = message; }
+
+		// custom values reported with the benchmark (e.g. energy drift), not divided by iterations
+		std::map<std::string, double> counters;
+
+	private:
+		friend struct Runner;
+
+		void StartTimer();
+		void StopTimer();
+
+		std::vector<int64_t> args;
+		int64_t maxIterations;
+
+		bool running = false;
+		std::chrono::steady_clock::time_point realStart;
+		std::clock_t cpuStart = 0;
+		double realSeconds = 0.0;
+		double cpuSeconds = 0.0;
+
+		int64_t itemsProcessed = 0;
+		std::string label;
+		std::string error;
+	};
+
+	using Function = std::function<void(State&)>;
+
+	enum class TimeUnit
+	{
+		Nanosecond,
+		Microsecond,
+		Millisecond,
+		Second
+	};
+
+	struct Registration
+	{
+		Registration(const std::string& name, Function function);
+
+		Registration* Arg(int64_t arg);
+		Registration* Args(std::initializer_list<int64_t> args);
+		// arg for all values start, start * multiplier, ... up to limit (included)
+		Registration* Range(int64_t start, int64_t limit, int64_t multiplier = 8);
+		Registration* ArgNames(std::initializer_list<std::string> names);
+		// fixed iterations, for long running benchmarks (e.g. simulation of several years)
+		Registration* Iterations(int64_t iterations);
+		Registration* Unit(TimeUnit unit);
+
+		std::string name;
+		Function function;
+		std::vector<std::vector<int64_t>> args;
+		std::vector<std::string> argNames;
+		int64_t iterations = 0;
+		TimeUnit unit = TimeUnit::Nanosecond;
+	};
+
+	Registration* Register(const std::string& name, Function function);
+
+	// value written to "context" of JSON output, e.g. instruction set of gravity kernel
+	void AddContext(const std::string& key, const std::string& value);
+
+	// Runs registered benchmarks, supports flags --benchmark_filter=<regex>, --benchmark_min_time=<seconds>,
+	// --benchmark_out=<file>, --benchmark_context=<key>=<value> and --benchmark_list_tests.
+	int Run(int argc, char** argv);
+}
+
+#define BENCHMARK_CONCAT_INNER(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_INNER(a, b)
+#define BENCHMARK_REGISTRATION static Benchmark::Registration* BENCHMARK_CONCAT(benchmarkRegistration, __LINE__) [[maybe_unused]]
+
+#define BENCHMARK(function) BENCHMARK_REGISTRATION = Benchmark::Register(#function, function)
+#define BENCHMARK_TEMPLATE(function, type) BENCHMARK_REGISTRATION = Benchmark::Register(#function "<" #type ">", function<type>)
+
+// prevents compiler from optimizing away computation of value
+template<class T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
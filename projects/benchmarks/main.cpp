@@ -0,0 +1,23 @@
+#include "benchmark.h"
+#include "../space/gravityKernel.h"
+#include "../space/utils.h"
+#include <string>
+
+// Benchmarks of simulation hot paths of space and rope-collisions, without window and rendering.
+// Run with --benchmark_out=results.json --benchmark_context=commit=<hash> to track regressions.
+
+double SimulationDt = 0.01;
+
+namespace TestBodies
+{
+	int32_t TrajectoryPointCount = 300;
+	float CurrentTime = 0.0f;
+}
+
+int main(int argc, char** argv)
+{
+	Benchmark::AddContext("gravity_kernel", GravityKernel::GetInstructionSet());
+	Benchmark::AddContext("random_seed", std::to_string(Utils::DefaultRandomSeed));
+
+	return Benchmark::Run(argc, argv);
+}
@@ -0,0 +1,107 @@
+#include "benchmark.h"
+#include "../rope-collisions/rope.h"
+#include "../rope-collisions/shapes.h"
+#include "../rope-collisions/collisions.h"
+
+using namespace Magnum2D;
+
+namespace
+{
+	// obstacles of rope-collisions application, window relative ones placed for camera 32x24
+	Scene CreateScene()
+	{
+		Scene scene;
+
+		scene.rectangles.push_back(Rectangle::FromMinMax({ -15.7f, -11.7f }, { -13.4f, -10.1f }));
+		auto rect = Rectangle::FromCenterSize({ 0.0f, -6.0f }, { 2.0f, 1.2f });
+		rect.angle = 45.0f;
+		scene.rectangles.push_back(std::move(rect));
+
+		scene.circles.push_back(Circle({ 14.0f, -10.0f }, 1.0f));
+
+		scene.polygons.push_back(Polygon({ { 1, -1 }, { -1, -1 }, { -1, 1 }, { 0, 1.5f }, { 1, 1 } }));
+		scene.polygons.push_back(Polygon({ { 0, 0 }, { -2, -1 }, { -2, 2 }, { 0, 1 }, { 2, 2 }, { 2, -1 } }));
+		scene.polygons.back().SetCenter({ -3, 3 });
+
+		return scene;
+	}
+
+	// horizontal rope with given number of nodes hanging from its first node, let it fall on obstacles
+	Rope CreateRope(const Scene& scene, int64_t nodes)
+	{
+		const float length = 0.2f * (float)nodes;
+
+		Rope rope({ -length * 0.5f, 6.0f }, { length * 0.5f, 6.0f });
+		rope.nodes[0].mass = 0.0f;
+
+		for (int32_t step = 0; step < 100; step++)
+		{
+			rope.SimmulateStep(scene);
+			rope.ApplyConstraints(scene);
+		}
+
+		return rope;
+	}
+}
+
+// args: number of rope nodes
+void BM_RopeApplyConstraints(Benchmark::State& state)
+{
+	Scene scene = CreateScene();
+	Rope rope = CreateRope(scene, state.range(0));
+
+	for (auto _ : state)
+	{
+		rope.ApplyConstraints(scene);
+		DoNotOptimize(rope.nodes.data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * (int64_t)rope.nodes.size());
+}
+BENCHMARK(BM_RopeApplyConstraints)->Arg(100)->Arg(1000)->ArgNames({ "nodes" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// one simulation step of rope (move of nodes with collisions), args: number of rope nodes
+void BM_RopeSimmulateStep(Benchmark::State& state)
+{
+	Scene scene = CreateScene();
+	Rope rope = CreateRope(scene, state.range(0));
+
+	for (auto _ : state)
+	{
+		rope.SimmulateStep(scene);
+		DoNotOptimize(rope.nodes.data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * (int64_t)rope.nodes.size());
+}
+BENCHMARK(BM_RopeSimmulateStep)->Arg(100)->Arg(1000)->ArgNames({ "nodes" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// moves of points on grid covering all obstacles, args: grid size
+void BM_CollisionsApplyCollisions(Benchmark::State& state)
+{
+	Scene scene = CreateScene();
+
+	const int64_t size = state.range(0);
+	std::vector<vec2> points;
+	for (int64_t y = 0; y < size; y++)
+	{
+		for (int64_t x = 0; x < size; x++)
+			points.push_back({ -16.0f + 32.0f * (float)x / (float)size, -12.0f + 24.0f * (float)y / (float)size });
+	}
+
+	std::vector<vec2> from(points.size()), to(points.size());
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			from[i] = points[i];
+			to[i] = points[i] + vec2{ 0.05f, -0.1f };
+			Collisions::applyCollisions(scene, from[i], to[i]);
+		}
+		DoNotOptimize(to.data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * (int64_t)points.size());
+}
+BENCHMARK(BM_CollisionsApplyCollisions)->Arg(32)->Arg(128)->ArgNames({ "grid" })->Unit(Benchmark::TimeUnit::Microsecond);
@@ -0,0 +1,995 @@
+#include "spaceFixtures.h"
+#include "../space/bodies.h"
+#include "../space/simulationBodies.h"
+#include "../space/systemLoader.h"
+#include "../space/utils.h"
+#include "../space/orbit.h"
+#include "../space/patchedConics.h"
+#include "../space/massPointGrid.h"
+#include "../space/conicfit/conicFit.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+using namespace Magnum2D;
+
+extern double GravitationalConstant;
+
+using namespace SpaceFixtures;
+
+// one year of system, args: number of bodies, burns enabled
+template<class T>
+void BM_Simulate(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(0));
+	const double seconds = Unit::Year;
+
+	Simulation::Statistics statistics;
+	Simulation::Settings settings;
+	settings.statistics = &statistics;
+
+	for (auto _ : state)
+		Simulate<T>(state, system, SimulationDt, seconds, settings, state.range(1) != 0);
+
+	SetStatistics(state, statistics);
+}
+BENCHMARK_TEMPLATE(BM_Simulate, PointEuler)->Args({ 16, 0 })->Args({ 16, 1 })->Args({ 64, 0 })->ArgNames({ "bodies", "burns" })->Unit(Benchmark::TimeUnit::Millisecond);
+BENCHMARK_TEMPLATE(BM_Simulate, PointVerlet)->Args({ 16, 0 })->Args({ 16, 1 })->Args({ 64, 0 })->ArgNames({ "bodies", "burns" })->Unit(Benchmark::TimeUnit::Millisecond);
+BENCHMARK_TEMPLATE(BM_Simulate, PointRungeKutta)->Args({ 16, 0 })->Args({ 16, 1 })->Args({ 64, 0 })->ArgNames({ "bodies", "burns" })->Unit(Benchmark::TimeUnit::Millisecond);
+BENCHMARK_TEMPLATE(BM_Simulate, PointDormandPrince)->Args({ 16, 0 })->Args({ 16, 1 })->Args({ 64, 0 })->ArgNames({ "bodies", "burns" })->Unit(Benchmark::TimeUnit::Millisecond);
+BENCHMARK_TEMPLATE(BM_Simulate, PointLeapfrog)->Args({ 16, 0 })->Args({ 16, 1 })->Args({ 64, 0 })->ArgNames({ "bodies", "burns" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// Bundled solar system for one year with the cheapest settings reaching energy drift 1e-10: step of RK4
+// is halved, tolerance of RK45 is tightened 10x until drift is below target (search is not measured).
+// Args: integrator (0 RK4, 1 RK45), counters steps and dt or tolerance found.
+void BM_SimulateDriftTarget(Benchmark::State& state)
+{
+	auto system = LoadSolarSystem();
+	const double seconds = Unit::Year;
+	const double targetDrift = 1e-10;
+	const bool adaptive = state.range(0) != 0;
+
+	Simulation::Statistics statistics;
+	Simulation::Settings settings;
+	settings.statistics = &statistics;
+
+	auto run = [&](double dt)
+	{
+		statistics = {};
+		auto burns = CreateBurns(system, 0.0, false);
+		if (adaptive)
+		{
+			auto points = CreatePoints<PointDormandPrince>(system);
+			Simulation::Simulate(points, burns, dt, seconds, 0.0, TestBodies::TrajectoryPointCount, settings);
+		}
+		else
+		{
+			auto points = CreatePoints<PointRungeKutta>(system);
+			Simulation::Simulate(points, burns, dt, seconds, 0.0, TestBodies::TrajectoryPointCount, settings);
+		}
+		return !statistics.failed && statistics.energyDrift <= targetDrift;
+	};
+
+	double dt = Unit::Day;
+	settings.adaptive.relativeTolerance = 1e-6;
+	for (int32_t i = 0; i < 16 && !run(dt); i++)
+	{
+		if (adaptive)
+			settings.adaptive.relativeTolerance *= 0.1;
+		else
+			dt *= 0.5;
+	}
+
+	for (auto _ : state)
+	{
+		if (adaptive)
+			Simulate<PointDormandPrince>(state, system, dt, seconds, settings);
+		else
+			Simulate<PointRungeKutta>(state, system, dt, seconds, settings);
+	}
+
+	SetStatistics(state, statistics);
+	state.counters["rejectedSteps"] = (double)statistics.rejectedSteps;
+	if (adaptive)
+		state.counters["tolerance"] = settings.adaptive.relativeTolerance;
+	else
+		state.counters["dtHours"] = dt / Unit::Hour;
+}
+BENCHMARK(BM_SimulateDriftTarget)->Arg(0)->Arg(1)->ArgNames({ "adaptive" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// Leapfrog with block time steps on the bundled solar system for 10 years, args: max level (0 is shared step).
+// Shared step run once before measurement is the reference of counters evaluationsSaved (fraction of body
+// accelerations) and speedup.
+void BM_SimulateBlockTimesteps(Benchmark::State& state)
+{
+	auto system = LoadSolarSystem();
+	const double seconds = 10.0 * Unit::Year;
+
+	Simulation::Statistics statistics;
+	Simulation::Settings settings;
+	settings.statistics = &statistics;
+	settings.symplectic = Simulation::SymplecticScheme::Leapfrog;
+
+	// dt is the smallest step, the same for all levels
+	auto run = [&]()
+	{
+		statistics = {};
+		auto points = CreatePoints<PointLeapfrog>(system);
+		auto burns = CreateBurns(system, 0.0, false);
+		auto start = std::chrono::steady_clock::now();
+		Simulation::Simulate(points, burns, SimulationDt, seconds, 0.0, TestBodies::TrajectoryPointCount, settings);
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	settings.blockTimesteps.maxLevel = 0;
+	const double sharedSeconds = run();
+	const double sharedAccelerations = (double)statistics.accelerations;
+
+	settings.blockTimesteps.maxLevel = (int32_t)state.range(0);
+	double totalSeconds = 0.0;
+	for (auto _ : state)
+	{
+		auto start = std::chrono::steady_clock::now();
+		Simulate<PointLeapfrog>(state, system, SimulationDt, seconds, settings);
+		totalSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	SetStatistics(state, statistics);
+	state.counters["evaluationsSaved"] = 1.0 - (double)statistics.accelerations / sharedAccelerations;
+	state.counters["speedup"] = sharedSeconds / (totalSeconds / (double)state.iterations());
+}
+BENCHMARK(BM_SimulateBlockTimesteps)->Arg(0)->Arg(3)->Arg(6)->ArgNames({ "maxLevel" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// Symplectic schemes at equal energy drift, step of each scheme is halved from a week until drift of one
+// year is below 1e-13 (search is not measured), so measured time is cost of simulated year at the same
+// accuracy. Weekly trajectory points keep steps from being clamped to them. Args: Simulation::SymplecticScheme,
+// counter dtHours is the step found.
+void BM_SimulateSymplectic(Benchmark::State& state)
+{
+	auto system = CreateSystem(16);
+	const double seconds = Unit::Year;
+	const double targetDrift = 1e-13;
+
+	const int32_t trajectoryPointCount = TestBodies::TrajectoryPointCount;
+	TestBodies::TrajectoryPointCount = 52;
+
+	Simulation::Statistics statistics;
+	Simulation::Settings settings;
+	settings.statistics = &statistics;
+	settings.symplectic = (Simulation::SymplecticScheme)state.range(0);
+	settings.blockTimesteps.maxLevel = 0;
+
+	double dt = 7.0 * Unit::Day;
+	for (int32_t i = 0; i < 12; i++, dt *= 0.5)
+	{
+		statistics = {};
+		auto points = CreatePoints<PointLeapfrog>(system);
+		Simulation::Simulate(points, CreateBurns(system, 0.0, false), dt, seconds, 0.0, TestBodies::TrajectoryPointCount, settings);
+		if (statistics.energyDrift <= targetDrift)
+			break;
+	}
+
+	for (auto _ : state)
+		Simulate<PointLeapfrog>(state, system, dt, seconds, settings);
+
+	TestBodies::TrajectoryPointCount = trajectoryPointCount;
+
+	SetStatistics(state, statistics);
+	state.counters["dtHours"] = dt / Unit::Hour;
+	state.counters["accelerationsPerYear"] = (double)statistics.accelerations / (seconds / Unit::Year);
+}
+BENCHMARK(BM_SimulateSymplectic)->Arg(0)->Arg(1)->Arg(2)->ArgNames({ "scheme" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// Moon around planet 30 AU from origin for 100 years, yoshida 6 with 1 hour step, so rounding of
+// small increments of large positions dominates the error. Args: Simulation::Precision.
+// Counter error is distance of the moon from the exact two body solution relative to its orbit.
+void BM_SimulatePrecision(Benchmark::State& state)
+{
+	SystemLoader::SetupSolarSystemUnits();
+
+	const double seconds = 100.0 * Unit::Year;
+	const double planetMass = 1e-3;
+	const double moonMass = 1e-5;
+	const double moonDistance = 0.01;
+
+	const vec2d planetPosition = { 30.0, 0.0 };
+	const vec2d planetVelocity = { 0.0, 1.1 };
+	// eccentric orbit relative to planet
+	const vec2d moonOffset = { 0.0, moonDistance };
+	const vec2d moonVelocity = vec2d{ -1.1 * std::sqrt(GravitationalConstant * (planetMass + moonMass) / moonDistance), 0.0 };
+
+	Simulation::Statistics statistics;
+	Simulation::Settings settings;
+	settings.statistics = &statistics;
+	settings.symplectic = Simulation::SymplecticScheme::Yoshida6;
+	settings.precision = (Simulation::Precision)state.range(0);
+
+	double error = 0.0;
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		// center of mass moves with planetVelocity, moon moves with moonVelocity relative to planet
+		const double moonFraction = moonMass / (planetMass + moonMass);
+		std::vector<PointLeapfrog> points = {
+			PointLeapfrog(planetPosition, planetVelocity - moonVelocity * moonFraction, planetMass),
+			PointLeapfrog(planetPosition + moonOffset, planetVelocity + moonVelocity * (1.0 - moonFraction), moonMass)
+		};
+		std::vector<std::vector<BurnPtr>> burns(points.size());
+		statistics = {};
+		state.ResumeTiming();
+
+		auto trajectories = Simulation::Simulate(points, burns, SimulationDt, seconds, 0.0, TestBodies::TrajectoryPointCount, settings);
+		DoNotOptimize(trajectories);
+
+		state.PauseTiming();
+		auto elements = Orbit::FromState(GravitationalConstant * (planetMass + moonMass), moonOffset, moonVelocity);
+		vec2d position, velocity;
+		Orbit::ToState(Orbit::Propagate(elements, seconds), position, velocity);
+		error = ((points[1].position - points[0].position) - position).length() / moonDistance;
+		state.ResumeTiming();
+	}
+
+	SetStatistics(state, statistics);
+	state.counters["error"] = error;
+}
+BENCHMARK(BM_SimulatePrecision)->Arg(0)->Arg(1)->ArgNames({ "precision" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// accelerations of all bodies, args: Gravity::Method, number of bodies
+void BM_Gravity(Benchmark::State& state)
+{
+	std::vector<vec2d> positions;
+	std::vector<double> masses;
+	CreateCloud((size_t)state.range(1), positions, masses);
+	std::vector<vec2d> accelerations(positions.size());
+
+	GravitationalConstant = 1.0;
+
+	Gravity::Settings settings;
+	settings.method = (Gravity::Method)state.range(0);
+	Gravity::Solver solver;
+
+	for (auto _ : state)
+	{
+		solver.Compute(settings, positions, masses, accelerations);
+		DoNotOptimize(accelerations.data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_Gravity)
+	->Args({ 0, 256 })->Args({ 0, 2048 })->Args({ 0, 8192 })
+	->Args({ 1, 10 })->Args({ 1, 100 })->Args({ 1, 1000 })->Args({ 1, 10000 })->Args({ 1, 100000 })
+	->Args({ 2, 256 })->Args({ 2, 2048 })->Args({ 2, 8192 })
+	->Args({ 3, 256 })->Args({ 3, 2048 })->Args({ 3, 8192 })
+	->ArgNames({ "method", "bodies" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// Exact sums on the bundled solar system and on random cluster of the same size, args: Gravity::Method
+// (Direct or Symmetric), system (0 solar system, 1 cluster). Counter pairs is number of evaluated pair
+// forces per call, symmetric sum evaluates each pair once instead of twice.
+void BM_GravitySystem(Benchmark::State& state)
+{
+	auto system = LoadSolarSystem();
+
+	std::vector<vec2d> positions;
+	std::vector<double> masses;
+	if (state.range(1))
+	{
+		CreateCloud(system.size(), positions, masses);
+	}
+	else
+	{
+		for (const auto& body : system)
+		{
+			positions.push_back(body.position);
+			masses.push_back(body.mass);
+		}
+	}
+	std::vector<vec2d> accelerations(positions.size());
+
+	Gravity::Settings settings;
+	settings.method = (Gravity::Method)state.range(0);
+	Gravity::Solver solver;
+
+	for (auto _ : state)
+	{
+		solver.Compute(settings, positions, masses, accelerations);
+		DoNotOptimize(accelerations.data());
+	}
+
+	const double count = (double)positions.size();
+	state.counters["pairs"] = settings.method == Gravity::Method::Symmetric ? count * (count - 1.0) * 0.5 : count * (count - 1.0);
+	state.SetItemsProcessed(state.iterations() * (int64_t)positions.size());
+}
+BENCHMARK(BM_GravitySystem)->Args({ 0, 0 })->Args({ 3, 0 })->Args({ 0, 1 })->Args({ 3, 1 })->ArgNames({ "method", "cluster" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// reference for BM_Gravity, per pair force of PointRungeKutta used before Gravity::Solver, args: number of bodies
+void BM_GravityAttractForceTemp(Benchmark::State& state)
+{
+	std::vector<vec2d> positions;
+	std::vector<double> masses;
+	CreateCloud((size_t)state.range(0), positions, masses);
+
+	GravitationalConstant = 1.0;
+
+	std::vector<PointRungeKutta> points;
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		points.emplace_back(positions[i], vec2d{}, masses[i]);
+		points.back().positionTemp = positions[i];
+	}
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < points.size(); i++)
+			DoNotOptimize(points[i].computeAccelerationTemp(points, i));
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GravityAttractForceTemp)->Arg(256)->Arg(2048)->ArgNames({ "bodies" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// RK4 simulation of system with direct sum on thread pool, a few steps keep 10k bodies short, args: threads, number of bodies
+void BM_SimulateThreads(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(1));
+	const double seconds = 8.0 * SimulationDt;
+
+	Simulation::Settings settings;
+	settings.gravity.threads = (size_t)state.range(0);
+
+	for (auto _ : state)
+		Simulate<PointRungeKutta>(state, system, SimulationDt, seconds, settings);
+
+	state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_SimulateThreads)->Args({ 1, 1000 })->Args({ 2, 1000 })->Args({ 4, 1000 })->Args({ 8, 1000 })
+	->Args({ 1, 10000 })->Args({ 2, 10000 })->Args({ 4, 10000 })->Args({ 8, 10000 })->ArgNames({ "threads", "bodies" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// args: number of bodies
+void BM_ComputeParents(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(0));
+
+	Bodies bodies;
+	AddBodies(bodies, system);
+
+	// trajectories only need to exist, shorter approximated simulation keeps setup of large systems fast
+	Simulation::Settings settings;
+	settings.gravity.method = Gravity::Method::BarnesHut;
+	SimulationBodies<PointRungeKutta> simulation(bodies.bodies, settings);
+	simulation.SimulateClear(0.1 * Unit::Year);
+
+	for (auto _ : state)
+	{
+		auto parents = simulation.ComputeParents();
+		DoNotOptimize(parents);
+	}
+}
+BENCHMARK(BM_ComputeParents)->Arg(16)->Arg(64)->Arg(1000)->ArgNames({ "bodies" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// Edit of planet velocity like dragging of its handle, args: number of bodies. Time is the frame of edit
+// (RK4), the other integrators follow in next frames, counter nextFrameMs is the longest of them (mean over edits).
+void BM_Resimulate(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(0));
+
+	Bodies bodies;
+	AddBodies(bodies, system);
+	bodies.SimulateClear(Unit::Month);
+
+	const size_t edited = 1;
+	auto& body = bodies.bodies[edited];
+	const vec2d initialVelocity = body.initialVelocity;
+	bool faster = true;
+	double nextFrameSeconds = 0.0;
+
+	for (auto _ : state)
+	{
+		body.SetInitialState(body.initialPosition, initialVelocity * (faster ? 1.001 : 1.0), body.mass);
+		faster = !faster;
+
+		bodies.Resimulate(edited);
+
+		state.PauseTiming();
+		double longest = 0.0;
+		while (bodies.pendingResimulation)
+		{
+			auto start = std::chrono::steady_clock::now();
+			bodies.UpdateSimulation();
+			longest = std::max(longest, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		nextFrameSeconds += longest;
+		state.ResumeTiming();
+	}
+
+	state.counters["nextFrameMs"] = nextFrameSeconds / (double)state.iterations() * 1e3;
+}
+BENCHMARK(BM_Resimulate)->Arg(64)->Arg(500)->ArgNames({ "bodies" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// parent relative trajectories after one point is appended to global ones, args: number of bodies, trajectory points
+void BM_ProcessTrajectoriesParent(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(0));
+
+	Bodies bodies;
+	AddBodies(bodies, system);
+
+	const int32_t trajectoryPointCount = TestBodies::TrajectoryPointCount;
+	TestBodies::TrajectoryPointCount = (int32_t)state.range(1);
+	bodies.SimulateClear(Unit::Year);
+	TestBodies::TrajectoryPointCount = trajectoryPointCount;
+
+	SimulationBodies<PointRungeKutta> simulation(bodies.bodies);
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		for (auto& body : bodies.bodies)
+		{
+			auto& trajectory = body.GetSimulation<PointRungeKutta>().trajectoryGlobal;
+			trajectory.positions.push_back(trajectory.positions.back());
+			trajectory.velocities.push_back(trajectory.velocities.back());
+			trajectory.times.push_back(trajectory.times.back() + 1.0f);
+		}
+		state.ResumeTiming();
+
+		simulation.ProcessTrajectoriesParent();
+	}
+}
+BENCHMARK(BM_ProcessTrajectoriesParent)->Args({ 64, 300 })->Args({ 64, 10000 })->ArgNames({ "bodies", "points" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// run of 10 years with daily points of RK4 trajectories written to archive or opened from it,
+// args: number of bodies, read
+void BM_TrajectoryArchive(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(0));
+
+	Bodies bodies, opened;
+	AddBodies(bodies, system);
+	AddBodies(opened, system);
+
+	// circular orbits around the origin instead of simulation, only size of data matters
+	const size_t points = 3650;
+	for (auto& body : bodies.bodies)
+	{
+		auto& simulation = body.GetSimulation<PointRungeKutta>();
+		const double angularVelocity = body.initialVelocity.length() / std::max(body.initialPosition.length(), 1e-9);
+		for (size_t i = 0; i < points; i++)
+		{
+			const double time = (double)i * Unit::Day;
+			const vec2 position = (vec2)Utils::RotateVector(body.initialPosition, angularVelocity * time);
+			const vec2 velocity = (vec2)Utils::RotateVector(body.initialVelocity, angularVelocity * time);
+			for (Trajectory* trajectory : { &simulation.trajectoryGlobal, &simulation.trajectoryParent })
+			{
+				trajectory->positions.push_back(position);
+				trajectory->velocities.push_back(velocity);
+				trajectory->times.push_back((float)time);
+			}
+		}
+	}
+	bodies.simulatedTime = (double)(points - 1) * Unit::Day;
+
+	const auto path = std::filesystem::temp_directory_path() / "space-benchmark.spta";
+	bodies.WriteArchive(path);
+
+	for (auto _ : state)
+	{
+		if (state.range(1))
+		{
+			opened.ReadArchive(path);
+			DoNotOptimize(opened.simulatedTime);
+		}
+		else
+		{
+			bodies.WriteArchive(path);
+		}
+	}
+
+	state.counters["MB"] = (double)std::filesystem::file_size(path) / (1024.0 * 1024.0);
+	opened = {};
+	std::filesystem::remove(path);
+}
+BENCHMARK(BM_TrajectoryArchive)->Args({ 1000, 0 })->Args({ 1000, 1 })->ArgNames({ "bodies", "read" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// system read and added to bodies at startup, args: number of bodies, format (0 json document, 1 streaming json, 2 catalog file)
+void BM_ReadSystem(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(0));
+
+	// json in SI units as in assets, in memory like compiled resource
+	std::string text = "{\n";
+	char buffer[256];
+	for (size_t i = 0; i < system.size(); i++)
+	{
+		const auto& body = system[i];
+		std::snprintf(buffer, sizeof(buffer), "\t\"body%zu\": {%s \"position\": { \"x\": %.17g, \"y\": %.17g }, \"velocity\": { \"x\": %.17g, \"y\": %.17g }, \"mass\": %.17g }%s\n",
+			i, i == 0 ? " \"star\": 1," : "", body.position.x() / Unit::Meter, body.position.y() / Unit::Meter, body.velocity.x() / (Unit::Meter / Unit::Second),
+			body.velocity.y() / (Unit::Meter / Unit::Second), body.mass / Unit::Kilogram, i + 1 < system.size() ? "," : "");
+		text += buffer;
+	}
+	text += "}\n";
+
+	const auto path = std::filesystem::temp_directory_path() / "space-benchmark.spsc";
+	SystemLoader::WriteCatalog(path, SystemLoader::ParseEntries(text));
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		auto bodies = std::make_unique<Bodies>();
+		state.ResumeTiming();
+
+		std::vector<SystemLoader::Entry> entries;
+		if (state.range(1) == 0)
+			entries = SystemLoader::GetEntries(nlohmann::json::parse(text));
+		else if (state.range(1) == 1)
+			entries = SystemLoader::ParseEntries(text);
+		else
+			entries = SystemLoader::ReadCatalog(path);
+		SystemLoader::Load(*bodies, entries);
+		DoNotOptimize(bodies->bodies.data());
+
+		state.PauseTiming();
+		bodies.reset();
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(state.iterations() * (int64_t)system.size());
+	std::filesystem::remove(path);
+}
+BENCHMARK(BM_ReadSystem)->Args({ 1000, 0 })->Args({ 1000, 1 })->Args({ 1000, 2 })->Args({ 100000, 0 })->Args({ 100000, 1 })->Args({ 100000, 2 })
+	->Args({ 1000000, 0 })->Args({ 1000000, 1 })->Args({ 1000000, 2 })->ArgNames({ "bodies", "format" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// catalog ingestion into empty bodies, args: number of bodies, bulk (0 AddBody for each body, 1 AddBodies)
+void BM_AddBodies(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(0));
+
+	std::vector<Bodies::BodyDesc> descs;
+	for (const auto& body : system)
+		descs.push_back({ "body", body.position, body.velocity, body.mass });
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		auto bodies = std::make_unique<Bodies>();
+		state.ResumeTiming();
+
+		if (state.range(1))
+		{
+			bodies->AddBodies(descs);
+		}
+		else
+		{
+			for (const auto& desc : descs)
+				bodies->AddBody(desc.name.data(), desc.position, desc.velocity, desc.mass);
+		}
+		DoNotOptimize(bodies->bodies.data());
+
+		state.PauseTiming();
+		bodies.reset();
+		state.ResumeTiming();
+	}
+
+	state.SetItemsProcessed(state.iterations() * (int64_t)system.size());
+}
+BENCHMARK(BM_AddBodies)->Args({ 1000, 0 })->Args({ 1000, 1 })->Args({ 100000, 0 })->Args({ 100000, 1 })->ArgNames({ "bodies", "bulk" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// simulated year resumed from checkpoints file (space-cli --resume) at given month, args: number of bodies, month
+void BM_ResimulateFromCheckpoint(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(0));
+	const auto path = std::filesystem::temp_directory_path() / "space-benchmark.spck";
+
+	Bodies bodies;
+	AddBodies(bodies, system);
+
+	Simulation::Checkpoints checkpoints;
+	checkpoints.interval = Unit::Month;
+	auto settings = bodies.settings;
+	settings.checkpoints = &checkpoints;
+
+	SimulationBodies<PointRungeKutta>(bodies.bodies, settings).SimulateClear(Unit::Year);
+	checkpoints.rungeKutta.Write(path);
+
+	for (auto _ : state)
+	{
+		if (!checkpoints.rungeKutta.Read(path))
+			state.SkipWithError("cannot read checkpoints");
+		SimulationBodies<PointRungeKutta>(bodies.bodies, settings).SimulateFromCheckpoint((double)state.range(1) * Unit::Month, Unit::Year);
+		DoNotOptimize(bodies.bodies.data());
+	}
+
+	std::filesystem::remove(path);
+}
+BENCHMARK(BM_ResimulateFromCheckpoint)->Args({ 64, 0 })->Args({ 64, 9 })->ArgNames({ "bodies", "month" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// main thread work of one frame while background worker extends trajectories, args: number of bodies
+void BM_SimulateExtendAsyncFrame(Benchmark::State& state)
+{
+	auto system = CreateSystem((size_t)state.range(0));
+
+	Bodies bodies;
+	AddBodies(bodies, system);
+
+	for (auto _ : state)
+	{
+		if (!bodies.IsSimulating())
+			bodies.SimulateClearAsync(Unit::Year);
+
+		bodies.UpdateSimulation();
+		DoNotOptimize(bodies.simulatedTime);
+	}
+
+	bodies.CancelSimulation();
+}
+BENCHMARK(BM_SimulateExtendAsyncFrame)->Arg(64)->Arg(500)->ArgNames({ "bodies" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// noisy points of ellipse, args: number of points
+void BM_ApproximateConic(Benchmark::State& state)
+{
+	Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+	std::vector<vec2d> positions((size_t)state.range(0));
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		double angle = 2.0 * Utils::Pi * (double)i / (double)positions.size();
+		vec2d noise = (vec2d)Utils::GetRandomPosition(-1e-3f, 1e-3f, -1e-3f, 1e-3f);
+		positions[i] = Utils::RotateVector(vec2d{ 3.0 * std::cos(angle) + 1.0, 2.0 * std::sin(angle) }, 0.3) + noise;
+	}
+
+	for (auto _ : state)
+	{
+		auto conic = ConicApproximation::ApproximateConic(positions);
+		DoNotOptimize(conic);
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ApproximateConic)->Arg(300)->Arg(4096)->ArgNames({ "points" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// scatter matrix and eigen solve of ellipse fit alone, args: number of points
+template<class T>
+void BM_ConicFit(Benchmark::State& state)
+{
+	Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+	std::vector<T> pointsX((size_t)state.range(0)), pointsY((size_t)state.range(0));
+	for (size_t i = 0; i < pointsX.size(); i++)
+	{
+		double angle = 2.0 * Utils::Pi * (double)i / (double)pointsX.size();
+		vec2d noise = (vec2d)Utils::GetRandomPosition(-1e-3f, 1e-3f, -1e-3f, 1e-3f);
+		vec2d position = Utils::RotateVector(vec2d{ 3.0 * std::cos(angle) + 1.0, 2.0 * std::sin(angle) }, 0.3) + noise;
+		pointsX[i] = (T)position.x();
+		pointsY[i] = (T)position.y();
+	}
+
+	using Fitter = ConicFit::LeastSquareEllipseFitter<T>;
+	typename Fitter::PointAccessorFromTwoVectors accessor(pointsX, pointsY);
+
+	for (auto _ : state)
+	{
+		auto parameters = Fitter::Fit(accessor);
+		DoNotOptimize(parameters);
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_ConicFit, float)->Arg(300)->Arg(4096)->Arg(100000)->ArgNames({ "points" })->Unit(Benchmark::TimeUnit::Microsecond);
+BENCHMARK_TEMPLATE(BM_ConicFit, double)->Arg(300)->Arg(4096)->Arg(100000)->ArgNames({ "points" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// random bound and unbound orbits (unit gravitational parameter) propagated to states, args: number of orbits
+void BM_OrbitGetStates(Benchmark::State& state)
+{
+	Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+	const size_t count = (size_t)state.range(0);
+	std::vector<Orbit::Elements> elements(count);
+	for (auto& orbit : elements)
+	{
+		vec2d position = (vec2d)Utils::GetRandomPosition(-2.0f, 2.0f, -2.0f, 2.0f);
+		vec2d velocity = (vec2d)Utils::GetRandomPosition(-1.0f, 1.0f, -1.0f, 1.0f);
+		orbit = Orbit::FromState(1.0, position, velocity);
+	}
+
+	std::vector<vec2d> positions(count), velocities(count);
+	double time = 0.0;
+
+	for (auto _ : state)
+	{
+		Orbit::GetStates(elements, time, positions, velocities);
+		DoNotOptimize(positions.data());
+		time += 0.1;
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OrbitGetStates)->Arg(1000)->Arg(100000)->ArgNames({ "orbits" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// kepler equation of elliptic orbits, args: number of orbits, batch (1) or one by one (0)
+void BM_SolveKeplerElliptic(Benchmark::State& state)
+{
+	Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+	const size_t count = (size_t)state.range(0);
+	std::vector<double> meanAnomaly(count), eccentricity(count), eccentricAnomaly(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		vec2 random = Utils::GetRandomPosition(-10.0f, 10.0f, 0.0f, 0.99f);
+		meanAnomaly[i] = random.x();
+		eccentricity[i] = random.y();
+	}
+
+	for (auto _ : state)
+	{
+		if (state.range(1))
+		{
+			Orbit::SolveKeplerElliptic(meanAnomaly, eccentricity, eccentricAnomaly);
+		}
+		else
+		{
+			for (size_t i = 0; i < count; i++)
+				eccentricAnomaly[i] = Orbit::SolveKeplerElliptic(meanAnomaly[i], eccentricity[i]);
+		}
+		DoNotOptimize(eccentricAnomaly.data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SolveKeplerElliptic)->Args({ 10000, 0 })->Args({ 10000, 1 })->ArgNames({ "orbits", "batch" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// trajectory of ship among grid of mass points like in TestMassPoint, args: mass points, burns, patched conics (1) or verlet (0)
+void BM_PredictShip(Benchmark::State& state)
+{
+	const size_t count = (size_t)state.range(0);
+	const size_t side = (size_t)std::ceil(std::sqrt((double)count));
+	const double seconds = 100.0;
+	const int32_t numPoints = 300;
+
+	std::vector<MassPoint> massPoints(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		massPoints[i].position = { 100.0 * (double)(i % side), 100.0 * (double)(i / side) };
+		massPoints[i].recomputeEffectiveRadius();
+	}
+
+	// the first one circularizes orbit around the first mass point, the others are small corrections
+	std::vector<BurnPtr> burns;
+	const size_t burnCount = (size_t)state.range(1);
+	for (size_t i = 0; i < burnCount; i++)
+	{
+		const double time = seconds * (double)i / (double)burnCount;
+		const vec2d velocity = i == 0 ? vec2d{ -std::sqrt(GravitationalConstant), 0.0 } : vec2d{ 0.001 * std::cos(time), 0.001 * std::sin(time) };
+		burns.push_back(std::make_unique<Burn>(Burn{ time, velocity, {} }));
+	}
+
+	for (auto _ : state)
+	{
+		if (state.range(2))
+		{
+			auto trajectory = PatchedConics::Predict({ 0.0, 1.0 }, {}, massPoints, burns, seconds, numPoints);
+			DoNotOptimize(trajectory);
+		}
+		else
+		{
+			PointVerlet point({ 0.0, 1.0 });
+			auto trajectory = Simulation::Simulate(point, massPoints, burns, SimulationDt, seconds, numPoints);
+			DoNotOptimize(trajectory);
+		}
+	}
+}
+BENCHMARK(BM_PredictShip)->Args({ 16, 16, 0 })->Args({ 16, 16, 1 })->Args({ 256, 256, 0 })->Args({ 256, 256, 1 })->Args({ 10000, 256, 0 })->Args({ 10000, 256, 1 })
+	->ArgNames({ "massPoints", "burns", "conics" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// trajectories of ships (predicted, euler and verlet) like in TestMassPoint::Simulate, args: threads, ships
+void BM_PredictShips(Benchmark::State& state)
+{
+	Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+	const double seconds = 10.0;
+	const int32_t numPoints = 300;
+	const size_t tasks = 3;
+
+	std::vector<MassPoint> massPoints(20);
+	for (auto& massPoint : massPoints)
+	{
+		massPoint.position = (vec2d)Utils::GetRandomPosition(-50.0f, 50.0f, -30.0f, 30.0f);
+		massPoint.recomputeEffectiveRadius();
+	}
+
+	struct Ship
+	{
+		vec2d initialPosition;
+		std::vector<BurnPtr> burns;
+		std::array<Trajectory, 3> trajectories;
+	};
+	std::vector<Ship> ships((size_t)state.range(1));
+	for (auto& ship : ships)
+	{
+		ship.initialPosition = (vec2d)Utils::GetRandomPosition(-50.0f, 50.0f, -30.0f, 30.0f);
+		for (double time = 0.0; time < seconds; time += 2.5)
+			ship.burns.push_back(std::make_unique<Burn>(Burn{ time, (vec2d)Utils::GetRandomPosition(-1.0f, 1.0f, -1.0f, 1.0f), {} }));
+	}
+
+	ThreadPool pool((size_t)state.range(0));
+
+	for (auto _ : state)
+	{
+		MassPointGrid grid;
+		grid.Build(massPoints);
+
+		pool.ParallelFor(ships.size() * tasks, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				Ship& ship = ships[i / tasks];
+				Trajectory& trajectory = ship.trajectories[i % tasks];
+				if (i % tasks == 0)
+				{
+					PatchedConics::Predict(ship.initialPosition, {}, massPoints, grid, ship.burns, seconds, numPoints, trajectory);
+				}
+				else if (i % tasks == 1)
+				{
+					PointEuler point(ship.initialPosition);
+					Simulation::Simulate(point, grid, ship.burns, SimulationDt, seconds, numPoints, trajectory);
+				}
+				else
+				{
+					PointVerlet point(ship.initialPosition);
+					Simulation::Simulate(point, grid, ship.burns, SimulationDt, seconds, numPoints, trajectory);
+				}
+			}
+		});
+		DoNotOptimize(ships.back().trajectories);
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_PredictShips)->Args({ 1, 16 })->Args({ 1, 256 })->Args({ 2, 256 })->Args({ 4, 256 })->Args({ 8, 256 })
+	->ArgNames({ "threads", "ships" })->Unit(Benchmark::TimeUnit::Millisecond);
+
+// acceleration at random positions among randomly placed mass points, args: mass points, all of them (0) or culled by grid (1)
+void BM_MassPointAcceleration(Benchmark::State& state)
+{
+	Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+	const size_t count = (size_t)state.range(0);
+	// about the same density for all counts, spheres of influence overlap a little
+	const float size = 50.0f * std::sqrt((float)count);
+
+	std::vector<MassPoint> massPoints(count);
+	for (auto& massPoint : massPoints)
+	{
+		massPoint.position = (vec2d)Utils::GetRandomPosition(0.0f, size, 0.0f, size);
+		massPoint.recomputeEffectiveRadius();
+	}
+
+	std::vector<PointEuler> queries(1024);
+	for (auto& query : queries)
+		query.position = (vec2d)Utils::GetRandomPosition(0.0f, size, 0.0f, size);
+
+	MassPointGrid grid;
+	grid.Build(massPoints);
+
+	for (auto _ : state)
+	{
+		for (auto& query : queries)
+		{
+			if (state.range(1))
+				query.prepareStep(grid, 0.0f);
+			else
+				query.prepareStep(massPoints, 0.0f);
+			DoNotOptimize(query.acceleration);
+		}
+	}
+
+	state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_MassPointAcceleration)->Args({ 16, 0 })->Args({ 16, 1 })->Args({ 1000, 0 })->Args({ 1000, 1 })->Args({ 10000, 0 })->Args({ 10000, 1 })
+	->ArgNames({ "massPoints", "grid" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// building of the grid, it is built for each simulated trajectory of ship
+void BM_MassPointGridBuild(Benchmark::State& state)
+{
+	Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+	const size_t count = (size_t)state.range(0);
+	const float size = 50.0f * std::sqrt((float)count);
+
+	std::vector<MassPoint> massPoints(count);
+	for (auto& massPoint : massPoints)
+	{
+		massPoint.position = (vec2d)Utils::GetRandomPosition(0.0f, size, 0.0f, size);
+		massPoint.recomputeEffectiveRadius();
+	}
+
+	MassPointGrid grid;
+	for (auto _ : state)
+	{
+		grid.Build(massPoints);
+		DoNotOptimize(grid.GetEntryCount());
+	}
+
+	state.counters["entries"] = (double)grid.GetEntryCount();
+}
+BENCHMARK(BM_MassPointGridBuild)->Arg(16)->Arg(1000)->Arg(10000)->ArgNames({ "massPoints" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+static Trajectory CreateLinearTrajectory(size_t count)
+{
+	Trajectory trajectory;
+	for (size_t i = 0; i < count; i++)
+	{
+		trajectory.positions.push_back({ (float)i, 0.0f });
+		trajectory.velocities.push_back({ 1.0f, 0.0f });
+		trajectory.times.push_back((float)i);
+	}
+	return trajectory;
+}
+
+static std::vector<double> CreateRandomTimes(size_t count)
+{
+	std::vector<double> times(1000);
+	for (auto& time : times)
+		time = Utils::GetRandomPosition(0.0f, (float)count, 0.0f, 0.0f).x();
+	return times;
+}
+
+// 1000 random lookups, args: number of trajectory points
+void BM_TrajectoryGetPoint(Benchmark::State& state)
+{
+	Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+	const size_t count = (size_t)state.range(0);
+	Trajectory trajectory = CreateLinearTrajectory(count);
+	std::vector<double> times = CreateRandomTimes(count);
+
+	for (auto _ : state)
+	{
+		for (double time : times)
+			DoNotOptimize(trajectory.getPoint(time));
+	}
+
+	state.SetItemsProcessed(state.iterations() * (int64_t)times.size());
+}
+BENCHMARK(BM_TrajectoryGetPoint)->Arg(1000)->Arg(100000)->Arg(10000000)->ArgNames({ "points" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// 1000 lookups advancing by a fraction of point like playback does, args: number of trajectory points
+void BM_TrajectoryGetPointPlayback(Benchmark::State& state)
+{
+	const size_t count = (size_t)state.range(0);
+	Trajectory trajectory = CreateLinearTrajectory(count);
+
+	std::vector<double> times(1000);
+	for (size_t i = 0; i < times.size(); i++)
+		times[i] = (double)count * 0.5 + (double)i * 0.3;
+
+	for (auto _ : state)
+	{
+		for (double time : times)
+			DoNotOptimize(trajectory.getPoint(time));
+	}
+
+	state.SetItemsProcessed(state.iterations() * (int64_t)times.size());
+}
+BENCHMARK(BM_TrajectoryGetPointPlayback)->Arg(1000)->Arg(100000)->Arg(10000000)->ArgNames({ "points" })->Unit(Benchmark::TimeUnit::Microsecond);
+
+// 1000 random interpolated samples, args: number of trajectory points
+void BM_TrajectoryGetState(Benchmark::State& state)
+{
+	Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+	const size_t count = (size_t)state.range(0);
+	Trajectory trajectory = CreateLinearTrajectory(count);
+	std::vector<double> times = CreateRandomTimes(count);
+
+	for (auto _ : state)
+	{
+		for (double time : times)
+			DoNotOptimize(trajectory.getState(time));
+	}
+
+	state.SetItemsProcessed(state.iterations() * (int64_t)times.size());
+}
+BENCHMARK(BM_TrajectoryGetState)->Arg(1000)->Arg(100000)->Arg(10000000)->ArgNames({ "points" })->Unit(Benchmark::TimeUnit::Microsecond);
@@ -0,0 +1,104 @@
+#include "spaceFixtures.h"
+#include "../space/systemLoader.h"
+#include "../space/utils.h"
+#include <cmath>
+
+using namespace Magnum2D;
+
+extern double GravitationalConstant;
+
+namespace SpaceFixtures
+{
+	std::vector<SystemBody> CreateSystem(size_t count)
+	{
+		SystemLoader::SetupSolarSystemUnits();
+		Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+
+		std::vector<SystemBody> result;
+		result.push_back({ { 0.0, 0.0 }, { 0.0, 0.0 }, 1.0, true });
+
+		auto circularVelocity = [](const vec2d& offset, double centralMass)
+		{
+			vec2d direction = vec2d(-offset.y(), offset.x()).normalized();
+			return direction * std::sqrt(GravitationalConstant * centralMass / offset.length());
+		};
+
+		for (size_t planet = 0; result.size() < count; planet++)
+		{
+			vec2 random = Utils::GetRandomPosition(0.0f, 1.0f, 0.0f, 1.0f);
+			double radius = 0.4 + 30.0 * random.x();
+			double angle = 2.0 * Utils::Pi * random.y();
+			double mass = 1e-6 * std::pow(1000.0, Utils::GetRandomPosition(0.0f, 1.0f, 0.0f, 1.0f).x());
+
+			vec2d position = Utils::RotateVector(vec2d{ radius, 0.0 }, angle);
+			vec2d velocity = circularVelocity(position, 1.0);
+			result.push_back({ position, velocity, mass });
+
+			if (planet % 3 == 0 && result.size() < count)
+			{
+				// well inside of Hill sphere
+				double distance = 0.2 * radius * std::cbrt(mass / 3.0);
+				vec2d offset = Utils::RotateVector(vec2d{ distance, 0.0 }, angle * 7.0);
+				result.push_back({ position + offset, velocity + circularVelocity(offset, mass), mass * 0.01 });
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<SystemBody> LoadSolarSystem()
+	{
+		SystemLoader::SetupSolarSystemUnits();
+
+		std::vector<SystemBody> result;
+		for (const auto& entry : SystemLoader::Read(SPACE_ASSETS_DIR "/solar_system.json"))
+			result.push_back({ entry.position * Unit::Meter, entry.velocity * Unit::Meter / Unit::Second, entry.mass * Unit::Kilogram, entry.star });
+
+		return result;
+	}
+
+	void CreateCloud(size_t count, std::vector<vec2d>& positions, std::vector<double>& masses)
+	{
+		Utils::SetRandomSeed(Utils::DefaultRandomSeed);
+		positions.resize(count);
+		masses.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			positions[i] = (vec2d)Utils::GetRandomPosition(-100.0f, 100.0f, -100.0f, 100.0f);
+			masses[i] = 1.0 + Utils::GetRandomPosition(0.0f, 1.0f, 0.0f, 1.0f).x();
+		}
+	}
+
+	std::vector<std::vector<BurnPtr>> CreateBurns(const std::vector<SystemBody>& system, double time, bool enabled)
+	{
+		std::vector<std::vector<BurnPtr>> burns(system.size());
+		if (!enabled)
+			return burns;
+
+		for (size_t i = 0; i < system.size(); i++)
+		{
+			if (!system[i].star)
+				burns[i].push_back(std::make_unique<Burn>(Burn{ time, system[i].velocity * 0.01, {} }));
+		}
+
+		return burns;
+	}
+
+	void AddBodies(Bodies& bodies, const std::vector<SystemBody>& system)
+	{
+		std::vector<Bodies::BodyDesc> descs;
+		descs.reserve(system.size());
+		for (const auto& body : system)
+			descs.push_back({ "body", body.position, body.velocity, body.mass, body.star });
+
+		bodies.AddBodies(descs);
+	}
+
+	void SetStatistics(Benchmark::State& state, const Simulation::Statistics& statistics)
+	{
+		state.counters["steps"] = (double)statistics.steps;
+		state.counters["accelerations"] = (double)statistics.accelerations;
+		state.counters["energyDrift"] = statistics.energyDrift;
+		state.counters["angularMomentumDrift"] = statistics.angularMomentumDrift;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "benchmark.h"
+#include "../space/bodies.h"
+#include "../space/simulation.h"
+#include <vector>
+
+// Systems and setup shared by space benchmarks. Setup done inside of benchmark loop by these
+// helpers is excluded from measured time.
+namespace SpaceFixtures
+{
+	struct SystemBody
+	{
+		Magnum2D::vec2d position;
+		Magnum2D::vec2d velocity;
+		double mass;
+		bool star = false;
+	};
+
+	// Star with planets on circular orbits, every third planet has a moon. Same for every run,
+	// random values come from generator with fixed seed.
+	std::vector<SystemBody> CreateSystem(size_t count);
+	// bundled assets/solar_system.json, sets solar system units
+	std::vector<SystemBody> LoadSolarSystem();
+	// random cloud of bodies for force evaluation benchmarks
+	void CreateCloud(size_t count, std::vector<Magnum2D::vec2d>& positions, std::vector<double>& masses);
+
+	template<class T>
+	std::vector<T> CreatePoints(const std::vector<SystemBody>& system)
+	{
+		std::vector<T> points;
+		points.reserve(system.size());
+		for (const auto& body : system)
+			points.emplace_back(body.position, body.velocity, body.mass);
+		return points;
+	}
+
+	// one small prograde burn of every body (except the star) at given time
+	std::vector<std::vector<BurnPtr>> CreateBurns(const std::vector<SystemBody>& system, double time, bool enabled);
+
+	void AddBodies(Bodies& bodies, const std::vector<SystemBody>& system);
+
+	// Simulation of system from its initial state, returns final points. Points, burns (in the middle
+	// of simulation) and reset of statistics are prepared with paused timing.
+	template<class T>
+	std::vector<T> Simulate(Benchmark::State& state, const std::vector<SystemBody>& system, double dt, double seconds, const Simulation::Settings& settings, bool burns = false)
+	{
+		state.PauseTiming();
+		auto points = CreatePoints<T>(system);
+		auto systemBurns = CreateBurns(system, seconds * 0.5, burns);
+		if (settings.statistics)
+			*settings.statistics = {};
+		state.ResumeTiming();
+
+		auto trajectories = Simulation::Simulate(points, systemBurns, dt, seconds, 0.0, TestBodies::TrajectoryPointCount, settings);
+		DoNotOptimize(trajectories);
+
+		return points;
+	}
+
+	// steps, accelerations and drifts of simulation
+	void SetStatistics(Benchmark::State& state, const Simulation::Statistics& statistics);
+}
@@ -85,109 +85,3 @@ void Application::DrawHang()
 
 	Magnum2D::drawRectangle(rope.nodes.back().position, angle, 2.0f, 2.0f, Magnum2D::rgb(34, 50, 97));
 }
-
-Polygon::Polygon(std::vector<Magnum2D::vec2>&& points)
-	: points(std::forward<std::vector<Magnum2D::vec2>>(points))
-{
-	pointsMoved = this->points;
-}
-
-Polygon::Polygon(const std::vector<Magnum2D::vec2>& points)
-	: points(points), pointsMoved(points)
-{
-}
-
-bool Polygon::IsInside(const Magnum2D::vec2& p) const
-{
-	return utils::isPointInsidePolygon(p, pointsMoved);
-}
-
-void Polygon::SetCenter(const Magnum2D::vec2& c)
-{
-	center = c;
-	pointsMoved = points;
-	for (auto& p : pointsMoved)
-		p += c;
-}
-
-void Polygon::Draw()
-{
-	Magnum2D::drawPolygon(pointsMoved, Magnum2D::rgb(50, 50, 50));
-}
-
-Rectangle Rectangle::FromCenterSize(const Magnum2D::vec2& center, const Magnum2D::vec2& size)
-{
-	return { center, size, center - size / 2.0f, center + size / 2.0f };
-}
-
-Rectangle Rectangle::FromMinMax(const Magnum2D::vec2& min, const Magnum2D::vec2& max)
-{
-	return { min + (max - min) / 2.0f, max - min, min, max };
-}
-
-Rectangle::Rectangle(const Magnum2D::vec2& center, const Magnum2D::vec2& size, const Magnum2D::vec2& min, const Magnum2D::vec2& max)
-	: center(center), size(size), hsize(size/2.0f), min(min), max(max)
-{
-}
-
-bool Rectangle::IsInside(const Magnum2D::vec2& p) const
-{
-	if (angle != 0.0f)
-	{
-		auto local = ConvertToLocal(p);
-
-		return local.x() >= -hsize.x() && local.x() <= hsize.x() && local.y() >= -hsize.y() && local.y() <= hsize.y();
-	}
-
-	return p.x() >= min.x() && p.x() <= max.x() && p.y() >= min.y() && p.y() <= max.y();
-}
-
-void Rectangle::SetCenter(const Magnum2D::vec2& c)
-{
-	center = c;
-	min = c - hsize;
-	max = c + hsize;
-}
-
-void Rectangle::Draw()
-{
-	Magnum2D::drawRectangle(center, angle, size.x(), size.y(), Magnum2D::rgb(50, 50, 50));
-}
-
-Magnum2D::vec2 Rectangle::ConvertToLocal(const Magnum2D::vec2& p) const
-{
-	Magnum2D::vec2 result = p - center;
-	if (angle != 0.0f)
-		return utils::rotate(result, -angle);
-	return result;
-}
-
-Magnum2D::vec2 Rectangle::ConvertToGlobal(const Magnum2D::vec2& p) const
-{
-	Magnum2D::vec2 result = p;
-
-	if (angle != 0.0f)
-		result = utils::rotate(result, angle);
-
-	return result + center;
-}
-
-Circle::Circle(const Magnum2D::vec2& center, float radius)
-	: center(center), radius(radius)
-{
-}
-
-bool Circle::IsInside(const Magnum2D::vec2& p) const
-{
-	return (p - center).length() < radius;
-}
-
-void Circle::SetCenter(const Magnum2D::vec2& c)
-{
-	center = c;
-}
-
-void Circle::Draw()
-{
-	Magnum2D::drawCircle(center, radius, Magnum2D::rgb(50, 50, 50));
-}
@@ -1,12 +1,11 @@
 #include "collisions.h"
-#include "application.h"
 #include "utils.h"
 
 namespace Collisions
 {
-	void applyRectangleCollisions(Magnum2D::vec2& from, Magnum2D::vec2& to)
+	void applyRectangleCollisions(const Scene& scene, Magnum2D::vec2& from, Magnum2D::vec2& to)
 	{
-		for (const auto& rect : g_app->rectangles)
+		for (const auto& rect : scene.rectangles)
 		{
 			// if "from" is inside of rectangle, move it to closest edge
 			if (rect.IsInside(from))
@@ -33,9 +32,9 @@ namespace Collisions
 		}
 	}
 
-	void applyCircleCollisions(Magnum2D::vec2& from, Magnum2D::vec2& to)
+	void applyCircleCollisions(const Scene& scene, Magnum2D::vec2& from, Magnum2D::vec2& to)
 	{
-		for (const auto& circ : g_app->circles)
+		for (const auto& circ : scene.circles)
 		{
 			if (circ.IsInside(from))
 			{
@@ -52,9 +51,9 @@ namespace Collisions
 		}
 	}
 
-	void applyPolygonCollisions(Magnum2D::vec2& from, Magnum2D::vec2& to)
+	void applyPolygonCollisions(const Scene& scene, Magnum2D::vec2& from, Magnum2D::vec2& to)
 	{
-		for (const auto& poly : g_app->polygons)
+		for (const auto& poly : scene.polygons)
 		{
 			// if "from" is inside of rectangle, move it to closest edge
 			if (poly.IsInside(from))
@@ -76,16 +75,16 @@ namespace Collisions
 		}
 	}
 
-	void applyCollisions(Magnum2D::vec2& from, Magnum2D::vec2& to)
+	void applyCollisions(const Scene& scene, Magnum2D::vec2& from, Magnum2D::vec2& to)
 	{
-		applyRectangleCollisions(from, to);
-		applyCircleCollisions(from, to);
-		applyPolygonCollisions(from, to);
+		applyRectangleCollisions(scene, from, to);
+		applyCircleCollisions(scene, from, to);
+		applyPolygonCollisions(scene, from, to);
 	}
 
-	void applyCollisions(Magnum2D::vec2& point)
+	void applyCollisions(const Scene& scene, Magnum2D::vec2& point)
 	{
-		for (const auto& rect : g_app->rectangles)
+		for (const auto& rect : scene.rectangles)
 		{
 			if (rect.IsInside(point))
 			{
@@ -98,7 +97,7 @@ namespace Collisions
 			}
 		}
 
-		for (const auto& circ : g_app->circles)
+		for (const auto& circ : scene.circles)
 		{
 			if (circ.IsInside(point))
 			{
@@ -107,7 +106,7 @@ namespace Collisions
 			}
 		}
 
-		for (const auto& poly : g_app->polygons)
+		for (const auto& poly : scene.polygons)
 		{
 			if (poly.IsInside(point))
 			{
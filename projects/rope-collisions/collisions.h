@@ -1,11 +1,12 @@
 #pragma once
+#include "shapes.h"
 #include <Magnum2D.h>
 
 namespace Collisions
 {
-	void applyRectangleCollisions(Magnum2D::vec2& from, Magnum2D::vec2& to);
-	void applyCircleCollisions(Magnum2D::vec2& from, Magnum2D::vec2& to);
-	void applyCollisions(Magnum2D::vec2& from, Magnum2D::vec2& to);
+	void applyRectangleCollisions(const Scene& scene, Magnum2D::vec2& from, Magnum2D::vec2& to);
+	void applyCircleCollisions(const Scene& scene, Magnum2D::vec2& from, Magnum2D::vec2& to);
+	void applyCollisions(const Scene& scene, Magnum2D::vec2& from, Magnum2D::vec2& to);
 
-	void applyCollisions(Magnum2D::vec2& point);
+	void applyCollisions(const Scene& scene, Magnum2D::vec2& point);
 }
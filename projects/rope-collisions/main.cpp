@@ -198,9 +198,13 @@ void draw()
 {
 	//if (Magnum2D::isKeyDown('a') || Magnum2D::isKeyPressed('s'))
 	{
-		g_app->rope.SimmulateStep();
+		std::optional<Magnum2D::vec2> attractor;
+		if (Globals::Interaction == Globals::InteractionAttract && Magnum2D::isMouseDown())
+			attractor = Magnum2D::getMousePositionWorld();
+
+		g_app->rope.SimmulateStep(*g_app, attractor);
 		for (int32_t i = 0; i < Globals::RopeConstraintIterations; i++)
-			g_app->rope.ApplyConstraints();
+			g_app->rope.ApplyConstraints(*g_app);
 	}
 
 	g_app->Draw();
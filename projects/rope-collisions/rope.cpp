@@ -3,13 +3,9 @@
 #include "globals.h"
 #include "collisions.h"
 #include <Magnum2D.h>
-#include <set>
-#include <queue>
 
-void Rope::SimmulateStep()
+void Rope::SimmulateStep(const Scene& scene, const std::optional<Magnum2D::vec2>& attractor)
 {
-	Magnum2D::vec2 mousePosition = Magnum2D::getMousePositionWorld();
-
 	for (auto& node : nodes)
 	{
 		if (node.mass == 0.0f)
@@ -18,19 +14,19 @@ void Rope::SimmulateStep()
 		auto move = node.position - node.positionOld;
 		Magnum2D::vec2 acceleration = Globals::Gravity;
 
-		if (Globals::Interaction == Globals::InteractionAttract && Magnum2D::isMouseDown())
+		if (attractor)
 		{
-			acceleration += (mousePosition - node.position);
+			acceleration += (*attractor - node.position);
 		}
 
 		node.positionOld = node.position;
 		node.position += move + Globals::RopeSimmulationDelta * Globals::RopeSimmulationDelta * acceleration;
 
-		Collisions::applyCollisions(node.positionOld, node.position);
+		Collisions::applyCollisions(scene, node.positionOld, node.position);
 	}
 }
 
-void Rope::ApplyConstraints()
+void Rope::ApplyConstraints(const Scene& scene)
 {
 	for (RopeNode& node1 : nodes)
 	{
@@ -55,7 +51,7 @@ void Rope::ApplyConstraints()
 	}
 
 	for (auto& n : nodes)
-		Collisions::applyCollisions(n.position);
+		Collisions::applyCollisions(scene, n.position);
 }
 
 Rope::Rope(Magnum2D::vec2 p1, Magnum2D::vec2 p2)
@@ -72,40 +68,3 @@ Rope::Rope(Magnum2D::vec2 p1, Magnum2D::vec2 p2)
 			nodes[i].childs.push_back(nodes[i + 1]);
 	}
 }
-
-void Rope::Draw()
-{
-	for (const auto& n : nodes)
-		Magnum2D::drawCircle(n.position, 0.05f, Magnum2D::rgb(0, 128, 255));
-
-	std::set<const RopeNode*> visited;
-	std::vector<Magnum2D::vec2> linePoints;
-
-	std::queue< const RopeNode*> processNodes;
-	for (const RopeNode& parent : nodes)
-	{
-		if (visited.contains(&parent))
-			continue;
-		processNodes.push(&parent);
-
-		while (!processNodes.empty())
-		{
-			const RopeNode* node = processNodes.front();
-			processNodes.pop();
-
-			if (visited.contains(node))
-				continue;
-			visited.insert(node);
-
-			for (const RopeNode& child : node->childs)
-			{
-				linePoints.push_back(node->position);
-				linePoints.push_back(child.position);
-
-				processNodes.push(&child);
-			}
-		}
-	}
-
-	Magnum2D::drawLines(linePoints, Magnum2D::rgb(0, 128, 255));
-}
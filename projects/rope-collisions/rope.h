@@ -1,13 +1,17 @@
 #pragma once
 #include <Magnum2D.h>
+#include <optional>
+#include <vector>
 
+struct Scene;
 
 struct Rope
 {
 	Rope(Magnum2D::vec2 p1, Magnum2D::vec2 p2);
 
-	void SimmulateStep();
-	void ApplyConstraints();
+	// attractor pulls all nodes to given point (e.g. mouse position)
+	void SimmulateStep(const Scene& scene, const std::optional<Magnum2D::vec2>& attractor = {});
+	void ApplyConstraints(const Scene& scene);
 
 	void Draw();
 
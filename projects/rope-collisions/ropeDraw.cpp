@@ -0,0 +1,41 @@
+#include "rope.h"
+#include <Magnum2D.h>
+#include <set>
+#include <queue>
+
+void Rope::Draw()
+{
+	for (const auto& n : nodes)
+		Magnum2D::drawCircle(n.position, 0.05f, Magnum2D::rgb(0, 128, 255));
+
+	std::set<const RopeNode*> visited;
+	std::vector<Magnum2D::vec2> linePoints;
+
+	std::queue< const RopeNode*> processNodes;
+	for (const RopeNode& parent : nodes)
+	{
+		if (visited.contains(&parent))
+			continue;
+		processNodes.push(&parent);
+
+		while (!processNodes.empty())
+		{
+			const RopeNode* node = processNodes.front();
+			processNodes.pop();
+
+			if (visited.contains(node))
+				continue;
+			visited.insert(node);
+
+			for (const RopeNode& child : node->childs)
+			{
+				linePoints.push_back(node->position);
+				linePoints.push_back(child.position);
+
+				processNodes.push(&child);
+			}
+		}
+	}
+
+	Magnum2D::drawLines(linePoints, Magnum2D::rgb(0, 128, 255));
+}
@@ -0,0 +1,16 @@
+#include "shapes.h"
+
+void Polygon::Draw()
+{
+	Magnum2D::drawPolygon(pointsMoved, Magnum2D::rgb(50, 50, 50));
+}
+
+void Rectangle::Draw()
+{
+	Magnum2D::drawRectangle(center, angle, size.x(), size.y(), Magnum2D::rgb(50, 50, 50));
+}
+
+void Circle::Draw()
+{
+	Magnum2D::drawCircle(center, radius, Magnum2D::rgb(50, 50, 50));
+}
@@ -8,7 +8,7 @@ namespace utils
     {
         Magnum2D::vec2 direction = (end - start).normalized();
         float totalDistance = (end - start).length();
-        int numPoints = std::ceilf(totalDistance / distance);
+        int numPoints = (int)std::ceil(totalDistance / distance);
 
         std::vector<Magnum2D::vec2> points(numPoints);
 
@@ -177,18 +177,6 @@ namespace utils
         return false; // Doesn't fall in any of the above cases
     }
 
-    Magnum2D::vec2 getWindowRelative(const Magnum2D::vec2& relative)
-    {
-        auto windowSize = Magnum2D::getWindowSize();
-
-        return { windowSize.x() * relative.x(), windowSize.y() * relative.y() };
-    }
-
-    Magnum2D::vec2 getWindowRelativeCamera(const Magnum2D::vec2& relative)
-    {
-        return Magnum2D::convertWindowToWorld(getWindowRelative(relative));
-    }
-
     Magnum2D::vec2 rotate(const Magnum2D::vec2& p, float degrees)
     {
         float radians = degrees * 0.0174533f;
@@ -300,6 +288,6 @@ namespace utils
 
     float angle(const Magnum2D::vec2& p)
     {
-        return std::atan2f(p.y(), p.x()) * 57.2958f;
+        return std::atan2(p.y(), p.x()) * 57.2958f;
     }
 }
\ No newline at end of file
@@ -0,0 +1,16 @@
+#include "utils.h"
+
+namespace utils
+{
+    Magnum2D::vec2 getWindowRelative(const Magnum2D::vec2& relative)
+    {
+        auto windowSize = Magnum2D::getWindowSize();
+
+        return { windowSize.x() * relative.x(), windowSize.y() * relative.y() };
+    }
+
+    Magnum2D::vec2 getWindowRelativeCamera(const Magnum2D::vec2& relative)
+    {
+        return Magnum2D::convertWindowToWorld(getWindowRelative(relative));
+    }
+}
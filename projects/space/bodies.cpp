@@ -1,49 +1,42 @@
 #include "bodies.h"
-#include "common.h"
 #include "simulationBodies.h"
+#include "trajectoryArchive.h"
 
 const float Bodies::ForceDrawFactor = 0.02f;
 
 size_t Bodies::AddBody(const char* name, vec2d position, vec2d velocity, double mass)
 {
-	Body newBody;
-	newBody.name = name;
-	newBody.initialPosition = position;
-	newBody.initialVelocity = velocity;
-	newBody.mass = mass;
-
-	newBody.simulationRK4.initialPoint = decltype(newBody.simulationRK4.initialPoint)(position, velocity, mass);
-	newBody.simulationEuler.initialPoint = decltype(newBody.simulationEuler.initialPoint)(position, velocity, mass);
-	newBody.simulationVerlet.initialPoint = decltype(newBody.simulationVerlet.initialPoint)(position, velocity, mass);
-
-	newBody.simulationRK4.currentPoint = newBody.simulationRK4.initialPoint;
-	newBody.simulationEuler.currentPoint = newBody.simulationEuler.initialPoint;
-	newBody.simulationVerlet.currentPoint = newBody.simulationVerlet.initialPoint;
+	const BodyDesc desc = { name, position, velocity, mass };
+	return AddBodies({ &desc, 1 });
+}
 
-	newBody.color = Utils::GetRandomColor();
+size_t Bodies::AddBodies(std::span<const BodyDesc> descs)
+{
+	// new bodies would be ephemerides without trajectories
+	FinishPendingResimulation();
 
-	bodies.push_back(std::move(newBody));
+	const size_t first = bodies.size();
+	// grows geometrically, so that adding bodies one by one doesn't move all of them each time
+	if (bodies.capacity() < first + descs.size())
+		bodies.reserve(std::max(first + descs.size(), 2 * bodies.capacity()));
 
-	vec2 from = (vec2)position;
-	vec2 to = (vec2)(position + velocity * ForceDrawFactor);
-	VectorHandler::OnChange onFromChange = [this, index = bodies.size() - 1](const vec2& v, void*)
-	{
-		bodies[index].SetInitialState((vec2d)v, bodies[index].initialVelocity, bodies[index].mass);
-		return v;
-	};
-	VectorHandler::OnChange onToChange = [this, index = bodies.size() - 1](const vec2& v, void*)
+	for (const auto& desc : descs)
 	{
-		vec2d vparent = bodies[index].parent ? bodies[*bodies[index].parent].initialVelocity : vec2d{};
-		vec2d vp = bodies[index].initialPosition + (bodies[index].initialVelocity - vparent) * ForceDrawFactor;
-		vec2d change = (vec2d)v - vp;
-
-		bodies[index].SetInitialState(bodies[index].initialPosition, bodies[index].initialVelocity + change / ForceDrawFactor, bodies[index].mass);
-		return v;
-	};
-
-	bodies.back().initialVector = vectorHandler.Push(from, to, nullptr, onFromChange, onToChange);
+		Body& newBody = bodies.emplace_back();
+		newBody.name = desc.name;
+		newBody.isStar = desc.isStar;
+		newBody.SetInitialState(desc.position, desc.velocity, desc.mass);
+
+		newBody.simulationRK4.currentPoint = newBody.simulationRK4.initialPoint;
+		newBody.simulationEuler.currentPoint = newBody.simulationEuler.initialPoint;
+		newBody.simulationVerlet.currentPoint = newBody.simulationVerlet.initialPoint;
+		newBody.simulationRK45.currentPoint = newBody.simulationRK45.initialPoint;
+		newBody.simulationLeapfrog.currentPoint = newBody.simulationLeapfrog.initialPoint;
+
+		newBody.color = Utils::GetRandomColor();
+	}
 
-	return bodies.size() - 1;
+	return first;
 }
 
 void Bodies::SimulateClear(double time)
@@ -57,12 +50,19 @@ void Bodies::SimulateClear(double time)
 
 void Bodies::SimulateExtend(double time)
 {
-	auto euler = SimulationBodies<PointEuler>(bodies);
+	StopExtension();
+	FinishPendingResimulation();
+
+	auto euler = SimulationBodies<PointEuler>(bodies, settings);
 	euler.SimulateExtend(time, simulatedTime);
-	auto verlet = SimulationBodies<PointVerlet>(bodies);
+	auto verlet = SimulationBodies<PointVerlet>(bodies, settings);
 	verlet.SimulateExtend(time, simulatedTime);
-	auto runge = SimulationBodies<PointRungeKutta>(bodies);
+	auto runge = SimulationBodies<PointRungeKutta>(bodies, settings);
 	runge.SimulateExtend(time, simulatedTime);
+	auto dormandPrince = SimulationBodies<PointDormandPrince>(bodies, settings);
+	dormandPrince.SimulateExtend(time, simulatedTime);
+	auto leapfrog = SimulationBodies<PointLeapfrog>(bodies, settings);
+	leapfrog.SimulateExtend(time, simulatedTime);
 
 	simulatedTime += time;
 
@@ -72,6 +72,8 @@ void Bodies::SimulateExtend(double time)
 	euler.ProcessTrajectoriesParent();
 	verlet.ProcessTrajectoriesParent();
 	runge.ProcessTrajectoriesParent();
+	dormandPrince.ProcessTrajectoriesParent();
+	leapfrog.ProcessTrajectoriesParent();
 
 	runge.ComputeConics();
 }
@@ -86,81 +88,287 @@ void Bodies::Resimulate(std::set<size_t> bodyIndices)
 
 void Bodies::Resimulate(size_t body)
 {
-	std::set<size_t> indices;
+	// background extension started from previous state, it continues from the new one
+	auto rest = StopExtension();
 
-	auto accs = SimulationBodies<PointRungeKutta>(bodies).ComputeInitialAccelerationsToBody(body);
-	for (size_t i = 0; i < bodies.size(); i++)
+	if (simulatedTime == 0.0)
 	{
-		if (accs[i].length() > 0.1)
-			indices.insert(i);
+		if (rest)
+			StartExtension(rest->time, rest->numPoints);
+		return;
 	}
-	indices.insert(body);
 
-	Resimulate(indices);
+	// Resimulated bodies are found with RK4. Body is added when resimulated bodies perturb its
+	// stored trajectory more than tolerance, until no other body is perturbed. Other bodies keep
+	// their trajectories and attract resimulated ones from them.
+	SimulationBodies<PointRungeKutta> runge(bodies, { body }, settings);
+	std::map<size_t, SimulationBodies<PointRungeKutta>::Previous> previous;
+
+	while (true)
+	{
+		for (size_t index : runge.indices)
+		{
+			if (!previous.contains(index))
+				previous.insert({ index, runge.GetPrevious(index) });
+		}
+
+		runge.SimulateClear(simulatedTime);
+
+		const size_t count = runge.indices.size();
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			if (!previous.contains(i) && runge.EstimatePerturbation(i, previous) > resimulateTolerance)
+				runge.indices.insert(i);
+		}
+
+		if (runge.indices.size() == count)
+			break;
+	}
+
+	// bodies of unfinished resimulation are simulated again together with the new ones, extension
+	// continues from current points, so it finishes them first
+	PendingResimulation pending{ runge.indices };
+	if (pendingResimulation)
+		pending.indices.insert(std::begin(pendingResimulation->indices), std::end(pendingResimulation->indices));
+	pendingResimulation = std::move(pending);
+
+	FinishSimulation(runge.indices);
+
+	if (rest)
+		StartExtension(rest->time, rest->numPoints);
 }
 
 void Bodies::SimulateClearInternal(double time, std::set<size_t> indices)
 {
-	auto euler = SimulationBodies<PointEuler>(bodies, indices);
-	euler.SimulateClear(time);
-	auto verlet = SimulationBodies<PointVerlet>(bodies, indices);
-	verlet.SimulateClear(time);
-	auto runge = SimulationBodies<PointRungeKutta>(bodies, indices);
-	runge.SimulateClear(time);
-	
+	StopExtension();
+
+	if (indices.size() == bodies.size())
+		pendingResimulation.reset();
+	else
+		FinishPendingResimulation();
+
+	SimulationBodies<PointEuler>(bodies, indices, settings).SimulateClear(time);
+	SimulationBodies<PointVerlet>(bodies, indices, settings).SimulateClear(time);
+	SimulationBodies<PointRungeKutta>(bodies, indices, settings).SimulateClear(time);
+	SimulationBodies<PointDormandPrince>(bodies, indices, settings).SimulateClear(time);
+	SimulationBodies<PointLeapfrog>(bodies, indices, settings).SimulateClear(time);
+
 	simulatedTime = time;
 
-	for (auto [child, parent] : runge.ComputeParents())
+	FinishSimulation(indices);
+}
+
+void Bodies::FinishSimulation(const std::set<size_t>& indices)
+{
+	for (auto [child, parent] : SimulationBodies<PointRungeKutta>(bodies, indices, settings).ComputeParents())
 		SetParentSimulation(child, parent);
 
-	euler.ProcessTrajectoriesParent();
-	verlet.ProcessTrajectoriesParent();
-	runge.ProcessTrajectoriesParent();
+	const auto changed = GetChangedBodies(indices);
 
-	runge.ComputeConics();
+	SimulationBodies<PointEuler>(bodies, changed, settings).ProcessTrajectoriesParent();
+	SimulationBodies<PointVerlet>(bodies, changed, settings).ProcessTrajectoriesParent();
+	SimulationBodies<PointRungeKutta>(bodies, changed, settings).ProcessTrajectoriesParent();
+	SimulationBodies<PointDormandPrince>(bodies, changed, settings).ProcessTrajectoriesParent();
+	SimulationBodies<PointLeapfrog>(bodies, changed, settings).ProcessTrajectoriesParent();
+
+	SimulationBodies<PointRungeKutta>(bodies, indices, settings).ComputeConics();
 }
 
-void Bodies::DrawConic(const vec2& parentPosition, Body::Conic& conic, float width, const Magnum2D::col3& color)
+std::set<size_t> Bodies::GetChangedBodies(const std::set<size_t>& indices)
 {
-	setTransform({ conic.position + parentPosition, conic.rotation });
-	Common::DrawPolyline(conic.points, Common::GetZoomIndependentSize(width), color);
-	setTransform({});
+	// children of simulated bodies are relative to changed trajectories, even when they were not simulated
+	std::set<size_t> changed;
+	std::vector<size_t> stack(std::begin(indices), std::end(indices));
+	while (!stack.empty())
+	{
+		size_t index = stack.back();
+		stack.pop_back();
+		if (changed.insert(index).second)
+			stack.insert(std::end(stack), std::begin(bodies[index].childs), std::end(bodies[index].childs));
+	}
+	return changed;
 }
 
-void Bodies::Draw(bool euler, bool verlet, bool rungeKutta, bool approximated, bool computed)
+template<class T>
+void Bodies::ResimulatePending(const std::set<size_t>& indices)
 {
-	vectorHandler.Draw();
-	
-	if (simulatedTime == 0.0)
-		return;
+	SimulationBodies<T>(bodies, indices, settings).SimulateClear(simulatedTime);
+	// parents are already computed with RK4
+	SimulationBodies<T>(bodies, GetChangedBodies(indices), settings).ProcessTrajectoriesParent();
+}
 
-	for (size_t i = 0; i < bodies.size(); i++)
+bool Bodies::ResimulatePendingStep()
+{
+	if (!pendingResimulation)
+		return false;
+
+	const auto& indices = pendingResimulation->indices;
+	switch (pendingResimulation->integrator++)
+	{
+	case 0:
+		ResimulatePending<PointEuler>(indices);
+		break;
+	case 1:
+		ResimulatePending<PointVerlet>(indices);
+		break;
+	case 2:
+		ResimulatePending<PointDormandPrince>(indices);
+		break;
+	default:
+		ResimulatePending<PointLeapfrog>(indices);
+		pendingResimulation.reset();
+		break;
+	}
+	return true;
+}
+
+void Bodies::FinishPendingResimulation()
+{
+	while (ResimulatePendingStep());
+}
+
+void Bodies::SimulateExtendAsync(double time)
+{
+	int32_t numPoints = TestBodies::TrajectoryPointCount;
+	if (auto rest = StopExtension())
+	{
+		time += rest->time;
+		numPoints += rest->numPoints;
+	}
+
+	StartExtension(time, numPoints);
+}
+
+void Bodies::SimulateClearAsync(double time)
+{
+	StopExtension();
+	pendingResimulation.reset();
+
+	for (auto& body : bodies)
 	{
-		auto& body = bodies[i];
+		body.simulationEuler.Clear();
+		body.simulationVerlet.Clear();
+		body.simulationRK4.Clear();
+		body.simulationRK45.Clear();
+		body.simulationLeapfrog.Clear();
+	}
+	simulatedTime = 0.0;
+
+	StartExtension(time, TestBodies::TrajectoryPointCount);
+}
+
+double Bodies::CancelSimulation()
+{
+	auto rest = StopExtension();
+	return rest ? rest->time : 0.0;
+}
+
+void Bodies::UpdateSimulation()
+{
+	if (ResimulatePendingStep())
+		return;
+
+	SimulationWorker::Piece piece;
+	if (!extension || !worker->TryTake(piece))
+		return;
 
-		auto parentPosition = body.parent ? GetCurrentPosition(*body.parent) : vec2{};
+	// bodies were added since the start, worker doesn't have them
+	if (std::get<0>(piece.integrators).points.size() != bodies.size())
+	{
+		StopExtension();
+		return;
+	}
 
-		if (body.parent)
+	SimulationWorker::ForEachIntegrator(piece.integrators, [&](auto& integrator)
+	{
+		using T = typename std::decay_t<decltype(integrator)>::Point;
+		for (size_t i = 0; i < bodies.size(); i++)
 		{
-			setTransform({ parentPosition, 0.0f });
+			auto& simulation = bodies[i].GetSimulation<T>();
+			const size_t fromIndex = piece.first && !simulation.trajectoryGlobal.times.empty() ? 1 : 0;
+
+			simulation.currentPoint = std::move(integrator.points[i]);
+			simulation.trajectoryGlobal.extend(std::move(integrator.trajectories[i]), fromIndex);
 		}
+		// parents are updated when the extension stops, new points use current ones
+		SimulationBodies<T>(bodies, settings).ProcessTrajectoriesParent();
+	});
 
-		if (euler)
-			body.GetSimulation<PointEuler>().trajectoryParent.draw(0, body.GetSimulation<PointEuler>().currentIndex, rgb(50, 50, 50));
-		if (verlet)
-			body.GetSimulation<PointVerlet>().trajectoryParent.draw(0, body.GetSimulation<PointVerlet>().currentIndex, rgb(100, 100, 100));
-		if (rungeKutta)
-			body.GetSimulation<PointRungeKutta>().trajectoryParent.draw(0, body.GetSimulation<PointRungeKutta>().currentIndex, body.color);
+	simulatedTime = piece.simulatedTime;
+	extension->appended = true;
 
-		setTransform({});
+	if (piece.finished)
+		StopExtension();
+}
 
-		if (approximated)
-			DrawConic(parentPosition, body.conicApproximatedFromPoints, 0.03f, rgb(80, 80, 80));
+float Bodies::GetSimulationProgress() const
+{
+	if (!extension || extension->time <= 0.0)
+		return 0.0f;
 
-		// computed trajectory is wrong if parent is not correct
-		if (body.parent && computed)
-			DrawConic(parentPosition, body.conicComputedFromParent, 0.03f, !body.HasCorrectParent() ? rgb(80, 10, 10) : rgb(150, 80, 80));
+	return (float)((simulatedTime - extension->start) / extension->time);
+}
+
+void Bodies::StartExtension(double time, int32_t numPoints)
+{
+	if (time <= 0.0)
+		return;
+
+	// worker starts from current points of all integrators
+	FinishPendingResimulation();
+
+	if (!worker)
+		worker = std::make_unique<SimulationWorker>();
+
+	SimulationWorker::Job job;
+	SimulationWorker::ForEachIntegrator(job.integrators, [this](auto& integrator)
+	{
+		using T = typename std::decay_t<decltype(integrator)>::Point;
+		// initial state may be edited before anything was simulated
+		for (auto& body : bodies)
+			integrator.points.push_back(simulatedTime == 0.0 ? body.GetSimulation<T>().initialPoint : body.GetSimulation<T>().currentPoint);
+	});
+	job.settings = settings;
+	job.settings.statistics = nullptr;
+	job.settings.ephemerides = nullptr;
+	job.dt = SimulationDt;
+	job.seconds = time;
+	job.timeOffset = simulatedTime;
+	job.numPoints = numPoints;
+
+	worker->Start(std::move(job));
+
+	extension = Extension{ simulatedTime, time, numPoints };
+}
+
+std::optional<Bodies::Extension> Bodies::StopExtension()
+{
+	if (!extension)
+		return {};
+
+	worker->Cancel();
+
+	auto stopped = *extension;
+	extension.reset();
+
+	if (stopped.appended)
+	{
+		std::set<size_t> indices;
+		for (size_t i = 0; i < bodies.size(); i++)
+			indices.insert(i);
+
+		FinishSimulation(indices);
 	}
+
+	const double end = stopped.start + stopped.time;
+	if (simulatedTime >= end)
+		return {};
+
+	Extension rest;
+	rest.start = simulatedTime;
+	rest.time = end - simulatedTime;
+	rest.numPoints = std::max((int32_t)std::round(stopped.numPoints * rest.time / stopped.time), 2);
+	return rest;
 }
 
 vec2 Bodies::GetPosition(size_t index, double time)
@@ -168,8 +376,7 @@ vec2 Bodies::GetPosition(size_t index, double time)
 	if (time == 0.0)
 		return (vec2)bodies[index].initialPosition;
 
-	auto positionIndex = bodies[index].GetSimulation<PointRungeKutta>().trajectoryGlobal.getPoint(time);
-	return bodies[index].GetSimulation<PointRungeKutta>().trajectoryGlobal.positions[positionIndex];
+	return bodies[index].GetSimulation<PointRungeKutta>().trajectoryGlobal.getState(time).position;
 }
 
 vec2 Bodies::GetCurrentPosition(size_t index)
@@ -177,7 +384,7 @@ vec2 Bodies::GetCurrentPosition(size_t index)
 	if (bodies[index].GetSimulation<PointRungeKutta>().trajectoryGlobal.positions.empty())
 		return (vec2)bodies[index].initialPosition;
 
-	return bodies[index].GetSimulation<PointRungeKutta>().trajectoryGlobal.positions[bodies[index].GetSimulation<PointRungeKutta>().currentIndex];
+	return bodies[index].GetSimulation<PointRungeKutta>().currentState.position;
 }
 
 std::optional<size_t> Bodies::SelectBody(double time, const vec2& selectPosition, float selectRadius)
@@ -191,13 +398,6 @@ std::optional<size_t> Bodies::SelectBody(double time, const vec2& selectPosition
 	return {};
 }
 
-void SetVelocityVectorSizeToParent(std::vector<Bodies::Body>& bodies, size_t body, VectorHandler& vectorHandler)
-{
-	vec2d parentVelocity = bodies[body].parent ? bodies[*bodies[body].parent].initialVelocity : vec2d{};
-	vec2 to = (vec2)(bodies[body].initialPosition + (bodies[body].initialVelocity - parentVelocity) * Bodies::ForceDrawFactor);
-	vectorHandler.SetTo(bodies[body].initialVector, to);
-}
-
 void Bodies::SetParentCommon(size_t child, std::optional<size_t> parent)
 {
 	if (bodies[child].parent)
@@ -207,8 +407,6 @@ void Bodies::SetParentCommon(size_t child, std::optional<size_t> parent)
 		SetParentInternal(child, *parent);
 	else
 		ClearParentInternal(child);
-
-	SetVelocityVectorSizeToParent(bodies, child, vectorHandler);
 }
 
 // Make sure that child is not within the subtree of body.
@@ -243,6 +441,8 @@ void Bodies::SetParentUser(size_t child, std::optional<size_t> parent)
 	SimulationBodies<PointRungeKutta>(bodies).ProcessTrajectoriesParentRecursive(child);
 	SimulationBodies<PointVerlet>(bodies).ProcessTrajectoriesParentRecursive(child);
 	SimulationBodies<PointEuler>(bodies).ProcessTrajectoriesParentRecursive(child);
+	SimulationBodies<PointDormandPrince>(bodies).ProcessTrajectoriesParentRecursive(child);
+	SimulationBodies<PointLeapfrog>(bodies).ProcessTrajectoriesParentRecursive(child);
 
 	SimulationBodies<PointRungeKutta>(bodies).ComputeConicRecursive(child);
 }
@@ -253,7 +453,7 @@ void Bodies::SetParentSimulation(size_t child, std::optional<size_t> parent)
 	// When setting parent from simulation, we know this is correct parent.
 	// Reason not setting it as current parent is that user has grabbed
 	// child's vector and is modifying it. We keep the current parent in that case.
-	if (vectorHandler.IsGrab(bodies[child].initialVector))
+	if (editedBody == child)
 	{
 		return;
 	}
@@ -286,12 +486,169 @@ float Bodies::GetCurrentDistanceToParent(size_t index)
 	return sim.trajectoryParent.positions[sim.currentIndex].length();
 }
 
-size_t Bodies::GetBodyOfGrab(VectorHandler::Vector grab)
+template<class F>
+static void ForEachPointType(F&& function)
+{
+	function(std::type_identity<PointEuler>{});
+	function(std::type_identity<PointVerlet>{});
+	function(std::type_identity<PointRungeKutta>{});
+	function(std::type_identity<PointDormandPrince>{});
+	function(std::type_identity<PointLeapfrog>{});
+}
+
+// values of archive: simulated time, count of bodies, initial state and parents of each body,
+// current point and parent of trajectoryParent of each body for each integrator, then conics of
+// each body (position, rotation, count of points and points), so they aren't fitted again
+static const size_t ArchiveBodyValues = 7;
+
+bool Bodies::WriteArchive(const std::filesystem::path& path)
+{
+	FinishPendingResimulation();
+
+	// archive is replaced, trajectories read from it must not use its file
+	std::error_code error;
+	if (!mappedArchive.empty() && std::filesystem::equivalent(path, mappedArchive, error))
+	{
+		ForEachPointType([&]<class T>(std::type_identity<T>)
+		{
+			for (auto& body : bodies)
+			{
+				body.GetSimulation<T>().trajectoryGlobal.unmap();
+				body.GetSimulation<T>().trajectoryParent.unmap();
+			}
+		});
+		mappedArchive.clear();
+	}
+
+	auto getIndex = [](const std::optional<size_t>& index) { return index ? (double)*index : -1.0; };
+
+	std::vector<double> values = { simulatedTime, (double)bodies.size() };
+	for (const auto& body : bodies)
+	{
+		values.insert(std::end(values), { body.mass, body.initialPosition.x(), body.initialPosition.y(), body.initialVelocity.x(), body.initialVelocity.y(),
+										  getIndex(body.parent), getIndex(body.parentSimulation) });
+	}
+
+	// global and parent relative trajectory of each body for each integrator
+	std::vector<const Trajectory*> trajectories;
+	ForEachPointType([&]<class T>(std::type_identity<T>)
+	{
+		for (auto& body : bodies)
+		{
+			auto& simulation = body.GetSimulation<T>();
+
+			const size_t offset = values.size();
+			values.resize(offset + T::StateSize);
+			simulation.currentPoint.saveState(values.data() + offset);
+			values.push_back(getIndex(simulation.trajectoryParentBody));
+
+			trajectories.push_back(&simulation.trajectoryGlobal);
+			trajectories.push_back(&simulation.trajectoryParent);
+		}
+	});
+
+	for (const auto& body : bodies)
+	{
+		for (const auto* conic : { &body.conicApproximatedFromPoints, &body.conicComputedFromParent })
+		{
+			values.insert(std::end(values), { conic->position.x(), conic->position.y(), conic->rotation, (double)conic->points.size() });
+			for (const auto& point : conic->points)
+				values.insert(std::end(values), { point.x(), point.y() });
+		}
+	}
+
+	return TrajectoryArchive::Write(path, trajectories, values);
+}
+
+bool Bodies::ReadArchive(const std::filesystem::path& path)
 {
+	// bodies keep consistent trajectories when the archive is rejected
+	FinishPendingResimulation();
+
+	std::vector<Trajectory> trajectories;
+	std::vector<double> values;
+	if (!TrajectoryArchive::Read(path, trajectories, values))
+		return false;
+
+	size_t expectedValues = 2 + bodies.size() * ArchiveBodyValues;
+	size_t expectedTrajectories = 0;
+	ForEachPointType([&]<class T>(std::type_identity<T>)
+	{
+		expectedValues += bodies.size() * (T::StateSize + 1);
+		expectedTrajectories += bodies.size() * 2;
+	});
+	if (values.size() < expectedValues || trajectories.size() != expectedTrajectories || values[1] != (double)bodies.size())
+		return false;
+
+	// conics are after fixed part of values
+	std::vector<Body::Conic> conics(bodies.size() * 2);
+	size_t conicValue = expectedValues;
+	for (auto& conic : conics)
+	{
+		if (values.size() - conicValue < 4 || (values.size() - conicValue - 4) / 2 < values[conicValue + 3])
+			return false;
+
+		conic.position = { (float)values[conicValue], (float)values[conicValue + 1] };
+		conic.rotation = (float)values[conicValue + 2];
+		conic.points.resize((size_t)values[conicValue + 3]);
+		conicValue += 4;
+		for (auto& point : conic.points)
+		{
+			point = { (float)values[conicValue], (float)values[conicValue + 1] };
+			conicValue += 2;
+		}
+	}
+	if (conicValue != values.size())
+		return false;
+
+	auto getIndex = [&](double value) { return value >= 0.0 && value < (double)bodies.size() ? std::optional<size_t>((size_t)value) : std::nullopt; };
+
 	for (size_t i = 0; i < bodies.size(); i++)
 	{
-		if (bodies[i].initialVector == grab)
-			return i;
+		const double* value = values.data() + 2 + i * ArchiveBodyValues;
+		const Body& body = bodies[i];
+		if (value[0] != body.mass || value[1] != body.initialPosition.x() || value[2] != body.initialPosition.y() ||
+			value[3] != body.initialVelocity.x() || value[4] != body.initialVelocity.y())
+			return false;
+	}
+
+	StopExtension();
+
+	for (size_t i = 0; i < bodies.size(); i++)
+		ClearParentInternal(i);
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		const double* value = values.data() + 2 + i * ArchiveBodyValues;
+		if (auto parent = getIndex(value[5]))
+			SetParentInternal(i, *parent);
+		bodies[i].parentSimulation = getIndex(value[6]);
+	}
+
+	const double* value = values.data() + 2 + bodies.size() * ArchiveBodyValues;
+	auto trajectory = std::begin(trajectories);
+	ForEachPointType([&]<class T>(std::type_identity<T>)
+	{
+		for (auto& body : bodies)
+		{
+			auto& simulation = body.GetSimulation<T>();
+
+			simulation.currentPoint.loadState(value);
+			value += T::StateSize;
+			simulation.trajectoryParentBody = getIndex(*value++);
+
+			simulation.trajectoryGlobal = std::move(*trajectory++);
+			simulation.trajectoryParent = std::move(*trajectory++);
+		}
+	});
+
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		bodies[i].conicApproximatedFromPoints = std::move(conics[i * 2]);
+		bodies[i].conicComputedFromParent = std::move(conics[i * 2 + 1]);
 	}
-	return (size_t)-1;
+
+	simulatedTime = values[0];
+	mappedArchive = path;
+
+	return true;
 }
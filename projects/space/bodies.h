@@ -1,9 +1,15 @@
 #pragma once
 #include <Magnum2D.h>
-#include "vectorHandler.h"
 #include "simulation.h"
+#include "simulationWorker.h"
 #include "conicfit/conicApproximation.h"
 #include <set>
+#include <optional>
+#include <type_traits>
+#include <memory>
+#include <filesystem>
+#include <span>
+#include <string_view>
 
 namespace TestBodies
 {
@@ -17,23 +23,54 @@ struct Bodies
 {
 	static const float ForceDrawFactor;
 
+	struct BodyDesc
+	{
+		std::string_view name;
+		vec2d position;
+		vec2d velocity;
+		double mass = 1.0;
+		bool isStar = false;
+	};
+
 	size_t AddBody(const char* name, vec2d position, vec2d velocity, double mass = 1.0);
+	// Storage is reserved once and bodies are constructed in place, returns index of the first one.
+	size_t AddBodies(std::span<const BodyDesc> descs);
 
 	void SimulateClear(double time);
 	void SimulateExtend(double time);
-	// this is optimization, we will simulate just few bodies hoping that changed trajectories won't affect
-	// other bodies much
+	// Only given bodies are simulated again, the others follow their stored trajectories.
 	void Resimulate(std::set<size_t> bodies);
+	// Body and bodies whose trajectories it perturbs more than resimulateTolerance are simulated again.
+	// Only RK4 is simulated immediately, the other integrators follow one per UpdateSimulation.
 	void Resimulate(size_t body);
 
-	void Draw(bool euler, bool verlet, bool rungeKutta, bool approximated, bool computed);
+	// Extension runs on background worker, trajectories grow with each UpdateSimulation. Running
+	// extension is not interrupted, the time is added to it.
+	void SimulateExtendAsync(double time);
+	// trajectories are cleared and simulated again on background worker
+	void SimulateClearAsync(double time);
+	// Appends trajectory points published by worker since last call or resimulates next integrator
+	// of edited bodies, called once per frame.
+	void UpdateSimulation();
+	// Stops background simulation, appended points are kept. Returns time which was not simulated.
+	double CancelSimulation();
+	bool IsSimulating() const { return extension.has_value(); }
+	// part of background extension which is already appended
+	float GetSimulationProgress() const;
+
+	// Trajectories and current points of all integrators, parents and simulated time are written to
+	// archive (see TrajectoryArchive). Reading continues the saved run without simulation, archive
+	// must be written with the same bodies (initial states), otherwise it fails.
+	bool WriteArchive(const std::filesystem::path& path);
+	bool ReadArchive(const std::filesystem::path& path);
+
+	void Draw(bool euler, bool verlet, bool rungeKutta, bool dormandPrince, bool leapfrog, bool approximated, bool computed);
 
 	vec2 GetPosition(size_t index, double time);
 	vec2 GetCurrentPosition(size_t index);
 	float GetCurrentDistanceToParent(size_t index);
 
 	std::optional<size_t> SelectBody(double time, const vec2& selectPosition, float selectRadius);
-	size_t GetBodyOfGrab(VectorHandler::Vector grab);
 
 	void SetParentUser(size_t child, std::optional<size_t> parent);
 	void SetParentSimulation(size_t child, std::optional<size_t> parent);
@@ -44,6 +81,11 @@ struct Bodies
 
 
 	double simulatedTime = 0.0;
+	// largest deviation of stored trajectory (in world units) caused by edited body, which is kept by Resimulate
+	double resimulateTolerance = 1e-5;
+
+	// acceleration method and tolerances used by all simulations of bodies
+	Simulation::Settings settings;
 
 	template<typename T>
 	struct BodySimulation
@@ -53,11 +95,16 @@ struct Bodies
 
 		Trajectory trajectoryGlobal;
 		Trajectory trajectoryParent;
+		// parent which points of trajectoryParent are relative to
+		std::optional<size_t> trajectoryParentBody;
 
 		size_t currentIndex = 0;
+		// interpolated between points of trajectory, so playback is smooth
+		Trajectory::State currentState;
 		void SetCurrentIndex(double currentTime)
 		{
 			currentIndex = trajectoryGlobal.getPoint(currentTime);
+			currentState = trajectoryGlobal.getState(currentTime);
 		}
 
 		void Clear()
@@ -84,16 +131,29 @@ struct Bodies
 		bool isStar = false;
 
 		col3 color;
-		VectorHandler::Vector initialVector;
 
 		BodySimulation<PointEuler> simulationEuler;
 		BodySimulation<PointVerlet> simulationVerlet;
 		BodySimulation<PointRungeKutta> simulationRK4;
+		BodySimulation<PointDormandPrince> simulationRK45;
+		BodySimulation<PointLeapfrog> simulationLeapfrog;
 
-		template<class T> BodySimulation<T>& GetSimulation() {}
-		template<> BodySimulation<PointEuler>& GetSimulation() { return simulationEuler; }
-		template<> BodySimulation<PointVerlet>& GetSimulation() { return simulationVerlet; }
-		template<> BodySimulation<PointRungeKutta>& GetSimulation() { return simulationRK4; }
+		template<class T> BodySimulation<T>& GetSimulation()
+		{
+			if constexpr (std::is_same_v<T, PointEuler>)
+				return simulationEuler;
+			else if constexpr (std::is_same_v<T, PointVerlet>)
+				return simulationVerlet;
+			else if constexpr (std::is_same_v<T, PointRungeKutta>)
+				return simulationRK4;
+			else if constexpr (std::is_same_v<T, PointDormandPrince>)
+				return simulationRK45;
+			else
+			{
+				static_assert(std::is_same_v<T, PointLeapfrog>, "unknown point type");
+				return simulationLeapfrog;
+			}
+		}
 
 		void SetInitialState(const vec2d& position, const vec2d& velocity, double mass)
 		{
@@ -103,6 +163,8 @@ struct Bodies
 			simulationEuler.initialPoint = PointEuler(initialPosition, initialVelocity, mass);
 			simulationVerlet.initialPoint = PointVerlet(initialPosition, initialVelocity, mass);
 			simulationRK4.initialPoint = PointRungeKutta(initialPosition, initialVelocity, mass);
+			simulationRK45.initialPoint = PointDormandPrince(initialPosition, initialVelocity, mass);
+			simulationLeapfrog.initialPoint = PointLeapfrog(initialPosition, initialVelocity, mass);
 		}
 
 		void RecomputeEffectiveRadius()
@@ -113,6 +175,10 @@ struct Bodies
 			simulationVerlet.currentPoint.recomputeEffectiveRadius();
 			simulationRK4.initialPoint.recomputeEffectiveRadius();
 			simulationRK4.currentPoint.recomputeEffectiveRadius();
+			simulationRK45.initialPoint.recomputeEffectiveRadius();
+			simulationRK45.currentPoint.recomputeEffectiveRadius();
+			simulationLeapfrog.initialPoint.recomputeEffectiveRadius();
+			simulationLeapfrog.currentPoint.recomputeEffectiveRadius();
 		}
 
 		void SetCurrentTime(double time)
@@ -120,6 +186,8 @@ struct Bodies
 			simulationEuler.SetCurrentIndex(time);
 			simulationVerlet.SetCurrentIndex(time);
 			simulationRK4.SetCurrentIndex(time);
+			simulationRK45.SetCurrentIndex(time);
+			simulationLeapfrog.SetCurrentIndex(time);
 		}
 
 		bool HasCorrectParent()
@@ -144,8 +212,49 @@ struct Bodies
 	void DrawConic(const Magnum2D::vec2& parentPosition, Body::Conic& conic, float width, const Magnum2D::col3& color);
 
 	void SimulateClearInternal(double time, std::set<size_t> indices);
+	// parents, parent relative trajectories and conics after simulation of indices
+	void FinishSimulation(const std::set<size_t>& indices);
+	// indices and their children (recursively), their parent relative trajectories are changed
+	std::set<size_t> GetChangedBodies(const std::set<size_t>& indices);
 
 	std::vector<Body> bodies;
 
-	VectorHandler vectorHandler;
+	// body whose initial state is edited by user, simulation does not change its parent
+	std::optional<size_t> editedBody;
+
+	// created with the first background simulation
+	std::unique_ptr<SimulationWorker> worker;
+
+	// background extension of trajectories
+	struct Extension
+	{
+		double start = 0.0;
+		double time = 0.0;
+		int32_t numPoints = 0;
+		// points were appended, parents and conics must be updated when it stops
+		bool appended = false;
+	};
+	std::optional<Extension> extension;
+
+	// Bodies resimulated only with RK4 by Resimulate(body), so that editing fits into a frame. The other
+	// integrators are resimulated one per frame, all of them before anything else uses trajectories.
+	struct PendingResimulation
+	{
+		std::set<size_t> indices;
+		// Euler, Verlet, RK45, leapfrog
+		int32_t integrator = 0;
+	};
+	std::optional<PendingResimulation> pendingResimulation;
+
+	// archive file which trajectories of the last ReadArchive are mapped from
+	std::filesystem::path mappedArchive;
+	// returns false when nothing is pending
+	bool ResimulatePendingStep();
+	void FinishPendingResimulation();
+	template<class T>
+	void ResimulatePending(const std::set<size_t>& indices);
+
+	void StartExtension(double time, int32_t numPoints);
+	// Unfinished part of extension is returned, so it can continue after the change of bodies.
+	std::optional<Extension> StopExtension();
 };
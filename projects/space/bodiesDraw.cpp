@@ -0,0 +1,49 @@
+#include "bodies.h"
+#include "common.h"
+
+// drawing of bodies is separated, simulation of bodies does not depend on Magnum2D rendering
+
+void Bodies::DrawConic(const vec2& parentPosition, Body::Conic& conic, float width, const Magnum2D::col3& color)
+{
+	setTransform({ conic.position + parentPosition, conic.rotation });
+	Common::DrawPolyline(conic.points, Common::GetZoomIndependentSize(width), color);
+	setTransform({});
+}
+
+void Bodies::Draw(bool euler, bool verlet, bool rungeKutta, bool dormandPrince, bool leapfrog, bool approximated, bool computed)
+{
+	if (simulatedTime == 0.0)
+		return;
+
+	for (size_t i = 0; i < bodies.size(); i++)
+	{
+		auto& body = bodies[i];
+
+		auto parentPosition = body.parent ? GetCurrentPosition(*body.parent) : vec2{};
+
+		if (body.parent)
+		{
+			setTransform({ parentPosition, 0.0f });
+		}
+
+		if (euler)
+			body.GetSimulation<PointEuler>().trajectoryParent.draw(0, body.GetSimulation<PointEuler>().currentIndex, rgb(50, 50, 50));
+		if (verlet)
+			body.GetSimulation<PointVerlet>().trajectoryParent.draw(0, body.GetSimulation<PointVerlet>().currentIndex, rgb(100, 100, 100));
+		if (rungeKutta)
+			body.GetSimulation<PointRungeKutta>().trajectoryParent.draw(0, body.GetSimulation<PointRungeKutta>().currentIndex, body.color);
+		if (dormandPrince)
+			body.GetSimulation<PointDormandPrince>().trajectoryParent.draw(0, body.GetSimulation<PointDormandPrince>().currentIndex, rgb(150, 150, 150));
+		if (leapfrog)
+			body.GetSimulation<PointLeapfrog>().trajectoryParent.draw(0, body.GetSimulation<PointLeapfrog>().currentIndex, rgb(120, 120, 160));
+
+		setTransform({});
+
+		if (approximated)
+			DrawConic(parentPosition, body.conicApproximatedFromPoints, 0.03f, rgb(80, 80, 80));
+
+		// computed trajectory is wrong if parent is not correct
+		if (body.parent && computed)
+			DrawConic(parentPosition, body.conicComputedFromParent, 0.03f, !body.HasCorrectParent() ? rgb(80, 10, 10) : rgb(150, 80, 80));
+	}
+}
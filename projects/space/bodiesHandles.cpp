@@ -0,0 +1,107 @@
+#include "bodiesHandles.h"
+
+using namespace Magnum2D;
+
+BodiesHandles::BodiesHandles(Bodies& bodies)
+	: bodies(bodies)
+{
+}
+
+vec2 BodiesHandles::GetVelocityHandlePosition(size_t body) const
+{
+	auto& b = bodies.bodies[body];
+	vec2d parentVelocity = b.parent ? bodies.bodies[*b.parent].initialVelocity : vec2d{};
+	return (vec2)(b.initialPosition + (b.initialVelocity - parentVelocity) * Bodies::ForceDrawFactor);
+}
+
+void BodiesHandles::Add(size_t body)
+{
+	VectorHandler::OnChange onFromChange = [this, body](const vec2& v, void*)
+	{
+		auto& b = bodies.bodies[body];
+		b.SetInitialState((vec2d)v, b.initialVelocity, b.mass);
+		return v;
+	};
+	VectorHandler::OnChange onToChange = [this, body](const vec2& v, void*)
+	{
+		auto& b = bodies.bodies[body];
+		vec2d change = (vec2d)(v - GetVelocityHandlePosition(body));
+
+		b.SetInitialState(b.initialPosition, b.initialVelocity + change / Bodies::ForceDrawFactor, b.mass);
+		return v;
+	};
+
+	vectors[body] = vectorHandler.Push((vec2)bodies.bodies[body].initialPosition, GetVelocityHandlePosition(body), nullptr, onFromChange, onToChange);
+}
+
+void BodiesHandles::Select(std::optional<size_t> body)
+{
+	for (auto it = vectors.begin(); it != vectors.end();)
+	{
+		if (it->first == body || vectorHandler.IsGrab(it->second))
+		{
+			++it;
+			continue;
+		}
+
+		vectorHandler.Remove(it->second);
+		it = vectors.erase(it);
+	}
+
+	if (body && *body < bodies.bodies.size() && !vectors.contains(*body))
+		Add(*body);
+}
+
+void BodiesHandles::Clear()
+{
+	vectorHandler.Clear();
+	vectors.clear();
+}
+
+void BodiesHandles::Sync()
+{
+	for (auto [body, vector] : vectors)
+	{
+		if (body >= bodies.bodies.size() || vectorHandler.IsGrab(vector))
+			continue;
+
+		vectorHandler.ChangeFrom(vector, (vec2)bodies.bodies[body].initialPosition);
+		vectorHandler.SetTo(vector, GetVelocityHandlePosition(body));
+	}
+}
+
+VectorHandler::UpdateResult BodiesHandles::Update()
+{
+	auto result = vectorHandler.Update();
+
+	// parent of edited body is not changed by simulation, see Bodies::SetParentSimulation
+	bodies.editedBody = GetGrabbedBody();
+
+	return result;
+}
+
+void BodiesHandles::Draw()
+{
+	Sync();
+	vectorHandler.Draw();
+}
+
+bool BodiesHandles::IsGrab(size_t body)
+{
+	auto vector = vectors.find(body);
+	return vector != vectors.end() && vectorHandler.IsGrab(vector->second);
+}
+
+std::optional<size_t> BodiesHandles::GetGrabbedBody()
+{
+	auto grab = vectorHandler.GetGrab();
+	if (!grab)
+		return {};
+
+	for (auto [body, vector] : vectors)
+	{
+		if (vector == *grab)
+			return body;
+	}
+	return {};
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "bodies.h"
+#include "vectorHandler.h"
+#include <map>
+#include <optional>
+
+// Handles for editing initial position and velocity of bodies. Kept out of Bodies, so that
+// simulation of bodies does not depend on input and drawing. Handles are created lazily, only
+// for selected body, so large systems don't keep callbacks of every body.
+struct BodiesHandles
+{
+	explicit BodiesHandles(Bodies& bodies);
+
+	// handle of previously selected body is removed (after it's released when grabbed)
+	void Select(std::optional<size_t> body);
+	void Clear();
+
+	// handles follow initial state of bodies, velocity is shown relative to parent
+	void Sync();
+
+	VectorHandler::UpdateResult Update();
+	void Draw();
+
+	bool IsGrab(size_t body);
+	std::optional<size_t> GetGrabbedBody();
+
+	Bodies& bodies;
+	VectorHandler vectorHandler;
+	// handles of bodies which have one
+	std::map<size_t, VectorHandler::Vector> vectors;
+
+private:
+	void Add(size_t body);
+	Magnum2D::vec2 GetVelocityHandlePosition(size_t body) const;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <Magnum2D.h>
+#include <vector>
+#include <span>
+#include <cassert>
+
+// Structure of arrays state of bodies. Each component is stored contiguously
+// so that force kernels can process several bodies with single instruction.
+struct BodyStore
+{
+	std::vector<double> x, y;
+	std::vector<double> vx, vy;
+	std::vector<double> m;
+	// output of force kernels
+	std::vector<double> ax, ay;
+
+	size_t size() const { return x.size(); }
+
+	void resize(size_t count)
+	{
+		x.resize(count); y.resize(count);
+		vx.resize(count); vy.resize(count);
+		m.resize(count);
+		ax.resize(count); ay.resize(count);
+	}
+
+	void SetPositions(std::span<const Magnum2D::vec2d> positions)
+	{
+		assert(positions.size() == size());
+		for (size_t i = 0; i < positions.size(); i++)
+		{
+			x[i] = positions[i].x();
+			y[i] = positions[i].y();
+		}
+	}
+
+	void SetMasses(std::span<const double> masses)
+	{
+		assert(masses.size() == size());
+		std::copy(std::begin(masses), std::end(masses), std::begin(m));
+	}
+
+	void GetAccelerations(std::span<Magnum2D::vec2d> accelerations) const
+	{
+		assert(accelerations.size() == size());
+		for (size_t i = 0; i < accelerations.size(); i++)
+			accelerations[i] = { ax[i], ay[i] };
+	}
+
+	// fill complete state from points (PointEuler, PointRungeKutta, ...)
+	template<class T>
+	void Load(std::vector<T>& points)
+	{
+		resize(points.size());
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			auto velocity = points[i].getVelocity();
+			x[i] = points[i].position.x();
+			y[i] = points[i].position.y();
+			vx[i] = velocity.x();
+			vy[i] = velocity.y();
+			m[i] = points[i].getMass();
+		}
+	}
+};
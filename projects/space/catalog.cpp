@@ -0,0 +1,35 @@
+#include "systemLoader.h"
+#include <iostream>
+
+// Converts system of bodies (json or catalog) to binary catalog, which is loaded without parsing.
+
+double SimulationDt = 0.01;
+
+namespace TestBodies
+{
+	int32_t TrajectoryPointCount = 300;
+	float CurrentTime = 0.0f;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+	{
+		std::cout << "usage: space-catalog <system.json|catalog> <catalog>\n";
+		return 1;
+	}
+
+	try
+	{
+		auto entries = SystemLoader::Read(argv[1]);
+		SystemLoader::WriteCatalog(argv[2], entries);
+		std::cout << "written " << entries.size() << " bodies to " << argv[2] << "\n";
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "cannot convert " << argv[1] << ": " << e.what() << "\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,267 @@
+#pragma once
+#include "point.h"
+#include "mappedFile.h"
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <limits>
+#include <memory>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+
+namespace Simulation
+{
+	// Snapshots of full state of simulated points, taken by Simulate at trajectory points. Stage data
+	// of integrators, step of adaptive integrator and burn indices are included, so simulation
+	// continued from snapshot gives the same points as the uninterrupted one.
+	// Every snapshot is a record of doubles with the same size (time, step, burn index and state of
+	// each point). File is a header followed by the records, Read maps it to memory and Find reads
+	// only the found record. Mapped records are copied to memory when a new snapshot is captured.
+	template<class T>
+	struct PointCheckpoints
+	{
+		struct Snapshot
+		{
+			double time = 0.0;
+			// step of the simulation (adaptive one changes it)
+			double step = 0.0;
+			std::vector<T> points;
+			std::vector<size_t> burnIndex;
+		};
+
+		struct FileHeader
+		{
+			char magic[4] = { 'S', 'P', 'C', 'K' };
+			uint32_t version = Version;
+			uint32_t pointType = GetPointType();
+			uint32_t stateSize = (uint32_t)T::StateSize;
+			uint64_t points = 0;
+			uint64_t count = 0;
+			uint64_t reserved[4] = {};
+		};
+		static_assert(sizeof(FileHeader) == 64, "records start aligned to cache line");
+
+		static constexpr uint32_t Version = 1;
+
+		// snapshot at time replaces later ones, it is skipped if it is closer than interval to the previous one
+		void Capture(double interval, double time, double step, const std::vector<T>& points, const std::vector<size_t>& burnIndex)
+		{
+			if (interval <= 0.0)
+				return;
+
+			if (points.size() != pointCount)
+			{
+				Clear();
+				pointCount = points.size();
+			}
+
+			Truncate(std::nextafter(time, -std::numeric_limits<double>::infinity()));
+			if (GetCount() > 0 && time < GetTime(GetCount() - 1) + interval)
+				return;
+
+			Unmap();
+			const size_t offset = records.size();
+			records.resize(offset + GetRecordSize());
+
+			double* record = records.data() + offset;
+			*record++ = time;
+			*record++ = step;
+			for (size_t i = 0; i < points.size(); i++)
+				*record++ = i < burnIndex.size() ? (double)burnIndex[i] : 0.0;
+			for (const auto& point : points)
+			{
+				point.saveState(record);
+				record += T::StateSize;
+			}
+		}
+
+		// latest snapshot at or before time
+		std::optional<Snapshot> Find(double time) const
+		{
+			size_t begin = 0, end = GetCount();
+			while (begin < end)
+			{
+				size_t middle = (begin + end) / 2;
+				if (GetTime(middle) <= time)
+					begin = middle + 1;
+				else
+					end = middle;
+			}
+			if (begin == 0)
+				return {};
+
+			const double* record = GetRecords() + (begin - 1) * GetRecordSize();
+
+			Snapshot result;
+			result.time = *record++;
+			result.step = *record++;
+			for (size_t i = 0; i < pointCount; i++)
+				result.burnIndex.push_back((size_t)*record++);
+			result.points.resize(pointCount);
+			for (auto& point : result.points)
+			{
+				point.loadState(record);
+				record += T::StateSize;
+			}
+			return result;
+		}
+
+		// snapshots after time are removed
+		void Truncate(double time)
+		{
+			size_t count = GetCount();
+			while (count > 0 && GetTime(count - 1) > time)
+				count--;
+			if (mapping)
+				mappedCount = count;
+			else
+				records.resize(count * GetRecordSize());
+		}
+
+		void Clear()
+		{
+			records.clear();
+			mapping.reset();
+			mappedCount = 0;
+		}
+
+		size_t GetCount() const { return mapping ? mappedCount : records.size() / GetRecordSize(); }
+		size_t GetBytes() const { return GetCount() * GetRecordSize() * sizeof(double); }
+
+		// mapped records are copied to memory first, so the file can be written over the one it was read from
+		bool Write(const std::filesystem::path& path)
+		{
+			Unmap();
+			std::ofstream stream(path, std::ios::binary);
+
+			FileHeader header;
+			header.points = pointCount;
+			header.count = GetCount();
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(double));
+
+			return (bool)stream;
+		}
+
+		// fails when file is not checkpoints of the same point type and version or its size doesn't
+		// match the header, checkpoints are not changed then
+		bool Read(const std::filesystem::path& path)
+		{
+			auto file = MappedFile::Open(path);
+			if (!file || file->size < sizeof(FileHeader))
+				return false;
+
+			FileHeader header, expected;
+			std::memcpy(&header, file->data, sizeof(header));
+			if (!std::equal(std::begin(header.magic), std::end(header.magic), std::begin(expected.magic)) || header.version != expected.version ||
+				header.pointType != expected.pointType || header.stateSize != expected.stateSize)
+				return false;
+
+			// count of points is checked first, so record size can't overflow
+			const size_t bytes = file->size - sizeof(FileHeader);
+			const size_t values = bytes / sizeof(double);
+			if (bytes % sizeof(double) != 0 || header.points > values / (1 + T::StateSize))
+				return false;
+			const size_t recordSize = 2 + (size_t)header.points * (1 + T::StateSize);
+			if (values % recordSize != 0 || header.count != values / recordSize)
+				return false;
+
+			records.clear();
+			pointCount = (size_t)header.points;
+			mapping = std::move(file);
+			mappedCount = (size_t)header.count;
+			return true;
+		}
+
+	private:
+		static constexpr uint32_t GetPointType()
+		{
+			if constexpr (std::is_same_v<T, PointEuler>)
+				return 1;
+			else if constexpr (std::is_same_v<T, PointVerlet>)
+				return 2;
+			else if constexpr (std::is_same_v<T, PointRungeKutta>)
+				return 3;
+			else if constexpr (std::is_same_v<T, PointDormandPrince>)
+				return 4;
+			else
+			{
+				static_assert(std::is_same_v<T, PointLeapfrog>, "unknown point type");
+				return 5;
+			}
+		}
+
+		size_t GetRecordSize() const { return 2 + pointCount * (1 + T::StateSize); }
+		double GetTime(size_t index) const { return GetRecords()[index * GetRecordSize()]; }
+
+		// records start after the header, which keeps them aligned
+		const double* GetRecords() const
+		{
+			return mapping ? reinterpret_cast<const double*>(mapping->data + sizeof(FileHeader)) : records.data();
+		}
+
+		// copies mapped records to memory
+		void Unmap()
+		{
+			if (!mapping)
+				return;
+
+			records.assign(GetRecords(), GetRecords() + mappedCount * GetRecordSize());
+			mapping.reset();
+			mappedCount = 0;
+		}
+
+		size_t pointCount = 0;
+		std::vector<double> records;
+		// records of file given to Read, until the first snapshot is captured
+		std::shared_ptr<MappedFile> mapping;
+		size_t mappedCount = 0;
+	};
+
+	// checkpoints of all integrators, Settings::checkpoints
+	struct Checkpoints
+	{
+		// minimal simulated time between snapshots, zero disables them
+		double interval = 0.0;
+
+		PointCheckpoints<PointEuler> euler;
+		PointCheckpoints<PointVerlet> verlet;
+		PointCheckpoints<PointRungeKutta> rungeKutta;
+		PointCheckpoints<PointDormandPrince> dormandPrince;
+		PointCheckpoints<PointLeapfrog> leapfrog;
+
+		template<class T> PointCheckpoints<T>& Get()
+		{
+			if constexpr (std::is_same_v<T, PointEuler>)
+				return euler;
+			else if constexpr (std::is_same_v<T, PointVerlet>)
+				return verlet;
+			else if constexpr (std::is_same_v<T, PointRungeKutta>)
+				return rungeKutta;
+			else if constexpr (std::is_same_v<T, PointDormandPrince>)
+				return dormandPrince;
+			else
+				return leapfrog;
+		}
+
+		template<class T>
+		void Capture(double time, double step, const std::vector<T>& points, const std::vector<size_t>& burnIndex)
+		{
+			Get<T>().Capture(interval, time, step, points, burnIndex);
+		}
+
+		void Clear()
+		{
+			euler.Clear();
+			verlet.Clear();
+			rungeKutta.Clear();
+			dormandPrince.Clear();
+			leapfrog.Clear();
+		}
+	};
+}
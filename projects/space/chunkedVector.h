@@ -0,0 +1,270 @@
+#pragma once
+#include "trajectoryStorage.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <span>
+#include <istream>
+#include <ostream>
+#include <cassert>
+#include <type_traits>
+#include <atomic>
+
+// Array stored in chunks of fixed size. Appending never moves stored elements, full chunks
+// are sealed and can be spilled to disk (see TrajectoryStorage). Interface follows std::vector
+// for the operations used by trajectories. References are valid until next push_back.
+template<class T>
+struct ChunkedVector
+{
+	static_assert(std::is_trivially_copyable_v<T>, "chunks are spilled as raw bytes");
+
+	static constexpr size_t ChunkShift = 12;
+	static constexpr size_t ChunkSize = size_t(1) << ChunkShift;
+
+	ChunkedVector() = default;
+
+	ChunkedVector(ChunkedVector&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	ChunkedVector& operator=(ChunkedVector&& other) noexcept
+	{
+		if (this != &other)
+		{
+			chunks = std::move(other.chunks);
+			count = other.count;
+			generation = other.generation;
+			other.clear();
+		}
+		return *this;
+	}
+
+	ChunkedVector(const ChunkedVector& other)
+	{
+		append(other, 0);
+	}
+
+	ChunkedVector& operator=(const ChunkedVector& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			append(other, 0);
+		}
+		return *this;
+	}
+
+	ChunkedVector& operator=(const std::vector<T>& values)
+	{
+		clear();
+		for (const auto& value : values)
+			push_back(value);
+		return *this;
+	}
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	// no-op, chunks are allocated when needed
+	void reserve(size_t) {}
+
+	T& operator[](size_t index)
+	{
+		assert(index < count);
+		return GetChunk(index >> ChunkShift).items[index & (ChunkSize - 1)];
+	}
+
+	const T& operator[](size_t index) const
+	{
+		assert(index < count);
+		return GetChunk(index >> ChunkShift).items[index & (ChunkSize - 1)];
+	}
+
+	T& front() { return (*this)[0]; }
+	const T& front() const { return (*this)[0]; }
+	T& back() { return (*this)[count - 1]; }
+	const T& back() const { return (*this)[count - 1]; }
+
+	void push_back(const T& value)
+	{
+		if ((count & (ChunkSize - 1)) == 0)
+			chunks.push_back(std::make_unique<Chunk>());
+
+		Chunk& chunk = *chunks.back();
+		if (chunk.mapping)
+		{
+			// mapped part of chunk is copied before it grows
+			chunk.data.assign(chunk.items, chunk.items + chunk.size);
+			chunk.mapping.reset();
+		}
+		chunk.data.push_back(value);
+		chunk.items = chunk.data.data();
+		chunk.size = chunk.data.size();
+		count++;
+
+		if (chunk.data.size() == ChunkSize)
+			chunk.Seal();
+	}
+
+	// append elements [fromIndex, size) of other
+	void append(const ChunkedVector& other, size_t fromIndex)
+	{
+		for (size_t i = fromIndex; i < other.size(); i++)
+			push_back(other[i]);
+	}
+
+	// Appends chunk whose elements stay in file mapped to memory (copy on write), mapping is kept
+	// while the chunk uses it. Only the last chunk may be partial, it is copied when it grows.
+	void appendMapped(T* items, size_t itemCount, std::shared_ptr<void> mapping)
+	{
+		assert((count & (ChunkSize - 1)) == 0 && itemCount > 0 && itemCount <= ChunkSize);
+
+		auto chunk = std::make_unique<Chunk>();
+		chunk->items = items;
+		chunk->size = itemCount;
+		chunk->mapping = std::move(mapping);
+		if (itemCount == ChunkSize)
+			chunk->SealMapped();
+		chunks.push_back(std::move(chunk));
+		count += itemCount;
+	}
+
+	// chunks whose elements are in mapped file are copied to memory, so the file isn't used anymore
+	void unmap()
+	{
+		for (auto& chunk : chunks)
+		{
+			if (!chunk->mapping)
+				continue;
+
+			auto copy = std::make_unique<Chunk>();
+			copy->data.assign(chunk->items, chunk->items + chunk->size);
+			copy->items = copy->data.data();
+			copy->size = copy->data.size();
+			if (copy->size == ChunkSize)
+				copy->Seal();
+			chunk = std::move(copy);
+		}
+	}
+
+	// keeps first newCount elements
+	void truncate(size_t newCount)
+	{
+		if (newCount >= count)
+			return;
+
+		chunks.resize((newCount + ChunkSize - 1) >> ChunkShift);
+		if (const size_t rest = newCount & (ChunkSize - 1))
+		{
+			// sealed chunk never changes, kept part is copied to a new one
+			auto chunk = std::make_unique<Chunk>();
+			auto data = GetChunkData(chunks.size() - 1);
+			chunk->data.assign(data.begin(), data.begin() + rest);
+			chunk->items = chunk->data.data();
+			chunk->size = rest;
+			chunks.back() = std::move(chunk);
+		}
+
+		count = newCount;
+		generation = NextGeneration();
+	}
+
+	void clear()
+	{
+		chunks.clear();
+		count = 0;
+		generation = NextGeneration();
+	}
+
+	// changes whenever stored elements are replaced, data derived from chunks is valid while it is the same
+	uint64_t GetGeneration() const { return generation; }
+
+	// contiguous elements of chunk, index is index of chunk
+	std::span<const T> GetChunkData(size_t index) const
+	{
+		const Chunk& chunk = GetChunk(index);
+		return { chunk.items, chunk.size };
+	}
+
+	size_t GetChunkCount() const { return chunks.size(); }
+	bool IsChunkSealed(size_t index) const { return chunks[index]->IsSealed(); }
+
+	std::vector<T> ToVector() const
+	{
+		std::vector<T> result;
+		result.reserve(count);
+		for (size_t i = 0; i < count; i++)
+			result.push_back((*this)[i]);
+		return result;
+	}
+
+	// copies elements [index, index + length) to destination, chunk by chunk
+	void CopyTo(size_t index, size_t length, T* destination) const
+	{
+		assert(index + length <= count);
+		while (length > 0)
+		{
+			const auto data = GetChunkData(index >> ChunkShift).subspan(index & (ChunkSize - 1));
+			const size_t copied = std::min(length, data.size());
+			std::copy_n(data.begin(), copied, destination);
+			index += copied;
+			length -= copied;
+			destination += copied;
+		}
+	}
+
+private:
+	// last chunk grows like std::vector, so short arrays don't take the whole chunk
+	struct Chunk : public TrajectoryStorage::Chunk
+	{
+		~Chunk() override = default;
+
+		using TrajectoryStorage::Chunk::Seal;
+		using TrajectoryStorage::Chunk::SealMapped;
+
+		size_t GetBytes() const override { return ChunkSize * sizeof(T); }
+
+		void Write(std::ostream& stream) const override
+		{
+			stream.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+		}
+
+		void Read(std::istream& stream) override
+		{
+			data.resize(ChunkSize);
+			items = data.data();
+			size = ChunkSize;
+			stream.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(T));
+		}
+
+		void Release() override
+		{
+			data.clear();
+			data.shrink_to_fit();
+			items = nullptr;
+		}
+
+		// elements in data or in mapped file
+		T* items = nullptr;
+		size_t size = 0;
+		std::vector<T> data;
+		std::shared_ptr<void> mapping;
+	};
+
+	Chunk& GetChunk(size_t index) const
+	{
+		Chunk& chunk = *chunks[index];
+		chunk.Touch();
+		return chunk;
+	}
+
+	static uint64_t NextGeneration()
+	{
+		static std::atomic<uint64_t> next = 0;
+		return next++;
+	}
+
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	size_t count = 0;
+	uint64_t generation = NextGeneration();
+};
@@ -0,0 +1,356 @@
+#include "bodies.h"
+#include "simulationBodies.h"
+#include "systemLoader.h"
+#include "utils.h"
+#include "trajectoryStorage.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Headless simulation of system of bodies, does not depend on Magnum2D rendering or input.
+// Writes trajectories (csv) and statistics of the run (json) to output directory.
+
+double SimulationDt = 0.01;
+
+namespace TestBodies
+{
+	int32_t TrajectoryPointCount = 300;
+	float CurrentTime = 0.0f;
+}
+
+struct Options
+{
+	std::string system;
+	std::string output = ".";
+	std::string integrator = "rk4";
+	std::string gravity = "direct";
+	double days = 365.0;
+	// zero keeps dt of the system units
+	double dtHours = 0.0;
+	Simulation::Settings settings;
+	TrajectoryStorage::Settings storage;
+	// zero disables checkpoints
+	double checkpointDays = 0.0;
+	std::string checkpoints;
+	std::string resume;
+	std::string archive;
+};
+
+static void PrintUsage()
+{
+	std::cout << "usage: space-cli <system.json|catalog> [options]\n"
+				 "  --days <days>            simulated time (default 365)\n"
+				 "  --integrator <name>      euler, verlet, rk4, rk45, leapfrog, yoshida4, yoshida6 (default rk4)\n"
+				 "  --gravity <name>         direct, barnes-hut, vectorized, symmetric (default direct)\n"
+				 "  --opening-angle <value>  Barnes-Hut opening angle (default 0.5)\n"
+				 "  --threads <count>        worker threads (default 1)\n"
+				 "  --points <count>         trajectory points (default 300)\n"
+				 "  --dt <hours>             base step (default 1 hour)\n"
+				 "  --tolerance <value>      relative tolerance of rk45 (default 1e-9)\n"
+				 "  --block-levels <count>   block time step levels of leapfrog (default 6)\n"
+				 "  --precision <name>       standard, compensated sums of leapfrog state and direct gravity (default standard)\n"
+				 "  --memory-budget <MB>     memory of full trajectory chunks, zero is unlimited (default 0)\n"
+				 "  --spill <directory>      write chunks over memory budget to directory\n"
+				 "  --checkpoint-days <days> simulated time between checkpoints (default 30 when writing them)\n"
+				 "  --checkpoints <file>     write checkpoints of the integrator state to file\n"
+				 "  --resume <file>          continue from the last checkpoint of file up to --days\n"
+				 "  --archive <file>         write trajectories and state of the run to file (see TrajectoryArchive)\n"
+				 "  --output <directory>     where trajectories.csv and stats.json are written (default .)\n";
+}
+
+static bool ParseGravity(const std::string& name, Gravity::Method& method)
+{
+	if (name == "direct")
+		method = Gravity::Method::Direct;
+	else if (name == "barnes-hut")
+		method = Gravity::Method::BarnesHut;
+	else if (name == "vectorized")
+		method = Gravity::Method::Vectorized;
+	else if (name == "symmetric")
+		method = Gravity::Method::Symmetric;
+	else
+		return false;
+	return true;
+}
+
+static std::optional<Options> ParseOptions(int argc, char** argv)
+{
+	Options options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg.rfind("--", 0) != 0)
+		{
+			options.system = arg;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			std::cerr << "missing value of " << arg << "\n";
+			return {};
+		}
+		std::string value = argv[++i];
+
+		// numbers throw std::invalid_argument or std::out_of_range
+		try
+		{
+			if (arg == "--days")
+				options.days = std::stod(value);
+			else if (arg == "--integrator")
+				options.integrator = value;
+			else if (arg == "--gravity")
+			{
+				if (!ParseGravity(value, options.settings.gravity.method))
+				{
+					std::cerr << "unknown gravity method " << value << "\n";
+					return {};
+				}
+				options.gravity = value;
+			}
+			else if (arg == "--opening-angle")
+				options.settings.gravity.openingAngle = std::stod(value);
+			else if (arg == "--threads")
+				options.settings.gravity.threads = std::stoul(value);
+			else if (arg == "--points")
+				TestBodies::TrajectoryPointCount = std::stoi(value);
+			else if (arg == "--dt")
+				options.dtHours = std::stod(value);
+			else if (arg == "--tolerance")
+				options.settings.adaptive.relativeTolerance = std::stod(value);
+			else if (arg == "--block-levels")
+				options.settings.blockTimesteps.maxLevel = std::stoi(value);
+			else if (arg == "--precision")
+			{
+				if (value == "standard")
+					options.settings.precision = Simulation::Precision::Standard;
+				else if (value == "compensated")
+					options.settings.precision = Simulation::Precision::Compensated;
+				else
+				{
+					std::cerr << "unknown precision " << value << "\n";
+					return {};
+				}
+			}
+			else if (arg == "--memory-budget")
+				options.storage.ramBudget = (size_t)(std::stod(value) * 1024.0 * 1024.0);
+			else if (arg == "--spill")
+			{
+				options.storage.spillToDisk = true;
+				options.storage.directory = value;
+			}
+			else if (arg == "--checkpoint-days")
+				options.checkpointDays = std::stod(value);
+			else if (arg == "--checkpoints")
+				options.checkpoints = value;
+			else if (arg == "--resume")
+				options.resume = value;
+			else if (arg == "--archive")
+				options.archive = value;
+			else if (arg == "--output")
+				options.output = value;
+			else
+			{
+				std::cerr << "unknown option " << arg << "\n";
+				return {};
+			}
+		}
+		catch (const std::exception&)
+		{
+			std::cerr << "invalid value " << value << " of " << arg << "\n";
+			return {};
+		}
+	}
+
+	if (options.system.empty())
+		return {};
+
+	if (!options.checkpoints.empty() && options.checkpointDays <= 0.0)
+		options.checkpointDays = 30.0;
+
+	return options;
+}
+
+template<class T>
+double Simulate(Bodies& bodies, double seconds, const Options& options, Simulation::Settings settings)
+{
+	Simulation::Checkpoints checkpoints;
+	checkpoints.interval = options.checkpointDays * Unit::Day;
+	settings.checkpoints = &checkpoints;
+
+	if (!options.resume.empty() && !checkpoints.Get<T>().Read(options.resume))
+		throw std::runtime_error("cannot read checkpoints of " + options.integrator + " from " + options.resume);
+
+	auto start = std::chrono::steady_clock::now();
+
+	SimulationBodies<T> simulation(bodies.bodies, settings);
+	if (options.resume.empty())
+		simulation.SimulateClear(seconds);
+	else
+		simulation.SimulateFromCheckpoint(seconds, seconds);
+
+	auto wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (!options.checkpoints.empty() && !checkpoints.Get<T>().Write(options.checkpoints))
+		throw std::runtime_error("cannot write checkpoints to " + options.checkpoints);
+
+	return wallSeconds;
+}
+
+static std::optional<double> Simulate(Bodies& bodies, Options& options)
+{
+	const double seconds = options.days * Unit::Day;
+
+	if (options.integrator == "euler")
+		return Simulate<PointEuler>(bodies, seconds, options, options.settings);
+	if (options.integrator == "verlet")
+		return Simulate<PointVerlet>(bodies, seconds, options, options.settings);
+	if (options.integrator == "rk4")
+		return Simulate<PointRungeKutta>(bodies, seconds, options, options.settings);
+	if (options.integrator == "rk45")
+		return Simulate<PointDormandPrince>(bodies, seconds, options, options.settings);
+
+	if (options.integrator == "leapfrog")
+		options.settings.symplectic = Simulation::SymplecticScheme::Leapfrog;
+	else if (options.integrator == "yoshida4")
+		options.settings.symplectic = Simulation::SymplecticScheme::Yoshida4;
+	else if (options.integrator == "yoshida6")
+		options.settings.symplectic = Simulation::SymplecticScheme::Yoshida6;
+	else
+		return {};
+
+	return Simulate<PointLeapfrog>(bodies, seconds, options, options.settings);
+}
+
+template<class T>
+void WriteTrajectories(Bodies& bodies, std::ostream& out)
+{
+	out << "body,time,x,y,vx,vy\n";
+	out.precision(9);
+
+	for (auto& body : bodies.bodies)
+	{
+		const Trajectory& trajectory = body.GetSimulation<T>().trajectoryGlobal;
+		for (size_t i = 0; i < trajectory.times.size(); i++)
+		{
+			// back to SI units
+			out << body.name << ","
+				<< trajectory.times[i] / Unit::Second << ","
+				<< trajectory.positions[i].x() / Unit::Meter << ","
+				<< trajectory.positions[i].y() / Unit::Meter << ","
+				<< trajectory.velocities[i].x() * Unit::Second / Unit::Meter << ","
+				<< trajectory.velocities[i].y() * Unit::Second / Unit::Meter << "\n";
+		}
+	}
+}
+
+static void WriteTrajectories(Bodies& bodies, const std::string& integrator, std::ostream& out)
+{
+	if (integrator == "euler")
+		WriteTrajectories<PointEuler>(bodies, out);
+	else if (integrator == "verlet")
+		WriteTrajectories<PointVerlet>(bodies, out);
+	else if (integrator == "rk4")
+		WriteTrajectories<PointRungeKutta>(bodies, out);
+	else if (integrator == "rk45")
+		WriteTrajectories<PointDormandPrince>(bodies, out);
+	else
+		WriteTrajectories<PointLeapfrog>(bodies, out);
+}
+
+int main(int argc, char** argv)
+{
+	auto options = ParseOptions(argc, argv);
+	if (!options)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Bodies bodies;
+	SystemLoader::SetupSolarSystemUnits();
+
+	try
+	{
+		SystemLoader::Load(bodies, SystemLoader::Read(options->system));
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "cannot load " << options->system << ": " << e.what() << "\n";
+		return 1;
+	}
+
+	if (options->dtHours > 0.0)
+		SimulationDt = options->dtHours * Unit::Hour;
+
+	Simulation::Statistics statistics;
+	options->settings.statistics = &statistics;
+
+	TrajectoryStorage::SetSettings(options->storage);
+
+	std::optional<double> seconds;
+	try
+	{
+		seconds = Simulate(bodies, *options);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+		PrintUsage();
+		return 1;
+	}
+
+	if (!seconds)
+	{
+		std::cerr << "unknown integrator " << options->integrator << "\n";
+		PrintUsage();
+		return 1;
+	}
+
+	if (!options->archive.empty() && !bodies.WriteArchive(options->archive))
+	{
+		std::cerr << "cannot write archive to " << options->archive << "\n";
+		return 1;
+	}
+
+	std::ofstream trajectories(options->output + "/trajectories.csv");
+	WriteTrajectories(bodies, options->integrator, trajectories);
+
+	auto storage = TrajectoryStorage::GetStatistics();
+
+	nlohmann::json stats;
+	stats["system"] = options->system;
+	stats["integrator"] = options->integrator;
+	stats["gravity"] = options->gravity;
+	stats["threads"] = options->settings.gravity.threads;
+	stats["bodies"] = bodies.bodies.size();
+	stats["days"] = options->days;
+	stats["dtHours"] = SimulationDt / Unit::Hour;
+	stats["trajectoryPoints"] = TestBodies::TrajectoryPointCount;
+	stats["wallSeconds"] = *seconds;
+	stats["steps"] = statistics.steps;
+	stats["rejectedSteps"] = statistics.rejectedSteps;
+	stats["accelerations"] = statistics.accelerations;
+	stats["energyDrift"] = statistics.energyDrift;
+	stats["angularMomentumDrift"] = statistics.angularMomentumDrift;
+	stats["failed"] = statistics.failed;
+	stats["residentBytes"] = storage.residentBytes;
+	stats["spilledBytes"] = storage.spilledBytes;
+	stats["spills"] = storage.spills;
+	stats["loads"] = storage.loads;
+
+	std::ofstream(options->output + "/stats.json") << stats.dump(4) << "\n";
+
+	std::cout << options->integrator << ": " << bodies.bodies.size() << " bodies, " << options->days << " days in " << *seconds << " s, "
+			  << statistics.steps << " steps, energy drift " << statistics.energyDrift << "\n";
+	if (statistics.failed)
+	{
+		std::cerr << "adaptive step did not reach tolerance, simulation stopped early\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -1,10 +1,8 @@
-#include "ConicApproximation.h"
+#include "conicApproximation.h"
 #include "conicFit.h"
-#include "..\utils.h"
+#include "../utils.h"
 #include <cmath>
 
-extern double GravitationalConstant;
-
 using namespace Magnum2D;
 
 namespace ConicApproximation
@@ -261,7 +259,7 @@ namespace ConicApproximation
 	Conic::Type Conic::GetType() const
 	{
 		double discriminant = pow(B, 2) - 4.0*A*C;
-		if (isnan(discriminant))
+		if (std::isnan(discriminant))
 			return invalid;
 
 		if (Utils::SigmaCompare(discriminant, 0.0))
@@ -271,85 +269,4 @@ namespace ConicApproximation
 		else
 			return ellipse;
 	}
-
-	Conic ComputeRotatedConic(double centralMass, double oribitingMass, const vec2d& distance, const vec2d& velocity)
-	{
-		double G = GravitationalConstant;
-		double reducedMass = (centralMass*oribitingMass)/(centralMass + oribitingMass);
-		double angularMomentum = reducedMass*distance.length()*velocity.y(); // use tangential part of velocity
-		double energy = 0.5*reducedMass*pow(velocity.length(), 2) - (G*centralMass*oribitingMass)/distance.length();
-		double semilatusRectum = pow(angularMomentum,2)/(reducedMass*G*centralMass*oribitingMass);
-		double eccentricity = sqrt(1 + (2.0*energy*pow(angularMomentum, 2))/(reducedMass*pow(G*centralMass*oribitingMass, 2)));
-
-		// AX^2 + BXY + CY^2 + DX + EY + F = 0
-
-		Conic ret;
-		ret.A = 1.0 - pow(eccentricity, 2);
-		ret.B = 0.0;
-		ret.C = 1.0;
-		ret.D = -2.0*eccentricity*semilatusRectum;
-		ret.E = 0.0;
-		ret.F = -pow(semilatusRectum, 2);
-
-		return ret;
-	}
-
-	Conic ComputeConic(double mass1, double mass2, const vec2d& position2, const vec2d& velocity2)
-	{
-		vec2d offset = position2;
-		vec2d relativeVelocity = velocity2;
-		double angle = Utils::GetAngle(offset);
-
-		Utils::RotateVector(offset, -angle);
-		Utils::RotateVector(relativeVelocity, -angle);
-
-		Conic ret = ComputeRotatedConic(mass1, mass2, offset, relativeVelocity);
-		
-		// TODO why -angle ???
-		ret.Rotate(-angle);
-
-		// additional rotation caused by radial velocity
-		if (ret.GetType() == Conic::ellipse)
-		{
-			Ellipse ellipse = ret.GetEllipse();
-			double r = offset.x(), a = ellipse.radius.x(), e = ellipse.GetEccentricity();
-			double radialAngle = (pow(r, 2) - pow(2.0*a - r, 2) + pow(2.0*a*e, 2)) / (4.0*a*e*r); // TODO simplify
-			radialAngle = radialAngle > 1.0 ? 1.0 : (radialAngle < -1.0 ? -1.0 : radialAngle);
-			radialAngle = acos(radialAngle);
-
-			// TODO why those quadrants ???
-			if ((relativeVelocity.x() > 0.0 && relativeVelocity.y() > 0.0) || (relativeVelocity.x() < 0.0 && relativeVelocity.y() < 0.0))
-				radialAngle = -radialAngle;
-
-			ret.Rotate(radialAngle);
-		}
-		else if (ret.GetType() == Conic::hyperbola)
-		{
-			Hyperbola hyperbola = ret.GetHyperbola();
-			double r = offset.x(), a = hyperbola.radius.x(), e = hyperbola.GetEccentricity();
-
-			// there are two solutions for z: z = r - 2a, z = r + 2a
-			double x = r, y = 2.0*a*e, z = r + 2 * a;
-			//z = r - 2 * a; // TODO which one
-
-			double radialAngle = (x*x + y*y - z*z)/(2.0*x*y);
-			radialAngle = radialAngle > 1.0 ? 1.0 : (radialAngle < -1.0 ? -1.0 : radialAngle);
-			radialAngle = acos(radialAngle);
-
-			// TODO what is this ???
-			radialAngle = Utils::Pi - radialAngle;
-
-			// TODO why those quadrants ???
-			if ((relativeVelocity.x() > 0.0 && relativeVelocity.y() > 0.0) || (relativeVelocity.x() < 0.0 && relativeVelocity.y() < 0.0))
-				radialAngle = -radialAngle;
-
-			ret.Rotate(radialAngle);
-		}
-		else if (ret.GetType() == Conic::parabola)
-		{
-			//assert(false);
-		}
-
-		return ret;
-	}
 }
@@ -61,7 +61,4 @@ namespace ConicApproximation
 
 	Conic ApproximateConic(std::vector<Magnum2D::vec2d>& positions);
 	Conic ApproximateConic(std::span<Magnum2D::vec2d>& positions);
-
-	Conic ComputeConic(double mass1, double mass2, const Magnum2D::vec2d & position2, const Magnum2D::vec2d & velocity2);
-
 }
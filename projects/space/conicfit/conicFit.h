@@ -1,5 +1,6 @@
 #pragma once
 #include "Eigen/Eigen"
+#include <algorithm>
 
 // *****************************************************************************
 // This code is taken from github. All credit belongs to ptahmose.
@@ -250,28 +251,45 @@ namespace ConicFit
 		{
 			auto numOfPoints = ptAccessor.GetLength();
 			tFloat mx, my; tFloat minX, minY, maxX, maxY;
-			CalcMeanMinMax([&](int index)->tFloat {return ptAccessor.GetX(index); }, ptAccessor.GetLength(), mx, minX, maxX);
-			CalcMeanMinMax([&](int index)->tFloat {return ptAccessor.GetY(index); }, ptAccessor.GetLength(), my, minY, maxY);
+			CalcMeanMinMax([&](size_t index)->tFloat {return ptAccessor.GetX(index); }, ptAccessor.GetLength(), mx, minX, maxX);
+			CalcMeanMinMax([&](size_t index)->tFloat {return ptAccessor.GetY(index); }, ptAccessor.GetLength(), my, minY, maxY);
 			tFloat sx = (maxX - minX) / 2;
 			tFloat sy = (maxY - minY) / 2;
 
-			tFloat scatterM[6 * 6];
-			for (int r = 0; r < 6; ++r)
+			// design rows (x^2, xy, y^2, x, y, 1) are formed once per point, in blocks which stay in cache,
+			// only upper triangle of symmetric scatter matrix is accumulated (dot products vectorized by eigen)
+			const tFloat invSx = 1 / sx, invSy = 1 / sy;
+			Eigen::Matrix<tFloat, 6, 6> scatter = Eigen::Matrix<tFloat, 6, 6>::Zero();
+			Eigen::Matrix<tFloat, 6, ScatterBlockSize, Eigen::RowMajor> design;
+			for (size_t begin = 0; begin < numOfPoints; begin += ScatterBlockSize)
 			{
-				for (int c = 0; c < 6; ++c)
+				const Eigen::Index count = (Eigen::Index)std::min<size_t>(ScatterBlockSize, numOfPoints - begin);
+				for (Eigen::Index k = 0; k < count; ++k)
+				{
+					tFloat x = (ptAccessor.GetX(begin + k) - mx) * invSx;
+					tFloat y = (ptAccessor.GetY(begin + k) - my) * invSy;
+					design(0, k) = x*x;
+					design(1, k) = x*y;
+					design(2, k) = y*y;
+					design(3, k) = x;
+					design(4, k) = y;
+					design(5, k) = 1;
+				}
+				for (int r = 0; r < 6; ++r)
 				{
-					tFloat v = 0;
-					for (size_t k = 0; k < numOfPoints; ++k)
+					for (int c = r; c < 6; ++c)
 					{
-						tFloat x = ptAccessor.GetX(k); tFloat y = ptAccessor.GetY(k);
-						x = (x - mx) / sx;
-						y = (y - my) / sy;
-						tFloat v1 = CalcDesignMatrixValue(r, x, y);
-						tFloat v2 = CalcDesignMatrixValue(c, x, y);
-						v += v1*v2;
+						scatter(r, c) += design.row(r).head(count).dot(design.row(c).head(count));
 					}
+				}
+			}
 
-					scatterM[r * 6 + c] = v;
+			tFloat scatterM[6 * 6];
+			for (int r = 0; r < 6; ++r)
+			{
+				for (int c = 0; c < 6; ++c)
+				{
+					scatterM[r * 6 + c] = r <= c ? scatter(r, c) : scatter(c, r);
 				}
 			}
 
@@ -331,22 +349,11 @@ namespace ConicFit
 		}
 
 	private:
-		static tFloat CalcDesignMatrixValue(int col,tFloat x, tFloat y)
-		{
-			switch (col)
-			{
-			case 0:return x*x;
-			case 1:return x*y;
-			case 2:return y*y;
-			case 3:return x;
-			case 4:return y;
-			case 5:return 1;
-			}
-
-			throw std::logic_error("Only expecting col to be in the range 0 to 5.");
-		}
+		// points of one block of design matrix
+		static const int ScatterBlockSize = 256;
 
-		static void CalcMeanMinMax(const std::function<tFloat(int)> getVal, size_t count, tFloat& mean, tFloat& min, tFloat& max)
+		template <typename Getter>
+		static void CalcMeanMinMax(const Getter& getVal, size_t count, tFloat& mean, tFloat& min, tFloat& max)
 		{
 			min = (std::numeric_limits<tFloat>::max)();
 			max = (std::numeric_limits<tFloat>::min)();
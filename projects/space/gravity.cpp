@@ -0,0 +1,284 @@
+#include "gravity.h"
+#include "gravityKernel.h"
+#include "utils.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Magnum2D;
+
+extern double GravitationalConstant;
+
+namespace Gravity
+{
+	void ComputeDirect(std::span<const vec2d> positions, std::span<const double> masses, std::span<vec2d> accelerations)
+	{
+		ComputeDirect(positions, masses, accelerations, 0, positions.size());
+	}
+
+	void ComputeDirect(std::span<const vec2d> positions, std::span<const double> masses, std::span<vec2d> accelerations, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			vec2d result;
+
+			for (size_t j = 0; j < positions.size(); j++)
+			{
+				if (i == j)
+					continue;
+
+				vec2d dir = positions[j] - positions[i];
+				double distanceSqr = dir.x() * dir.x() + dir.y() * dir.y();
+
+				if (distanceSqr == 0.0)
+					continue;
+
+				double distance = std::sqrt(distanceSqr);
+				result += (GravitationalConstant * masses[j] / (distanceSqr * distance)) * dir;
+			}
+
+			accelerations[i] = result;
+		}
+	}
+
+	void ComputeDirectCompensated(std::span<const vec2d> positions, std::span<const vec2d> positionErrors, std::span<const double> masses,
+								  std::span<vec2d> accelerations, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			vec2d result, error;
+
+			for (size_t j = 0; j < positions.size(); j++)
+			{
+				if (i == j)
+					continue;
+
+				// difference of close positions is exact, errors add bits lost by rounding of positions
+				vec2d dir = positions[j] - positions[i];
+				if (!positionErrors.empty())
+					dir += positionErrors[j] - positionErrors[i];
+				double distanceSqr = dir.x() * dir.x() + dir.y() * dir.y();
+
+				if (distanceSqr == 0.0)
+					continue;
+
+				double distance = std::sqrt(distanceSqr);
+				Utils::AddCompensated(result, error, (GravitationalConstant * masses[j] / (distanceSqr * distance)) * dir);
+			}
+
+			accelerations[i] = result + error;
+		}
+	}
+
+	void AccumulateSymmetric(std::span<const vec2d> positions, std::span<const double> masses, std::span<vec2d> accelerations, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			vec2d result;
+
+			for (size_t j = i + 1; j < positions.size(); j++)
+			{
+				vec2d dir = positions[j] - positions[i];
+				double distanceSqr = dir.x() * dir.x() + dir.y() * dir.y();
+
+				if (distanceSqr == 0.0)
+					continue;
+
+				// common part of both accelerations, a = G * m / r^2 in direction to other body
+				double distance = std::sqrt(distanceSqr);
+				double factor = GravitationalConstant / (distanceSqr * distance);
+
+				result += (factor * masses[j]) * dir;
+				accelerations[j] -= (factor * masses[i]) * dir;
+			}
+
+			accelerations[i] += result;
+		}
+	}
+
+	// Split rows of the pair triangle to ranges with roughly equal number of pairs.
+	// Row i contains pairs (i, j) for j > i.
+	static std::vector<size_t> SplitPairRows(size_t count, size_t parts)
+	{
+		std::vector<size_t> result(parts + 1, count);
+		result[0] = 0;
+
+		const double totalPairs = (double)count * (double)(count - 1) / 2.0;
+		double pairs = 0.0;
+		size_t part = 1;
+
+		for (size_t i = 0; i < count && part < parts; i++)
+		{
+			pairs += (double)(count - 1 - i);
+			if (pairs >= totalPairs * (double)part / (double)parts)
+				result[part++] = i + 1;
+		}
+
+		return result;
+	}
+
+	void Solver::ComputeSymmetricParallel(std::span<const vec2d> positions, std::span<const double> masses, std::span<vec2d> accelerations)
+	{
+		const size_t threads = pool->GetThreadCount();
+		const size_t count = positions.size();
+
+		buffers.resize(threads);
+		auto rows = SplitPairRows(count, threads);
+
+		// one task per thread, each with its own buffer, so nothing is written concurrently
+		pool->ParallelFor(threads, [&](size_t begin, size_t end)
+		{
+			for (size_t t = begin; t < end; t++)
+			{
+				buffers[t].assign(count, {});
+				AccumulateSymmetric(positions, masses, buffers[t], rows[t], rows[t + 1]);
+			}
+		});
+
+		// reduce in fixed order, so the result depends only on number of threads
+		pool->ParallelFor(count, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				vec2d result;
+				for (size_t t = 0; t < threads; t++)
+					result += buffers[t][i];
+				accelerations[i] = result;
+			}
+		});
+	}
+
+	Solver::Solver(ThreadPool* pool)
+		: pool(pool)
+	{
+	}
+
+	void Solver::ForEachBody(size_t count, const ThreadPool::Func& func)
+	{
+		if (pool)
+			pool->ParallelFor(count, func);
+		else
+			func(0, count);
+	}
+
+	void Solver::Compute(const Settings& settings, std::span<const vec2d> positions, std::span<const double> masses, std::span<vec2d> accelerations, bool rebuild)
+	{
+		assert(positions.size() == masses.size() && positions.size() == accelerations.size());
+
+		switch (settings.method)
+		{
+		case Method::Direct:
+			ForEachBody(positions.size(), [&](size_t begin, size_t end)
+			{
+				if (settings.compensated)
+					ComputeDirectCompensated(positions, settings.positionErrors, masses, accelerations, begin, end);
+				else
+					ComputeDirect(positions, masses, accelerations, begin, end);
+			});
+			break;
+		case Method::BarnesHut:
+		{
+			if (rebuild || tree.IsEmpty())
+				tree.Build(positions, masses);
+			else
+				tree.Refit(positions);
+
+			ForEachBody(positions.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+					accelerations[i] = tree.ComputeAcceleration(positions[i], i, settings.openingAngle);
+			});
+		}
+		break;
+		case Method::Symmetric:
+		{
+			if (settings.compensated)
+			{
+				ForEachBody(positions.size(), [&](size_t begin, size_t end)
+				{
+					ComputeDirectCompensated(positions, settings.positionErrors, masses, accelerations, begin, end);
+				});
+			}
+			else if (pool && pool->GetThreadCount() > 1 && positions.size() > 1)
+			{
+				ComputeSymmetricParallel(positions, masses, accelerations);
+			}
+			else
+			{
+				std::fill(std::begin(accelerations), std::end(accelerations), vec2d{});
+				AccumulateSymmetric(positions, masses, accelerations, 0, positions.size());
+			}
+		}
+		break;
+		case Method::Vectorized:
+		{
+			if (store.size() != positions.size())
+				store.resize(positions.size());
+
+			store.SetPositions(positions);
+			store.SetMasses(masses);
+
+			ForEachBody(positions.size(), [&](size_t begin, size_t end)
+			{
+				GravityKernel::ComputeAccelerations(store, begin, end);
+			});
+
+			store.GetAccelerations(accelerations);
+		}
+		break;
+		}
+	}
+
+	void Solver::ComputeActive(const Settings& settings, std::span<const vec2d> positions, std::span<const double> masses, std::span<vec2d> accelerations, std::span<const size_t> active, bool rebuild)
+	{
+		assert(positions.size() == masses.size() && positions.size() == accelerations.size());
+
+		switch (settings.method)
+		{
+		case Method::Direct:
+		case Method::Symmetric:
+			ForEachBody(active.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					if (settings.compensated)
+						ComputeDirectCompensated(positions, settings.positionErrors, masses, accelerations, active[i], active[i] + 1);
+					else
+						ComputeDirect(positions, masses, accelerations, active[i], active[i] + 1);
+				}
+			});
+			break;
+		case Method::BarnesHut:
+		{
+			if (rebuild || tree.IsEmpty())
+				tree.Build(positions, masses);
+			else
+				tree.Refit(positions);
+
+			ForEachBody(active.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+					accelerations[active[i]] = tree.ComputeAcceleration(positions[active[i]], active[i], settings.openingAngle);
+			});
+		}
+		break;
+		case Method::Vectorized:
+		{
+			if (store.size() != positions.size())
+				store.resize(positions.size());
+
+			store.SetPositions(positions);
+			store.SetMasses(masses);
+
+			ForEachBody(active.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					GravityKernel::ComputeAccelerations(store, active[i], active[i] + 1);
+					accelerations[active[i]] = { store.ax[active[i]], store.ay[active[i]] };
+				}
+			});
+		}
+		break;
+		}
+	}
+}
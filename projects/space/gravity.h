@@ -0,0 +1,76 @@
+#pragma once
+#include "quadTree.h"
+#include "bodyStore.h"
+#include "threadPool.h"
+#include <Magnum2D.h>
+#include <vector>
+#include <span>
+
+namespace Gravity
+{
+	enum class Method : int32_t
+	{
+		Direct = 0, // exact O(N^2) pairwise sum
+		BarnesHut,  // O(N log N) quadtree approximation
+		Vectorized, // exact O(N^2) pairwise sum on structure of arrays with SIMD kernel
+		Symmetric   // exact pairwise sum evaluating each pair once (Newton's third law)
+	};
+
+	struct Settings
+	{
+		Method method = Method::Direct;
+		// Barnes-Hut node is approximated by its center of mass when size / distance < openingAngle
+		double openingAngle = 0.5;
+		// worker threads for force evaluation and per-body loops of integrators
+		size_t threads = 1;
+		// compensated summation of direct sum (Direct method, Symmetric falls back to it),
+		// set by Simulation::CompensatedPrecision
+		bool compensated = false;
+		// optional low parts of compensated positions (position + error), used by compensated sum
+		std::span<const Magnum2D::vec2d> positionErrors;
+	};
+
+	// Computes accelerations of set of bodies caused by each other. Internal buffers (e.g. quadtree)
+	// are kept between calls so the solver should live for the whole simulation.
+	struct Solver
+	{
+		// when pool is given, accelerations of bodies are computed in parallel
+		explicit Solver(ThreadPool* pool = nullptr);
+
+		// When rebuild is false and Barnes-Hut is used, tree from previous call is only refitted
+		// to new positions. This is meant for stages of single integration step, where bodies
+		// are moved only slightly.
+		void Compute(const Settings& settings, std::span<const Magnum2D::vec2d> positions, std::span<const double> masses,
+					 std::span<Magnum2D::vec2d> accelerations, bool rebuild = true);
+
+		// Accelerations only of bodies listed in active, the others are left untouched. Used by
+		// block time steps where only bodies at the end of their step need new acceleration.
+		// Symmetric method falls back to direct sum, pairs can't be shared with inactive bodies.
+		void ComputeActive(const Settings& settings, std::span<const Magnum2D::vec2d> positions, std::span<const double> masses,
+						   std::span<Magnum2D::vec2d> accelerations, std::span<const size_t> active, bool rebuild = true);
+
+	private:
+		void ForEachBody(size_t count, const ThreadPool::Func& func);
+
+		void ComputeSymmetricParallel(std::span<const Magnum2D::vec2d> positions, std::span<const double> masses, std::span<Magnum2D::vec2d> accelerations);
+
+		ThreadPool* pool;
+		QuadTree tree;
+		BodyStore store;
+		// accumulation buffer per thread for symmetric method
+		std::vector<std::vector<Magnum2D::vec2d>> buffers;
+	};
+
+	void ComputeDirect(std::span<const Magnum2D::vec2d> positions, std::span<const double> masses, std::span<Magnum2D::vec2d> accelerations);
+	// accelerations only of bodies [begin, end) caused by all bodies
+	void ComputeDirect(std::span<const Magnum2D::vec2d> positions, std::span<const double> masses, std::span<Magnum2D::vec2d> accelerations, size_t begin, size_t end);
+
+	// same as ComputeDirect with Neumaier summation of contributions of bodies, directions between
+	// bodies include optional position errors (empty or one per body)
+	void ComputeDirectCompensated(std::span<const Magnum2D::vec2d> positions, std::span<const Magnum2D::vec2d> positionErrors, std::span<const double> masses,
+								  std::span<Magnum2D::vec2d> accelerations, size_t begin, size_t end);
+
+	// Each pair (i, j), i < j, is evaluated once and opposite accelerations are added to both bodies.
+	// Only pairs with i in [begin, end) are evaluated, accelerations are accumulated (not cleared).
+	void AccumulateSymmetric(std::span<const Magnum2D::vec2d> positions, std::span<const double> masses, std::span<Magnum2D::vec2d> accelerations, size_t begin, size_t end);
+}
@@ -0,0 +1,165 @@
+#include "gravityKernel.h"
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SPACE_GRAVITY_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPACE_GRAVITY_SSE2
+#endif
+
+extern double GravitationalConstant;
+
+namespace GravityKernel
+{
+	// sum of m * d / r^3 over sources [begin, end), gravitational constant is applied by caller
+	static void AccumulateScalar(const BodyStore& store, double xi, double yi, size_t begin, size_t end, double& sumx, double& sumy)
+	{
+		for (size_t j = begin; j < end; j++)
+		{
+			double dx = store.x[j] - xi;
+			double dy = store.y[j] - yi;
+			double distanceSqr = dx * dx + dy * dy;
+
+			if (distanceSqr == 0.0)
+				continue;
+
+			double f = store.m[j] / (distanceSqr * std::sqrt(distanceSqr));
+			sumx += f * dx;
+			sumy += f * dy;
+		}
+	}
+
+	void ComputeAccelerationsScalar(BodyStore& store, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			double sumx = 0.0, sumy = 0.0;
+			AccumulateScalar(store, store.x[i], store.y[i], 0, store.size(), sumx, sumy);
+
+			store.ax[i] = GravitationalConstant * sumx;
+			store.ay[i] = GravitationalConstant * sumy;
+		}
+	}
+
+#if defined(SPACE_GRAVITY_AVX2)
+	static double HorizontalSum(__m256d v)
+	{
+		__m128d low = _mm256_castpd256_pd128(v);
+		__m128d high = _mm256_extractf128_pd(v, 1);
+		low = _mm_add_pd(low, high);
+		high = _mm_unpackhi_pd(low, low);
+		return _mm_cvtsd_f64(_mm_add_sd(low, high));
+	}
+
+	// sum of m * d / r^3 over all sources, gravitational constant is applied by caller
+	static void Accumulate(const BodyStore& store, double xi, double yi, double& x, double& y)
+	{
+		const size_t count = store.size();
+		const size_t vectorCount = count - count % 4;
+		const __m256d zero = _mm256_setzero_pd();
+		const __m256d px = _mm256_set1_pd(xi);
+		const __m256d py = _mm256_set1_pd(yi);
+		__m256d sumx = zero, sumy = zero;
+
+		for (size_t j = 0; j < vectorCount; j += 4)
+		{
+			__m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&store.x[j]), px);
+			__m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&store.y[j]), py);
+			__m256d distanceSqr = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+			// lanes with zero distance (the body itself) divide by zero, they are masked out
+			__m256d mask = _mm256_cmp_pd(distanceSqr, zero, _CMP_NEQ_OQ);
+			__m256d f = _mm256_div_pd(_mm256_loadu_pd(&store.m[j]), _mm256_mul_pd(distanceSqr, _mm256_sqrt_pd(distanceSqr)));
+			f = _mm256_and_pd(f, mask);
+
+			sumx = _mm256_add_pd(sumx, _mm256_mul_pd(f, dx));
+			sumy = _mm256_add_pd(sumy, _mm256_mul_pd(f, dy));
+		}
+
+		x = HorizontalSum(sumx);
+		y = HorizontalSum(sumy);
+		AccumulateScalar(store, xi, yi, vectorCount, count, x, y);
+	}
+
+	const char* GetInstructionSet()
+	{
+		return "AVX2";
+	}
+#elif defined(SPACE_GRAVITY_SSE2)
+	static double HorizontalSum(__m128d v)
+	{
+		__m128d high = _mm_unpackhi_pd(v, v);
+		return _mm_cvtsd_f64(_mm_add_sd(v, high));
+	}
+
+	// sum of m * d / r^3 over all sources, gravitational constant is applied by caller
+	static void Accumulate(const BodyStore& store, double xi, double yi, double& x, double& y)
+	{
+		const size_t count = store.size();
+		const size_t vectorCount = count - count % 2;
+		const __m128d zero = _mm_setzero_pd();
+		const __m128d px = _mm_set1_pd(xi);
+		const __m128d py = _mm_set1_pd(yi);
+		__m128d sumx = zero, sumy = zero;
+
+		for (size_t j = 0; j < vectorCount; j += 2)
+		{
+			__m128d dx = _mm_sub_pd(_mm_loadu_pd(&store.x[j]), px);
+			__m128d dy = _mm_sub_pd(_mm_loadu_pd(&store.y[j]), py);
+			__m128d distanceSqr = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+			// lanes with zero distance (the body itself) divide by zero, they are masked out
+			__m128d mask = _mm_cmpneq_pd(distanceSqr, zero);
+			__m128d f = _mm_div_pd(_mm_loadu_pd(&store.m[j]), _mm_mul_pd(distanceSqr, _mm_sqrt_pd(distanceSqr)));
+			f = _mm_and_pd(f, mask);
+
+			sumx = _mm_add_pd(sumx, _mm_mul_pd(f, dx));
+			sumy = _mm_add_pd(sumy, _mm_mul_pd(f, dy));
+		}
+
+		x = HorizontalSum(sumx);
+		y = HorizontalSum(sumy);
+		AccumulateScalar(store, xi, yi, vectorCount, count, x, y);
+	}
+
+	const char* GetInstructionSet()
+	{
+		return "SSE2";
+	}
+#else
+	static void Accumulate(const BodyStore& store, double xi, double yi, double& x, double& y)
+	{
+		x = y = 0.0;
+		AccumulateScalar(store, xi, yi, 0, store.size(), x, y);
+	}
+
+	const char* GetInstructionSet()
+	{
+		return "Scalar";
+	}
+#endif
+
+	void ComputeAccelerations(BodyStore& store, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			double x, y;
+			Accumulate(store, store.x[i], store.y[i], x, y);
+
+			store.ax[i] = GravitationalConstant * x;
+			store.ay[i] = GravitationalConstant * y;
+		}
+	}
+
+	void ComputeAccelerations(BodyStore& store)
+	{
+		ComputeAccelerations(store, 0, store.size());
+	}
+
+	Magnum2D::vec2d ComputeAcceleration(const BodyStore& store, const Magnum2D::vec2d& position)
+	{
+		double x, y;
+		Accumulate(store, position.x(), position.y(), x, y);
+		return { GravitationalConstant * x, GravitationalConstant * y };
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "bodyStore.h"
+
+// Vectorized pairwise gravity on structure of arrays data. Instruction set is chosen at compile
+// time: AVX2 (when compiled with SPACE_ENABLE_AVX2), SSE2 (any x64 build) or scalar fallback.
+namespace GravityKernel
+{
+	// Compute store.ax, store.ay for bodies [begin, end) caused by all bodies in the store.
+	// Body does not attract itself (neither any other body at exactly the same position).
+	void ComputeAccelerations(BodyStore& store, size_t begin, size_t end);
+	void ComputeAccelerations(BodyStore& store);
+	// acceleration at position caused by all bodies in the store (external point, e.g. body attracted by ephemerides)
+	Magnum2D::vec2d ComputeAcceleration(const BodyStore& store, const Magnum2D::vec2d& position);
+
+	// scalar version, reference for the vectorized ones
+	void ComputeAccelerationsScalar(BodyStore& store, size_t begin, size_t end);
+
+	const char* GetInstructionSet();
+}
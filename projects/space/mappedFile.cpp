@@ -0,0 +1,65 @@
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	if (!data)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path)
+{
+	auto result = std::make_shared<MappedFile>();
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER size;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+		mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	// view keeps the file open
+	CloseHandle(file);
+	if (!mapping)
+		return nullptr;
+
+	result->data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+	result->size = (size_t)size.QuadPart;
+	CloseHandle(mapping);
+	if (!result->data)
+		return nullptr;
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return nullptr;
+
+	struct stat status;
+	void* data = MAP_FAILED;
+	if (fstat(file, &status) == 0 && status.st_size > 0)
+		data = mmap(nullptr, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	// mapping keeps the file open
+	close(file);
+	if (data == MAP_FAILED)
+		return nullptr;
+
+	result->data = static_cast<char*>(data);
+	result->size = (size_t)status.st_size;
+#endif
+	return result;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+
+// Whole file mapped copy on write, data may be modified in memory without changing the file. File
+// can't be replaced on Windows while it is mapped.
+struct MappedFile
+{
+	char* data = nullptr;
+	size_t size = 0;
+
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	// null when file doesn't exist or is empty
+	static std::shared_ptr<MappedFile> Open(const std::filesystem::path& path);
+};
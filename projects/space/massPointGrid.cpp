@@ -0,0 +1,105 @@
+#include "massPointGrid.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Magnum2D;
+
+void MassPointGrid::Build(const std::vector<MassPoint>& massPoints)
+{
+	std::vector<Source> points;
+	points.reserve(massPoints.size());
+	for (size_t i = 0; i < massPoints.size(); i++)
+		points.push_back({ massPoints[i].position, GravitationalConstant * massPoints[i].getMass(), massPoints[i].getEffectiveRadiusSqr(), (uint32_t)i });
+
+	Build(std::move(points));
+}
+
+void MassPointGrid::Build(std::vector<Source> points)
+{
+	sources.clear();
+	cellStart.assign(1, 0);
+	columns = rows = 0;
+
+	// mass points without mass have no sphere
+	std::erase_if(points, [](const Source& point) { return !(point.effectiveRadiusSqr > 0.0); });
+	if (points.empty())
+		return;
+
+	vec2d max;
+	double radiusSum = 0.0;
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		const double radius = std::sqrt(points[i].effectiveRadiusSqr);
+		const vec2d low = points[i].position - vec2d{ radius, radius };
+		const vec2d high = points[i].position + vec2d{ radius, radius };
+
+		min = i == 0 ? low : vec2d{ std::min(min.x(), low.x()), std::min(min.y(), low.y()) };
+		max = i == 0 ? high : vec2d{ std::max(max.x(), high.x()), std::max(max.y(), high.y()) };
+		radiusSum += radius;
+	}
+
+	// cell of the size of average sphere, larger when spheres cover only small part of the area
+	// (or of long thin one), so there are at most few times MaxCellsPerMassPoint cells per mass point
+	const vec2d size = max - min;
+	const double maxCells = MaxCellsPerMassPoint * (double)points.size();
+	cellSize = std::max({ 2.0 * radiusSum / (double)points.size(), std::sqrt(size.x() * size.y() / maxCells), std::max(size.x(), size.y()) / maxCells });
+	invCellSize = 1.0 / cellSize;
+	columns = (uint32_t)std::max(std::ceil(size.x() * invCellSize), 1.0);
+	rows = (uint32_t)std::max(std::ceil(size.y() * invCellSize), 1.0);
+
+	auto getCell = [&](double value, double minValue, uint32_t count)
+	{
+		return (uint32_t)std::clamp((value - minValue) * invCellSize, 0.0, (double)(count - 1));
+	};
+
+	// counting sort of sources to cells, the first pass counts, the second fills
+	cellStart.assign((size_t)columns * rows + 1, 0);
+	for (int32_t pass = 0; pass < 2; pass++)
+	{
+		for (const auto& point : points)
+		{
+			const double radius = std::sqrt(point.effectiveRadiusSqr);
+			const uint32_t x0 = getCell(point.position.x() - radius, min.x(), columns), x1 = getCell(point.position.x() + radius, min.x(), columns);
+			const uint32_t y0 = getCell(point.position.y() - radius, min.y(), rows), y1 = getCell(point.position.y() + radius, min.y(), rows);
+
+			for (uint32_t y = y0; y <= y1; y++)
+			{
+				for (uint32_t x = x0; x <= x1; x++)
+				{
+					const size_t cell = (size_t)y * columns + x;
+					if (pass == 0)
+						cellStart[cell + 1]++;
+					else
+						sources[cellStart[cell]++] = point;
+				}
+			}
+		}
+
+		if (pass == 0)
+		{
+			for (size_t i = 1; i < cellStart.size(); i++)
+				cellStart[i] += cellStart[i - 1];
+			sources.resize(cellStart.back());
+		}
+		else
+		{
+			// filling moved each start to the start of the next cell
+			std::rotate(cellStart.rbegin(), cellStart.rbegin() + 1, cellStart.rend());
+			cellStart[0] = 0;
+		}
+	}
+}
+
+vec2d MassPointGrid::ComputeAcceleration(const vec2d& position) const
+{
+	vec2d result;
+
+	Query(position, [&](const Source& source, double distanceSqr)
+	{
+		if (distanceSqr == 0.0)
+			return;
+		result += (source.gravitationalParameter / (distanceSqr * std::sqrt(distanceSqr))) * (source.position - position);
+	});
+
+	return result;
+}
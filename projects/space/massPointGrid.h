@@ -0,0 +1,65 @@
+#pragma once
+#include "point.h"
+#include <Magnum2D.h>
+#include <vector>
+#include <cstdint>
+
+// Uniform grid over static mass points for culling by effective radius (sphere of influence).
+// Each mass point is stored in all cells overlapped by bounding box of its sphere, so query
+// visits a single cell and returns only mass points whose sphere contains the position.
+struct MassPointGrid
+{
+	// cells per mass point (on average), limits memory when spheres are small and far apart
+	static constexpr double MaxCellsPerMassPoint = 4.0;
+
+	struct Source
+	{
+		Magnum2D::vec2d position;
+		// G * mass
+		double gravitationalParameter = 0.0;
+		double effectiveRadiusSqr = 0.0;
+		// index to mass points grid was built from
+		uint32_t index = 0;
+	};
+
+	void Build(const std::vector<MassPoint>& massPoints);
+	// sources with any spheres (not only from mass points), index is kept as given
+	void Build(std::vector<Source> sources);
+
+	// calls callback(const Source&, double distanceSqr) for mass points with sphere containing position
+	template<class F>
+	void Query(const Magnum2D::vec2d& position, F&& callback) const
+	{
+		const double x = (position.x() - min.x()) * invCellSize;
+		const double y = (position.y() - min.y()) * invCellSize;
+		if (!(x >= 0.0 && y >= 0.0 && x < (double)columns && y < (double)rows))
+			return;
+
+		const size_t cell = (size_t)y * columns + (size_t)x;
+		for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; i++)
+		{
+			const Source& source = sources[i];
+			const double distanceSqr = (source.position - position).dot();
+			if (distanceSqr <= source.effectiveRadiusSqr)
+				callback(source, distanceSqr);
+		}
+	}
+
+	// same as Point::computeAcceleration without mass points whose sphere doesn't contain position
+	Magnum2D::vec2d ComputeAcceleration(const Magnum2D::vec2d& position) const;
+
+	size_t GetCellCount() const { return (size_t)columns * rows; }
+	// stored references to mass points, each is in one or more cells
+	size_t GetEntryCount() const { return sources.size(); }
+
+private:
+	Magnum2D::vec2d min;
+	double cellSize = 1.0;
+	double invCellSize = 1.0;
+	uint32_t columns = 0;
+	uint32_t rows = 0;
+
+	// sources of cell i are sources[cellStart[i], cellStart[i + 1])
+	std::vector<uint32_t> cellStart;
+	std::vector<Source> sources;
+};
@@ -0,0 +1,368 @@
+#include "orbit.h"
+#include "utils.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+using namespace Magnum2D;
+
+namespace Orbit
+{
+	static const double TwoPi = 2.0 * Utils::Pi;
+
+	// maximal iterations of batch elliptic solver, from the starting guess they converge also for eccentricity close to 1
+	static const int EllipticIterations = 10;
+	static const size_t EllipticBlockSize = 256;
+
+	// round to nearest without library call, valid for |x| < 2^51
+	static inline double Round(double x)
+	{
+		static const double Magic = 6755399441055744.0;
+		return (x + Magic) - Magic;
+	}
+
+	// sine and cosine without branches, so the loops calling it are vectorized, |x| should be few pi
+	static inline void SinCos(double x, double& sin, double& cos)
+	{
+		static const double PiHalfHigh = 1.5707963267948966;
+		static const double PiHalfLow = 6.123233995736766e-17;
+
+		const double quadrant = Round(x * (2.0 / Utils::Pi));
+		const double r = (x - quadrant * PiHalfHigh) - quadrant * PiHalfLow;
+		const double r2 = r * r;
+
+		// taylor series on [-pi/4, pi/4]
+		const double s = r + r * r2 * (-1.0 / 6.0 + r2 * (1.0 / 120.0 + r2 * (-1.0 / 5040.0 + r2 * (1.0 / 362880.0 + r2 * (-1.0 / 39916800.0 +
+			r2 * (1.0 / 6227020800.0 + r2 * (-1.0 / 1307674368000.0)))))));
+		const double c = 1.0 + r2 * (-0.5 + r2 * (1.0 / 24.0 + r2 * (-1.0 / 720.0 + r2 * (1.0 / 40320.0 + r2 * (-1.0 / 3628800.0 +
+			r2 * (1.0 / 479001600.0 + r2 * (-1.0 / 87178291200.0 + r2 * (1.0 / 20922789888000.0))))))));
+
+		// quadrant modulo 4, offset avoids ties of rounding
+		const double q = quadrant - 4.0 * Round(quadrant * 0.25 - 0.375);
+		const bool odd = q == 1.0 || q == 3.0;
+
+		sin = odd ? c : s;
+		cos = odd ? s : c;
+		sin = q >= 2.0 ? -sin : sin;
+		cos = q == 1.0 || q == 2.0 ? -cos : cos;
+	}
+
+	static double ReduceAngle(double angle)
+	{
+		return angle - TwoPi * Round(angle / TwoPi);
+	}
+
+	Elements::Type Elements::GetType() const
+	{
+		if (std::fabs(eccentricity - 1.0) < ParabolicTolerance)
+			return parabola;
+		return eccentricity < 1.0 ? ellipse : hyperbola;
+	}
+
+	double Elements::GetSemiMajorAxis() const
+	{
+		if (GetType() == parabola)
+			return std::numeric_limits<double>::infinity();
+		return semiLatusRectum / (1.0 - eccentricity * eccentricity);
+	}
+
+	double Elements::GetMeanMotion() const
+	{
+		if (GetType() == parabola)
+			return 2.0 * std::sqrt(mu / (semiLatusRectum * semiLatusRectum * semiLatusRectum));
+
+		const double a = std::fabs(GetSemiMajorAxis());
+		return std::sqrt(mu / (a * a * a));
+	}
+
+	double Elements::GetPeriod() const
+	{
+		if (GetType() != ellipse)
+			return std::numeric_limits<double>::infinity();
+		return TwoPi / GetMeanMotion();
+	}
+
+	double Elements::GetPeriapsis() const
+	{
+		return semiLatusRectum / (1.0 + eccentricity);
+	}
+
+	double Elements::GetApoapsis() const
+	{
+		if (GetType() != ellipse)
+			return std::numeric_limits<double>::infinity();
+		return semiLatusRectum / (1.0 - eccentricity);
+	}
+
+	double Elements::GetMaxTrueAnomaly() const
+	{
+		switch (GetType())
+		{
+		case ellipse:
+			return std::numeric_limits<double>::infinity();
+		case parabola:
+			return Utils::Pi;
+		default:
+			return std::acos(-1.0 / eccentricity);
+		}
+	}
+
+	double Elements::GetRadius(double trueAnomaly) const
+	{
+		return semiLatusRectum / (1.0 + eccentricity * std::cos(trueAnomaly));
+	}
+
+	vec2d Elements::GetPosition(double trueAnomaly) const
+	{
+		const double r = GetRadius(trueAnomaly);
+		return Utils::RotateVector(vec2d{ r * std::cos(trueAnomaly), direction * r * std::sin(trueAnomaly) }, argumentOfPeriapsis);
+	}
+
+	vec2d Elements::GetVelocity(double trueAnomaly) const
+	{
+		const double v = std::sqrt(mu / semiLatusRectum);
+		return Utils::RotateVector(vec2d{ -v * std::sin(trueAnomaly), direction * v * (eccentricity + std::cos(trueAnomaly)) }, argumentOfPeriapsis);
+	}
+
+	static double GetMeanAnomaly(const Elements& elements, double trueAnomaly)
+	{
+		const double e = elements.eccentricity;
+		switch (elements.GetType())
+		{
+		case Elements::ellipse:
+		{
+			const double E = 2.0 * std::atan2(std::sqrt(1.0 - e) * std::sin(trueAnomaly / 2.0), std::sqrt(1.0 + e) * std::cos(trueAnomaly / 2.0));
+			return E - e * std::sin(E);
+		}
+		case Elements::parabola:
+		{
+			const double D = std::tan(trueAnomaly / 2.0);
+			return D + D * D * D / 3.0;
+		}
+		default:
+		{
+			const double H = 2.0 * std::atanh(std::sqrt((e - 1.0) / (e + 1.0)) * std::tan(trueAnomaly / 2.0));
+			return e * std::sinh(H) - H;
+		}
+		}
+	}
+
+	Elements FromState(double mu, const vec2d& position, const vec2d& velocity)
+	{
+		const double r = position.length();
+		const double angularMomentum = position.x() * velocity.y() - position.y() * velocity.x();
+		const double radialVelocity = position.x() * velocity.x() + position.y() * velocity.y();
+		const double velocitySqr = velocity.x() * velocity.x() + velocity.y() * velocity.y();
+
+		const vec2d eccentricityVector = ((velocitySqr - mu / r) * position - radialVelocity * velocity) / mu;
+
+		Elements result;
+		result.mu = mu;
+		result.semiLatusRectum = angularMomentum * angularMomentum / mu;
+		result.eccentricity = eccentricityVector.length();
+		// circular orbit has periapsis at x axis
+		result.argumentOfPeriapsis = std::atan2(eccentricityVector.y(), eccentricityVector.x());
+		result.direction = angularMomentum < 0.0 ? -1.0 : 1.0;
+
+		const double trueAnomaly = ReduceAngle(result.direction * (std::atan2(position.y(), position.x()) - result.argumentOfPeriapsis));
+		result.meanAnomaly = GetMeanAnomaly(result, trueAnomaly);
+
+		return result;
+	}
+
+	Elements Propagate(const Elements& elements, double time)
+	{
+		Elements result = elements;
+		result.meanAnomaly += elements.GetMeanMotion() * time;
+		return result;
+	}
+
+	double GetTrueAnomaly(const Elements& elements)
+	{
+		const double e = elements.eccentricity;
+		switch (elements.GetType())
+		{
+		case Elements::ellipse:
+		{
+			const double E = SolveKeplerElliptic(ReduceAngle(elements.meanAnomaly), e);
+			return 2.0 * std::atan2(std::sqrt(1.0 + e) * std::sin(E / 2.0), std::sqrt(1.0 - e) * std::cos(E / 2.0));
+		}
+		case Elements::parabola:
+			return 2.0 * std::atan(SolveKeplerParabolic(elements.meanAnomaly));
+		default:
+		{
+			const double H = SolveKeplerHyperbolic(elements.meanAnomaly, e);
+			return 2.0 * std::atan(std::sqrt((e + 1.0) / (e - 1.0)) * std::tanh(H / 2.0));
+		}
+		}
+	}
+
+	void ToState(const Elements& elements, vec2d& position, vec2d& velocity)
+	{
+		const double trueAnomaly = GetTrueAnomaly(elements);
+		position = elements.GetPosition(trueAnomaly);
+		velocity = elements.GetVelocity(trueAnomaly);
+	}
+
+	double SolveKeplerElliptic(double meanAnomaly, double eccentricity)
+	{
+		const double M = ReduceAngle(meanAnomaly);
+
+		double E = M + std::copysign(0.85 * eccentricity, M);
+		for (int i = 0; i < 50; i++)
+		{
+			const double delta = (E - eccentricity * std::sin(E) - M) / (1.0 - eccentricity * std::cos(E));
+			E -= delta;
+			if (std::fabs(delta) < 1e-14)
+				break;
+		}
+
+		return E + (meanAnomaly - M);
+	}
+
+	double SolveKeplerHyperbolic(double meanAnomaly, double eccentricity)
+	{
+		// equation is odd, it's solved for positive M, where it's convex. Both guesses are at or after
+		// the root (sinh(H) >= H + H^3 / 6), so newton converges from there monotonically.
+		const double M = std::fabs(meanAnomaly);
+		double H = std::min(std::cbrt(6.0 * M), std::asinh(M / (eccentricity - 1.0)));
+		for (int i = 0; i < 100; i++)
+		{
+			const double delta = (eccentricity * std::sinh(H) - H - M) / (eccentricity * std::cosh(H) - 1.0);
+			H -= delta;
+			if (std::fabs(delta) < 1e-14 * std::max(1.0, H))
+				break;
+		}
+
+		return std::copysign(H, meanAnomaly);
+	}
+
+	double SolveKeplerParabolic(double meanAnomaly)
+	{
+		// D^3 + 3D - 3M = 0 (cardano)
+		const double q = 1.5 * meanAnomaly;
+		const double s = std::sqrt(q * q + 1.0);
+		return std::cbrt(q + s) + std::cbrt(q - s);
+	}
+
+	void SolveKeplerElliptic(std::span<const double> meanAnomaly, std::span<const double> eccentricity, std::span<double> eccentricAnomaly)
+	{
+		const size_t count = std::min({ meanAnomaly.size(), eccentricity.size(), eccentricAnomaly.size() });
+
+		// iterations go over blocks of orbits, so the innermost loops are over independent orbits
+		double M[EllipticBlockSize], e[EllipticBlockSize], E[EllipticBlockSize], step[EllipticBlockSize];
+		for (size_t begin = 0; begin < count; begin += EllipticBlockSize)
+		{
+			const size_t size = std::min(EllipticBlockSize, count - begin);
+
+			// halley iterations from danby's starting guess
+			for (size_t i = 0; i < size; i++)
+			{
+				M[i] = ReduceAngle(meanAnomaly[begin + i]);
+				e[i] = eccentricity[begin + i];
+				E[i] = M[i] + std::copysign(0.85 * e[i], M[i]);
+			}
+
+			// whole block stops when all its orbits converged
+			for (int iteration = 0; iteration < EllipticIterations; iteration++)
+			{
+				for (size_t i = 0; i < size; i++)
+				{
+					double sin, cos;
+					SinCos(E[i], sin, cos);
+
+					const double f = E[i] - e[i] * sin - M[i];
+					const double df = 1.0 - e[i] * cos;
+					const double delta = f / (df - 0.5 * f * e[i] * sin / df);
+					E[i] -= delta;
+					step[i] = std::fabs(delta);
+				}
+				if (std::all_of(step, step + size, [](double value) { return value < 1e-14; }))
+					break;
+			}
+
+			for (size_t i = 0; i < size; i++)
+				eccentricAnomaly[begin + i] = E[i] + (meanAnomaly[begin + i] - M[i]);
+		}
+	}
+
+	void FromStates(std::span<const double> mu, std::span<const vec2d> positions, std::span<const vec2d> velocities, std::span<Elements> elements)
+	{
+		for (size_t i = 0; i < elements.size(); i++)
+			elements[i] = FromState(mu[i], positions[i], velocities[i]);
+	}
+
+	void GetStates(std::span<const Elements> elements, double time, std::span<vec2d> positions, std::span<vec2d> velocities)
+	{
+		// elliptic orbits are solved together, the rest one by one
+		std::vector<size_t> elliptic;
+		std::vector<double> meanAnomaly, eccentricity;
+		elliptic.reserve(elements.size());
+		meanAnomaly.reserve(elements.size());
+		eccentricity.reserve(elements.size());
+
+		for (size_t i = 0; i < elements.size(); i++)
+		{
+			if (elements[i].GetType() == Elements::ellipse)
+			{
+				elliptic.push_back(i);
+				meanAnomaly.push_back(elements[i].meanAnomaly + elements[i].GetMeanMotion() * time);
+				eccentricity.push_back(elements[i].eccentricity);
+			}
+			else
+			{
+				ToState(Propagate(elements[i], time), positions[i], velocities[i]);
+			}
+		}
+
+		std::vector<double> eccentricAnomaly(elliptic.size());
+		SolveKeplerElliptic(meanAnomaly, eccentricity, eccentricAnomaly);
+
+		for (size_t j = 0; j < elliptic.size(); j++)
+		{
+			const Elements& orbit = elements[elliptic[j]];
+			const double e = orbit.eccentricity;
+			const double a = orbit.GetSemiMajorAxis();
+			const double b = a * std::sqrt(1.0 - e * e);
+
+			double sinE, cosE, sinW, cosW;
+			SinCos(ReduceAngle(eccentricAnomaly[j]), sinE, cosE);
+			SinCos(ReduceAngle(orbit.argumentOfPeriapsis), sinW, cosW);
+
+			// perifocal frame, then rotation to periapsis
+			const double x = a * (cosE - e);
+			const double y = orbit.direction * b * sinE;
+			const double v = std::sqrt(orbit.mu * a) / (a * (1.0 - e * cosE));
+			const double vx = -v * sinE;
+			const double vy = orbit.direction * v * std::sqrt(1.0 - e * e) * cosE;
+
+			positions[elliptic[j]] = { cosW * x - sinW * y, sinW * x + cosW * y };
+			velocities[elliptic[j]] = { cosW * vx - sinW * vy, sinW * vx + cosW * vy };
+		}
+	}
+
+	std::vector<vec2d> GeneratePoints(const Elements& elements, double maxRadius, size_t count)
+	{
+		std::vector<vec2d> result;
+		if (count < 2)
+			return result;
+		result.reserve(count + 1);
+
+		if (elements.GetType() == Elements::ellipse)
+		{
+			// closed polyline
+			for (size_t i = 0; i <= count; i++)
+				result.push_back(elements.GetPosition(TwoPi * (double)(i % count) / (double)count));
+			return result;
+		}
+
+		// true anomaly where the radius reaches maxRadius, it's always before the asymptote
+		const double cosLimit = std::clamp((elements.semiLatusRectum / maxRadius - 1.0) / elements.eccentricity, -1.0, 1.0);
+		const double limit = std::min(std::acos(cosLimit), elements.GetMaxTrueAnomaly());
+
+		for (size_t i = 0; i < count; i++)
+			result.push_back(elements.GetPosition(-limit + 2.0 * limit * (double)i / (double)(count - 1)));
+
+		return result;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <Magnum2D.h>
+#include <vector>
+#include <span>
+
+// Two body (Keplerian) orbits in plane, computed in closed form instead of from simulated points.
+// Ellipse, parabola and hyperbola share the same elements, anomaly is eccentric (ellipse), parabolic
+// (Barker) or hyperbolic depending on the eccentricity. All states are relative to the parent (focus).
+namespace Orbit
+{
+	struct Elements
+	{
+		// gravitational parameter G * (parent mass + body mass)
+		double mu = 0.0;
+		// semi-latus rectum, it is finite for all conics (semi-major axis is not for parabola)
+		double semiLatusRectum = 0.0;
+		double eccentricity = 0.0;
+		// angle of periapsis from x axis
+		double argumentOfPeriapsis = 0.0;
+		// at time of the state elements were computed from, not reduced to single revolution
+		double meanAnomaly = 0.0;
+		// 1 counterclockwise, -1 clockwise
+		double direction = 1.0;
+
+		enum Type
+		{
+			ellipse,
+			parabola,
+			hyperbola
+		};
+		Type GetType() const;
+
+		// negative for hyperbola, infinite for parabola
+		double GetSemiMajorAxis() const;
+		// radians per time, change of mean anomaly
+		double GetMeanMotion() const;
+		// infinite for parabola and hyperbola
+		double GetPeriod() const;
+		double GetPeriapsis() const;
+		// infinite for parabola and hyperbola
+		double GetApoapsis() const;
+		// true anomaly of asymptotes (pi for parabola), ellipse has none and returns infinity
+		double GetMaxTrueAnomaly() const;
+
+		double GetRadius(double trueAnomaly) const;
+		Magnum2D::vec2d GetPosition(double trueAnomaly) const;
+		Magnum2D::vec2d GetVelocity(double trueAnomaly) const;
+	};
+
+	// eccentricity closer to 1 is parabola
+	const double ParabolicTolerance = 1e-9;
+
+	Elements FromState(double mu, const Magnum2D::vec2d& position, const Magnum2D::vec2d& velocity);
+	void ToState(const Elements& elements, Magnum2D::vec2d& position, Magnum2D::vec2d& velocity);
+
+	// elements after time, only mean anomaly changes
+	Elements Propagate(const Elements& elements, double time);
+	double GetTrueAnomaly(const Elements& elements);
+
+	// solves M = E - e * sin(E) for eccentric anomaly
+	double SolveKeplerElliptic(double meanAnomaly, double eccentricity);
+	// solves M = e * sinh(H) - H for hyperbolic anomaly
+	double SolveKeplerHyperbolic(double meanAnomaly, double eccentricity);
+	// solves M = D + D^3 / 3 (Barker's equation) for D = tan(trueAnomaly / 2)
+	double SolveKeplerParabolic(double meanAnomaly);
+
+	// Batch versions for thousands of bodies. Elliptic equation is solved on blocks of orbits, iterations
+	// over a block have no branches, so they are vectorized by compiler. Block stops iterating when all
+	// its orbits converged.
+	void SolveKeplerElliptic(std::span<const double> meanAnomaly, std::span<const double> eccentricity, std::span<double> eccentricAnomaly);
+
+	void FromStates(std::span<const double> mu, std::span<const Magnum2D::vec2d> positions, std::span<const Magnum2D::vec2d> velocities, std::span<Elements> elements);
+	// states of elements after time
+	void GetStates(std::span<const Elements> elements, double time, std::span<Magnum2D::vec2d> positions, std::span<Magnum2D::vec2d> velocities);
+
+	// points of whole ellipse or of part of parabola and hyperbola (which is limited by maxRadius), empty
+	// when count is less than 2
+	std::vector<Magnum2D::vec2d> GeneratePoints(const Elements& elements, double maxRadius, size_t count = 300);
+}
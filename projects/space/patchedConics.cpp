@@ -0,0 +1,187 @@
+#include "patchedConics.h"
+#include <cmath>
+
+using namespace Magnum2D;
+
+namespace PatchedConics
+{
+	// bisection steps of crossing of sphere of influence, relative precision of crossing time within sample interval
+	static const int CrossingIterations = 40;
+	// radial orbit (no angular momentum) has no conic, tiny tangential velocity turns it to thin ellipse
+	static const double MinSemiLatusRectum = 1e-6;
+	// guard against switching between touching spheres forever
+	static const int MaxCrossingsPerSample = 64;
+
+	void Patch::getState(double time, const std::vector<MassPoint>& massPoints, vec2d& resultPosition, vec2d& resultVelocity) const
+	{
+		// state of nudged radial orbit differs from the real one
+		if (time == startTime)
+		{
+			resultPosition = position;
+			resultVelocity = velocity;
+			return;
+		}
+
+		if (!source)
+		{
+			resultPosition = position + velocity * (time - startTime);
+			resultVelocity = velocity;
+			return;
+		}
+
+		Orbit::ToState(Orbit::Propagate(elements, time - startTime), resultPosition, resultVelocity);
+		resultPosition += massPoints[*source].position;
+	}
+
+	std::optional<size_t> FindSource(const vec2d& position, const MassPointGrid& grid)
+	{
+		std::optional<size_t> result;
+		double strongest = 0.0;
+
+		grid.Query(position, [&](const MassPointGrid::Source& source, double distanceSqr)
+		{
+			const double strength = source.gravitationalParameter / distanceSqr;
+			if (!result || strength > strongest)
+			{
+				result = source.index;
+				strongest = strength;
+			}
+		});
+
+		return result;
+	}
+
+	Patch CreatePatch(double time, const vec2d& position, const vec2d& velocity, const std::vector<MassPoint>& massPoints, const MassPointGrid& grid)
+	{
+		Patch result;
+		result.startTime = time;
+		result.source = FindSource(position, grid);
+		result.position = position;
+		result.velocity = velocity;
+
+		if (result.source)
+		{
+			const MassPoint& source = massPoints[*result.source];
+			const double mu = GravitationalConstant * source.getMass();
+			vec2d relativePosition = position - source.position;
+			vec2d relativeVelocity = velocity;
+
+			const double distance = relativePosition.length();
+			const double angularMomentum = relativePosition.x() * relativeVelocity.y() - relativePosition.y() * relativeVelocity.x();
+			if (angularMomentum * angularMomentum < MinSemiLatusRectum * distance * mu)
+			{
+				const vec2d tangent = vec2d{ -relativePosition.y(), relativePosition.x() } / distance;
+				relativeVelocity += tangent * (std::sqrt(MinSemiLatusRectum * distance * mu) / distance);
+			}
+
+			result.elements = Orbit::FromState(mu, relativePosition, relativeVelocity);
+		}
+
+		return result;
+	}
+
+	// patch is left between times from and to, returns the first time outside of it
+	static double FindCrossing(const Patch& patch, double from, double to, const std::vector<MassPoint>& massPoints, const MassPointGrid& grid)
+	{
+		vec2d position, velocity;
+		for (int i = 0; i < CrossingIterations; i++)
+		{
+			const double middle = 0.5 * (from + to);
+			patch.getState(middle, massPoints, position, velocity);
+			if (FindSource(position, grid) == patch.source)
+				from = middle;
+			else
+				to = middle;
+		}
+		return to;
+	}
+
+	// output(position, time) is called for each trajectory point
+	template<class F>
+	static void PredictPoints(const vec2d& initialPosition, const vec2d& initialVelocity, const std::vector<MassPoint>& massPoints, const MassPointGrid& grid,
+		const std::vector<BurnPtr>& burns, double seconds, int32_t numPoints, std::vector<Patch>* patches, F&& output)
+	{
+		output(initialPosition, 0.0);
+
+		Patch patch = CreatePatch(0.0, initialPosition, initialVelocity, massPoints, grid);
+		if (patches)
+			patches->assign(1, patch);
+
+		auto setPatch = [&](Patch&& newPatch)
+		{
+			patch = std::move(newPatch);
+			if (patches)
+				patches->push_back(patch);
+		};
+
+		size_t burnIndex = 0;
+		vec2d position, velocity;
+		double previousTime = 0.0;
+
+		for (int32_t i = 1; i <= numPoints; i++)
+		{
+			const double time = seconds * (double)i / (double)numPoints;
+
+			int crossings = 0;
+			while (true)
+			{
+				// the first event before sample, burn or crossing of sphere of influence
+				const bool burn = burnIndex < burns.size() && burns[burnIndex]->time <= time;
+				const double eventTime = burn ? std::max(burns[burnIndex]->time, patch.startTime) : time;
+
+				patch.getState(eventTime, massPoints, position, velocity);
+				if (FindSource(position, grid) != patch.source && crossings++ < MaxCrossingsPerSample)
+				{
+					const double crossing = FindCrossing(patch, std::max(patch.startTime, previousTime), eventTime, massPoints, grid);
+					patch.getState(crossing, massPoints, position, velocity);
+					setPatch(CreatePatch(crossing, position, velocity, massPoints, grid));
+					continue;
+				}
+
+				if (!burn)
+					break;
+
+				burns[burnIndex]->simulatedPosition = position;
+				velocity += burns[burnIndex]->velocity;
+				burnIndex++;
+
+				setPatch(CreatePatch(eventTime, position, velocity, massPoints, grid));
+			}
+
+			output(position, time);
+			previousTime = time;
+		}
+	}
+
+	std::tuple<std::vector<vec2d>, std::vector<double>> Predict(const vec2d& initialPosition, const vec2d& initialVelocity,
+		const std::vector<MassPoint>& massPoints, const std::vector<BurnPtr>& burns, double seconds, int32_t numPoints, std::vector<Patch>* patches)
+	{
+		std::vector<vec2d> points;
+		std::vector<double> times;
+		points.reserve(numPoints + 1);
+		times.reserve(numPoints + 1);
+
+		MassPointGrid grid;
+		grid.Build(massPoints);
+
+		PredictPoints(initialPosition, initialVelocity, massPoints, grid, burns, seconds, numPoints, patches, [&](const vec2d& position, double time)
+		{
+			points.push_back(position);
+			times.push_back(time);
+		});
+
+		return { points, times };
+	}
+
+	void Predict(const vec2d& initialPosition, const vec2d& initialVelocity, const std::vector<MassPoint>& massPoints, const MassPointGrid& grid,
+		const std::vector<BurnPtr>& burns, double seconds, int32_t numPoints, Trajectory& trajectory)
+	{
+		trajectory.clear();
+
+		PredictPoints(initialPosition, initialVelocity, massPoints, grid, burns, seconds, numPoints, nullptr, [&](const vec2d& position, double time)
+		{
+			trajectory.positions.push_back((vec2)position);
+			trajectory.times.push_back((float)time);
+		});
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "point.h"
+#include "orbit.h"
+#include "massPointGrid.h"
+#include "trajectory.h"
+#include <vector>
+#include <optional>
+#include <tuple>
+
+// Fast prediction of trajectory of single point (ship) among static mass points. Effective radius
+// of mass point is its sphere of influence, inside it the point follows closed-form conic around it,
+// outside of all spheres it moves in straight line. Trajectory is integrated only at crossings of
+// spheres and at burns, so the cost doesn't depend on time step.
+namespace PatchedConics
+{
+	// part of trajectory with single source of gravity (or none)
+	struct Patch
+	{
+		double startTime = 0.0;
+		// index to mass points, free flight when empty
+		std::optional<size_t> source;
+		// relative to source, valid with source
+		Orbit::Elements elements;
+		// state at start time, global
+		Magnum2D::vec2d position;
+		Magnum2D::vec2d velocity;
+
+		void getState(double time, const std::vector<MassPoint>& massPoints, Magnum2D::vec2d& position, Magnum2D::vec2d& velocity) const;
+	};
+
+	// sphere of influence containing position, the strongest one when they overlap
+	std::optional<size_t> FindSource(const Magnum2D::vec2d& position, const MassPointGrid& grid);
+
+	// grid is built from mass points
+	Patch CreatePatch(double time, const Magnum2D::vec2d& position, const Magnum2D::vec2d& velocity, const std::vector<MassPoint>& massPoints, const MassPointGrid& grid);
+
+	// Same output as Simulation::Simulate(point, massPoints, ...): numPoints + 1 positions at regular
+	// times from 0 to seconds. Burns are sorted by time, their simulatedPosition is set.
+	// Patches are returned in optional output.
+	std::tuple<std::vector<Magnum2D::vec2d>, std::vector<double>> Predict(const Magnum2D::vec2d& position, const Magnum2D::vec2d& velocity,
+		const std::vector<MassPoint>& massPoints, const std::vector<BurnPtr>& burns, double seconds, int32_t numPoints, std::vector<Patch>* patches = nullptr);
+	// trajectory is replaced, grid is built from mass points and shared by predictions of several points
+	void Predict(const Magnum2D::vec2d& position, const Magnum2D::vec2d& velocity, const std::vector<MassPoint>& massPoints, const MassPointGrid& grid,
+		const std::vector<BurnPtr>& burns, double seconds, int32_t numPoints, Trajectory& trajectory);
+}
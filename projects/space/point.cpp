@@ -1,4 +1,6 @@
 #include "point.h"
+#include "massPointGrid.h"
+#include <algorithm>
 
 using namespace Magnum2D;
 
@@ -11,6 +13,11 @@ Point::Point(const Magnum2D::vec2d& pos, double m)
 	mass = m;
 }
 
+void Point::prepareStep(const MassPointGrid& grid, float)
+{
+	acceleration = grid.ComputeAcceleration(position);
+}
+
 void Point::applyForce(const vec2d& force)
 {
 	acceleration += (force / mass);
@@ -30,6 +37,17 @@ vec2d Point::attractForce(vec2d point, double pointMass) const
 	return (GravitationalConstant * pointMass * mass / (distance * distance)) * dir;
 }
 
+vec2d Point::attractAcceleration(vec2d point, double pointMass) const
+{
+	vec2d dir = (point - position);
+	double distanceSqr = dir.dot();
+
+	if (distanceSqr == 0.0)
+		return {};
+
+	return (GravitationalConstant * pointMass / (distanceSqr * std::sqrt(distanceSqr))) * dir;
+}
+
 void Point::initializeCircularOrbit(vec2d point, double pointMass)
 {
 	vec2d vec = point - position;
@@ -39,6 +57,27 @@ void Point::initializeCircularOrbit(vec2d point, double pointMass)
 	setVelocity(perpendicularDir * velocitySize);
 }
 
+double* Point::savePointState(double* state) const
+{
+	*state++ = position.x();
+	*state++ = position.y();
+	*state++ = mass;
+	*state++ = effectiveRadius;
+	*state++ = acceleration.x();
+	*state++ = acceleration.y();
+	return state;
+}
+
+const double* Point::loadPointState(const double* state)
+{
+	position = { state[0], state[1] };
+	mass = state[2];
+	effectiveRadius = state[3];
+	effectiveRadiusSqr = effectiveRadius * effectiveRadius;
+	acceleration = { state[4], state[5] };
+	return state + PointStateSize;
+}
+
 void PointEuler::step(double dt)
 {
 	// semi-implicit euler
@@ -72,6 +111,19 @@ void PointEuler::reset()
 	position = acceleration = velocity = { 0.0, 0.0 };
 }
 
+void PointEuler::saveState(double* state) const
+{
+	state = savePointState(state);
+	*state++ = velocity.x();
+	*state++ = velocity.y();
+}
+
+void PointEuler::loadState(const double* state)
+{
+	state = loadPointState(state);
+	velocity = { state[0], state[1] };
+}
+
 PointVerlet::PointVerlet(const Magnum2D::vec2d& pos, const Magnum2D::vec2d& vel, double mass)
 	: Point(pos, mass)
 {
@@ -80,10 +132,11 @@ PointVerlet::PointVerlet(const Magnum2D::vec2d& pos, const Magnum2D::vec2d& vel,
 
 void PointVerlet::step(double dt)
 {
-	auto move = position - positionOld;
+	// time-corrected verlet, previous move was done in lastDt which may differ from dt
+	auto move = (position - positionOld) * (dt / lastDt);
 
 	positionOld = position;
-	position += move + dt * dt * acceleration;
+	position += move + (0.5 * dt * (dt + lastDt)) * acceleration;
 
 	lastDt = dt;
 }
@@ -100,7 +153,7 @@ void PointVerlet::addVelocity(const vec2d& vel)
 
 Magnum2D::vec2d PointVerlet::getVelocity()
 {
-	return position - positionOld;
+	return (position - positionOld) / lastDt;
 }
 
 void PointVerlet::reset()
@@ -108,6 +161,21 @@ void PointVerlet::reset()
 	position = acceleration = positionOld = { 0.0, 0.0 };
 }
 
+void PointVerlet::saveState(double* state) const
+{
+	state = savePointState(state);
+	*state++ = positionOld.x();
+	*state++ = positionOld.y();
+	*state++ = lastDt;
+}
+
+void PointVerlet::loadState(const double* state)
+{
+	state = loadPointState(state);
+	positionOld = { state[0], state[1] };
+	lastDt = state[2];
+}
+
 PointRungeKutta::PointRungeKutta(const Magnum2D::vec2d& pos, const Magnum2D::vec2d& vel, double mass)
 	: Point(pos, mass)
 {
@@ -143,6 +211,243 @@ void PointRungeKutta::reset()
 	position = acceleration = velocity = { 0.0, 0.0 };
 }
 
+void PointRungeKutta::saveState(double* state) const
+{
+	state = savePointState(state);
+	for (const vec2d& value : { velocity, positionTemp })
+	{
+		*state++ = value.x();
+		*state++ = value.y();
+	}
+	for (const State* k : { &k1, &k2, &k3, &k4 })
+	{
+		*state++ = k->velocity.x();
+		*state++ = k->velocity.y();
+		*state++ = k->acceleration.x();
+		*state++ = k->acceleration.y();
+	}
+}
+
+void PointRungeKutta::loadState(const double* state)
+{
+	state = loadPointState(state);
+	for (vec2d* value : { &velocity, &positionTemp })
+	{
+		*value = { state[0], state[1] };
+		state += 2;
+	}
+	for (State* k : { &k1, &k2, &k3, &k4 })
+	{
+		k->velocity = { state[0], state[1] };
+		k->acceleration = { state[2], state[3] };
+		state += 4;
+	}
+}
+
+namespace DormandPrince
+{
+	// butcher tableau, last row of A is the same as 5th order weights (first same as last)
+	static const double A[PointDormandPrince::Stages][PointDormandPrince::Stages - 1] = {
+		{},
+		{ 1.0 / 5.0 },
+		{ 3.0 / 40.0, 9.0 / 40.0 },
+		{ 44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0 },
+		{ 19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0 },
+		{ 9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0 },
+		{ 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0 }
+	};
+
+	// nodes, fractions of the step
+	static const double C[PointDormandPrince::Stages] = {
+		0.0, 1.0 / 5.0, 3.0 / 10.0, 4.0 / 5.0, 8.0 / 9.0, 1.0, 1.0
+	};
+
+	// 5th order weights
+	static const double B[PointDormandPrince::Stages] = {
+		35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0, 0.0
+	};
+
+	// difference between 5th and 4th order weights
+	static const double E[PointDormandPrince::Stages] = {
+		35.0 / 384.0 - 5179.0 / 57600.0,
+		0.0,
+		500.0 / 1113.0 - 7571.0 / 16695.0,
+		125.0 / 192.0 - 393.0 / 640.0,
+		-2187.0 / 6784.0 + 92097.0 / 339200.0,
+		11.0 / 84.0 - 187.0 / 2100.0,
+		-1.0 / 40.0
+	};
+}
+
+PointDormandPrince::PointDormandPrince(const Magnum2D::vec2d& pos, const Magnum2D::vec2d& vel, double mass)
+	: Point(pos, mass)
+{
+	setVelocity(vel);
+}
+
+double PointDormandPrince::GetStageTime(size_t stage)
+{
+	return DormandPrince::C[stage];
+}
+
+void PointDormandPrince::stepStageBegin(size_t stage, double dt)
+{
+	vec2d vel, acc;
+	for (size_t i = 0; i < stage; i++)
+	{
+		vel += DormandPrince::A[stage][i] * k[i].velocity;
+		acc += DormandPrince::A[stage][i] * k[i].acceleration;
+	}
+
+	positionTemp = position + vel * dt;
+	velocityTemp = velocity + acc * dt;
+}
+
+void PointDormandPrince::stepStageEnd(size_t stage, const vec2d& acceleration)
+{
+	k[stage].velocity = velocityTemp;
+	k[stage].acceleration = acceleration;
+}
+
+double PointDormandPrince::estimateError(double dt, double absoluteTolerance, double relativeTolerance) const
+{
+	vec2d positionError, velocityError;
+	for (size_t i = 0; i < Stages; i++)
+	{
+		positionError += DormandPrince::E[i] * k[i].velocity;
+		velocityError += DormandPrince::E[i] * k[i].acceleration;
+	}
+
+	// the last stage was evaluated at the new state
+	double positionScale = absoluteTolerance + relativeTolerance * std::max(position.length(), positionTemp.length());
+	double velocityScale = absoluteTolerance + relativeTolerance * std::max(velocity.length(), velocityTemp.length());
+
+	double positionRatio = dt * positionError.length() / positionScale;
+	double velocityRatio = dt * velocityError.length() / velocityScale;
+
+	return positionRatio * positionRatio + velocityRatio * velocityRatio;
+}
+
+void PointDormandPrince::reuseLastStage()
+{
+	k[0] = k[Stages - 1];
+}
+
+void PointDormandPrince::step(double dt)
+{
+	vec2d vel, acc;
+	for (size_t i = 0; i < Stages; i++)
+	{
+		vel += DormandPrince::B[i] * k[i].velocity;
+		acc += DormandPrince::B[i] * k[i].acceleration;
+	}
+
+	position = position + vel * dt;
+	velocity = velocity + acc * dt;
+}
+
+void PointDormandPrince::setVelocity(const vec2d& vel)
+{
+	velocity = vel;
+}
+
+void PointDormandPrince::addVelocity(const vec2d& vel)
+{
+	velocity += vel;
+}
+
+Magnum2D::vec2d PointDormandPrince::getVelocity()
+{
+	return velocity;
+}
+
+void PointDormandPrince::reset()
+{
+	position = acceleration = velocity = { 0.0, 0.0 };
+}
+
+void PointDormandPrince::saveState(double* state) const
+{
+	state = savePointState(state);
+	for (const vec2d& value : { velocity, positionTemp, velocityTemp })
+	{
+		*state++ = value.x();
+		*state++ = value.y();
+	}
+	// first stage is reused by the next step
+	for (const State& stage : k)
+	{
+		*state++ = stage.velocity.x();
+		*state++ = stage.velocity.y();
+		*state++ = stage.acceleration.x();
+		*state++ = stage.acceleration.y();
+	}
+}
+
+void PointDormandPrince::loadState(const double* state)
+{
+	state = loadPointState(state);
+	for (vec2d* value : { &velocity, &positionTemp, &velocityTemp })
+	{
+		*value = { state[0], state[1] };
+		state += 2;
+	}
+	for (State& stage : k)
+	{
+		stage.velocity = { state[0], state[1] };
+		stage.acceleration = { state[2], state[3] };
+		state += 4;
+	}
+}
+
+PointLeapfrog::PointLeapfrog(const Magnum2D::vec2d& pos, const Magnum2D::vec2d& vel, double mass)
+	: Point(pos, mass)
+{
+	setVelocity(vel);
+}
+
+void PointLeapfrog::step(double dt)
+{
+	kick(dt);
+	drift(dt);
+}
+
+void PointLeapfrog::setVelocity(const vec2d& vel)
+{
+	velocity = vel;
+}
+
+void PointLeapfrog::addVelocity(const vec2d& vel)
+{
+	velocity += vel;
+}
+
+Magnum2D::vec2d PointLeapfrog::getVelocity()
+{
+	return velocity;
+}
+
+void PointLeapfrog::reset()
+{
+	position = acceleration = velocity = { 0.0, 0.0 };
+	level = -1;
+}
+
+void PointLeapfrog::saveState(double* state) const
+{
+	state = savePointState(state);
+	*state++ = velocity.x();
+	*state++ = velocity.y();
+	*state++ = (double)level;
+}
+
+void PointLeapfrog::loadState(const double* state)
+{
+	state = loadPointState(state);
+	velocity = { state[0], state[1] };
+	level = (int32_t)state[2];
+}
+
 MassPoint::MassPoint()
 {
 	recomputeEffectiveRadius();
@@ -3,11 +3,14 @@
 #include <Magnum2D.h>
 #include <vector>
 #include <memory>
+#include <array>
 
 extern double GravitationalConstant;
 extern double GravityThreshold;
 extern double SimulationDt;
 
+struct MassPointGrid;
+
 struct MassPoint
 {
 	MassPoint();
@@ -48,6 +51,8 @@ struct Point : public MassPoint
 	{
 		acceleration = computeAcceleration(massPoints, thisIndex);
 	}
+	// only mass points whose effective radius covers this point
+	void prepareStep(const MassPointGrid& grid, float);
 
 	virtual void step(double dt) = 0;
 	virtual void setVelocity(const Magnum2D::vec2d& vel) = 0;
@@ -57,8 +62,15 @@ struct Point : public MassPoint
 
 	void applyForce(const Magnum2D::vec2d& force);
 	Magnum2D::vec2d attractForce(Magnum2D::vec2d point, double pointMass) const;
+	// acceleration of this point caused by point mass, a = G * m / (r * r), does not depend on mass of this point
+	Magnum2D::vec2d attractAcceleration(Magnum2D::vec2d point, double pointMass) const;
 	void initializeCircularOrbit(Magnum2D::vec2d point, double pointMass);
 
+	// Derived points save whole state as StateSize doubles (saveState, loadState), stage data
+	// included, so simulation continues the same after loading (see Simulation::Checkpoints).
+	// PointStateSize values of them belong to Point.
+	static constexpr size_t PointStateSize = 6;
+
 	template<class T>
 	Magnum2D::vec2d computeAcceleration(const std::vector<T>& massPoints, size_t thisIndex = -1)
 	{
@@ -72,16 +84,18 @@ struct Point : public MassPoint
 			//if (Utils::DistanceSqr(massPoints[i].position, position) > massPoints[i].getEffectiveRadiusSqr())
 			//	continue;
 
-			// TODO to get acceleration, in force both masses are multiplied and divided by square length.
-			// Here the resulting force is divided by mass of one of the points.
-			// I think there is no need to multiply by the this mass and just use formula a = G * m / (r*r)
-			// Also force for both points is equal, only oposite direction. It is possible to compute for both one direction
-			// and one force size. Is it possible to get oposite direction easily?
-			result += attractForce(massPoints[i].position, massPoints[i].getMass()) / mass;
+			// force for both points of the pair is equal, only opposite direction,
+			// Gravity::AccumulateSymmetric exploits it when computing accelerations of all bodies
+			result += attractAcceleration(massPoints[i].position, massPoints[i].getMass());
 		}
 
 		return result;
 	}
+
+protected:
+	// return pointer after written (read) values
+	double* savePointState(double* state) const;
+	const double* loadPointState(const double* state);
 };
 
 struct PointEuler : public Point
@@ -95,6 +109,10 @@ struct PointEuler : public Point
 	void addVelocity(const Magnum2D::vec2d& vel) override;
 	Magnum2D::vec2d getVelocity() override;
 	void reset() override;
+
+	static constexpr size_t StateSize = PointStateSize + 2;
+	void saveState(double* state) const;
+	void loadState(const double* state);
 };
 
 struct PointVerlet : public Point
@@ -102,6 +120,7 @@ struct PointVerlet : public Point
 	PointVerlet(const Magnum2D::vec2d& pos = { 0.0, 0.0 }, const Magnum2D::vec2d& vel = { 0.0, 0.0 }, double mass = 0.0);
 
 	Magnum2D::vec2d positionOld;
+	// time of the move from positionOld to position, velocity is the move divided by it
 	double lastDt = SimulationDt;
 
 	void step(double dt) override;
@@ -109,6 +128,10 @@ struct PointVerlet : public Point
 	void addVelocity(const Magnum2D::vec2d& vel) override;
 	Magnum2D::vec2d getVelocity() override;
 	void reset() override;
+
+	static constexpr size_t StateSize = PointStateSize + 3;
+	void saveState(double* state) const;
+	void loadState(const double* state);
 };
 
 struct PointRungeKutta : public Point
@@ -167,9 +190,15 @@ struct PointRungeKutta : public Point
 		positionTemp = position;
 	}
 
-	void stepK1End(const std::vector<PointRungeKutta>& massPoints, double, size_t thisIndex)
+	void stepK1End(const std::vector<PointRungeKutta>& massPoints, double dt, size_t thisIndex)
+	{
+		stepK1End(computeAccelerationTemp(massPoints, thisIndex), dt);
+	}
+
+	// acceleration at positionTemp computed externally (e.g. by Gravity::Solver)
+	void stepK1End(const Magnum2D::vec2d& acceleration, double)
 	{
-		k1.acceleration = computeAccelerationTemp(massPoints, thisIndex);
+		k1.acceleration = acceleration;
 		k1.velocity = velocity;
 	}
 
@@ -180,10 +209,15 @@ struct PointRungeKutta : public Point
 	}
 
 	void stepK2End(const std::vector<PointRungeKutta>& massPoints, double dt, size_t thisIndex)
+	{
+		stepK2End(computeAccelerationTemp(massPoints, thisIndex), dt);
+	}
+
+	void stepK2End(const Magnum2D::vec2d& acceleration, double dt)
 	{
 		// when points are at new position, fill in the state
 		// we will use acceleration from the beginning to modify the velicity, because it was affecting velocity for dt/2 time
-		k2.acceleration = computeAccelerationTemp(massPoints, thisIndex);
+		k2.acceleration = acceleration;
 		k2.velocity = velocity + k1.acceleration * (dt / 2.0);
 	}
 
@@ -193,9 +227,14 @@ struct PointRungeKutta : public Point
 	}
 
 	void stepK3End(const std::vector<PointRungeKutta>& massPoints, double dt, size_t thisIndex)
+	{
+		stepK3End(computeAccelerationTemp(massPoints, thisIndex), dt);
+	}
+
+	void stepK3End(const Magnum2D::vec2d& acceleration, double dt)
 	{
 		// here not sure what acceleration to use
-		k3.acceleration = computeAccelerationTemp(massPoints, thisIndex);
+		k3.acceleration = acceleration;
 		k3.velocity = velocity + k1.acceleration * (dt / 2.0);
 	}
 
@@ -206,7 +245,12 @@ struct PointRungeKutta : public Point
 
 	void stepK4End(const std::vector<PointRungeKutta>& massPoints, double dt, size_t thisIndex)
 	{
-		k4.acceleration = computeAccelerationTemp(massPoints, thisIndex);
+		stepK4End(computeAccelerationTemp(massPoints, thisIndex), dt);
+	}
+
+	void stepK4End(const Magnum2D::vec2d& acceleration, double dt)
+	{
+		k4.acceleration = acceleration;
 		k4.velocity = velocity + k1.acceleration * dt;
 	}
 
@@ -215,4 +259,87 @@ struct PointRungeKutta : public Point
 	void addVelocity(const Magnum2D::vec2d& vel) override;
 	Magnum2D::vec2d getVelocity() override;
 	void reset() override;
+
+	static constexpr size_t StateSize = PointStateSize + 4 + 4 * 4;
+	void saveState(double* state) const;
+	void loadState(const double* state);
+};
+
+// Dormand-Prince 5(4) embedded runge-kutta. Difference between 5th and 4th order solution
+// estimates the error of the step, so the simulation can adapt dt (see Simulation::Simulate).
+struct PointDormandPrince : public Point
+{
+	static constexpr size_t Stages = 7;
+
+	PointDormandPrince(const Magnum2D::vec2d& pos = { 0.0, 0.0 }, const Magnum2D::vec2d& vel = { 0.0, 0.0 }, double mass = 0.0);
+
+	Magnum2D::vec2d velocity;
+
+	Magnum2D::vec2d positionTemp;
+	Magnum2D::vec2d velocityTemp;
+
+	struct State
+	{
+		Magnum2D::vec2d velocity;
+		Magnum2D::vec2d acceleration;
+	};
+	std::array<State, Stages> k;
+
+	// fraction of the step at which stage is evaluated
+	static double GetStageTime(size_t stage);
+
+	// move point to temporary state of the stage using derivatives of previous stages
+	void stepStageBegin(size_t stage, double dt);
+	// acceleration at positionTemp computed externally (e.g. by Gravity::Solver)
+	void stepStageEnd(size_t stage, const Magnum2D::vec2d& acceleration);
+
+	// Squared error of position and velocity relative to tolerance, summed. Values above 2 mean
+	// that the step would be rejected if this was the only point.
+	double estimateError(double dt, double absoluteTolerance, double relativeTolerance) const;
+
+	// last stage is evaluated at the new state, it is reused as the first stage of the next step
+	void reuseLastStage();
+
+	void step(double dt) override;
+	void setVelocity(const Magnum2D::vec2d& vel) override;
+	void addVelocity(const Magnum2D::vec2d& vel) override;
+	Magnum2D::vec2d getVelocity() override;
+	void reset() override;
+
+	static constexpr size_t StateSize = PointStateSize + 6 + Stages * 4;
+	void saveState(double* state) const;
+	void loadState(const double* state);
+};
+
+// Kick-drift-kick leapfrog. Simulation::Simulate can give every point its own power of two
+// fraction of the base step (block time steps), so acceleration is kept between calls.
+struct PointLeapfrog : public Point
+{
+	PointLeapfrog(const Magnum2D::vec2d& pos = { 0.0, 0.0 }, const Magnum2D::vec2d& vel = { 0.0, 0.0 }, double mass = 0.0);
+
+	Magnum2D::vec2d velocity;
+
+	// step of the point is base step / 2^level, -1 means acceleration was not computed yet
+	int32_t level = -1;
+
+	void kick(double dt)
+	{
+		velocity += acceleration * dt;
+	}
+
+	void drift(double dt)
+	{
+		position += velocity * dt;
+	}
+
+	// single kick and drift with acceleration computed before the step (generic Simulate)
+	void step(double dt) override;
+	void setVelocity(const Magnum2D::vec2d& vel) override;
+	void addVelocity(const Magnum2D::vec2d& vel) override;
+	Magnum2D::vec2d getVelocity() override;
+	void reset() override;
+
+	static constexpr size_t StateSize = PointStateSize + 3;
+	void saveState(double* state) const;
+	void loadState(const double* state);
 };
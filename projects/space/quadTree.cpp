@@ -0,0 +1,205 @@
+#include "quadTree.h"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <cassert>
+
+using namespace Magnum2D;
+
+extern double GravitationalConstant;
+
+void QuadTree::Build(std::span<const vec2d> inputPositions, std::span<const double> inputMasses)
+{
+	assert(inputPositions.size() == inputMasses.size());
+
+	nodes.clear();
+	indices.resize(inputPositions.size());
+	std::iota(std::begin(indices), std::end(indices), 0);
+
+	if (inputPositions.empty())
+		return;
+
+	// while subdividing positions are in original order, they are reordered afterwards
+	positions.assign(std::begin(inputPositions), std::end(inputPositions));
+
+	vec2d min = positions[0], max = positions[0];
+	for (const auto& p : positions)
+	{
+		min = { std::min(min.x(), p.x()), std::min(min.y(), p.y()) };
+		max = { std::max(max.x(), p.x()), std::max(max.y(), p.y()) };
+	}
+
+	vec2d center = (min + max) / 2.0;
+	double halfSize = std::max(max.x() - min.x(), max.y() - min.y()) / 2.0;
+
+	nodes.reserve(2 * inputPositions.size() / LeafCapacity + 1);
+	nodes.push_back({});
+	nodes[0].count = (uint32_t)indices.size();
+
+	Subdivide(0, center, halfSize, 0);
+
+	masses.resize(indices.size());
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		positions[i] = inputPositions[indices[i]];
+		masses[i] = inputMasses[indices[i]];
+	}
+
+	ComputeNodes();
+}
+
+void QuadTree::Subdivide(uint32_t node, vec2d center, double halfSize, uint32_t depth)
+{
+	uint32_t first = nodes[node].first;
+	uint32_t count = nodes[node].count;
+
+	if (count <= LeafCapacity || depth == MaxDepth)
+		return;
+
+	auto begin = std::begin(indices) + first;
+	auto end = begin + count;
+
+	// split to bottom and top half and then each half to left and right quadrant
+	auto middle = std::partition(begin, end, [&](uint32_t i) { return positions[i].y() < center.y(); });
+	auto bottom = std::partition(begin, middle, [&](uint32_t i) { return positions[i].x() < center.x(); });
+	auto top = std::partition(middle, end, [&](uint32_t i) { return positions[i].x() < center.x(); });
+
+	std::array<decltype(begin), 5> bounds = { begin, bottom, middle, top, end };
+
+	uint32_t firstChild = (uint32_t)nodes.size();
+	nodes[node].firstChild = firstChild;
+	nodes.resize(nodes.size() + 4);
+
+	double quarterSize = halfSize / 2.0;
+	std::array<vec2d, 4> offsets = { vec2d{ -quarterSize, -quarterSize }, vec2d{ quarterSize, -quarterSize },
+									 vec2d{ -quarterSize, quarterSize }, vec2d{ quarterSize, quarterSize } };
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		nodes[firstChild + i].first = (uint32_t)(bounds[i] - std::begin(indices));
+		nodes[firstChild + i].count = (uint32_t)(bounds[i + 1] - bounds[i]);
+
+		Subdivide(firstChild + i, center + offsets[i], quarterSize, depth + 1);
+	}
+}
+
+void QuadTree::Refit(std::span<const vec2d> inputPositions)
+{
+	assert(inputPositions.size() == indices.size());
+
+	for (size_t i = 0; i < indices.size(); i++)
+		positions[i] = inputPositions[indices[i]];
+
+	ComputeNodes();
+}
+
+void QuadTree::ComputeNodes()
+{
+	static const double Infinity = std::numeric_limits<double>::infinity();
+
+	// children are always stored after their parent, so iterating backwards is bottom-up
+	for (size_t n = nodes.size(); n-- > 0;)
+	{
+		Node& node = nodes[n];
+
+		vec2d weightedPosition;
+		node.mass = 0.0;
+		node.min = { Infinity, Infinity };
+		node.max = { -Infinity, -Infinity };
+
+		if (node.firstChild == 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				node.mass += masses[i];
+				weightedPosition += positions[i] * masses[i];
+				node.min = { std::min(node.min.x(), positions[i].x()), std::min(node.min.y(), positions[i].y()) };
+				node.max = { std::max(node.max.x(), positions[i].x()), std::max(node.max.y(), positions[i].y()) };
+			}
+		}
+		else
+		{
+			for (uint32_t i = node.firstChild; i < node.firstChild + 4; i++)
+			{
+				const Node& child = nodes[i];
+				if (child.count == 0)
+					continue;
+
+				node.mass += child.mass;
+				weightedPosition += child.centerOfMass * child.mass;
+				node.min = { std::min(node.min.x(), child.min.x()), std::min(node.min.y(), child.min.y()) };
+				node.max = { std::max(node.max.x(), child.max.x()), std::max(node.max.y(), child.max.y()) };
+			}
+		}
+
+		if (node.count == 0)
+			continue;
+
+		node.centerOfMass = node.mass > 0.0 ? weightedPosition / node.mass : (node.min + node.max) / 2.0;
+	}
+}
+
+vec2d QuadTree::ComputeAcceleration(const vec2d& position, size_t index, double openingAngle) const
+{
+	vec2d result;
+
+	if (nodes.empty())
+		return result;
+
+	auto attract = [&result, &position](const vec2d& point, double mass)
+	{
+		vec2d dir = point - position;
+		double distanceSqr = dir.x() * dir.x() + dir.y() * dir.y();
+
+		if (distanceSqr == 0.0)
+			return;
+
+		double distance = std::sqrt(distanceSqr);
+		result += (GravitationalConstant * mass / (distanceSqr * distance)) * dir;
+	};
+
+	const double openingAngleSqr = openingAngle * openingAngle;
+
+	// each level pushes at most 4 nodes and pops one
+	std::array<uint32_t, 4 * MaxDepth + 1> stack;
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize)
+	{
+		const Node& node = nodes[stack[--stackSize]];
+
+		if (node.count == 0)
+			continue;
+
+		if (node.firstChild == 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				if (indices[i] != index)
+					attract(positions[i], masses[i]);
+			}
+			continue;
+		}
+
+		vec2d extent = node.max - node.min;
+		double size = std::max(extent.x(), extent.y());
+		double distanceSqr = (node.centerOfMass - position).dot();
+
+		bool isInside = position.x() >= node.min.x() && position.x() <= node.max.x() &&
+						position.y() >= node.min.y() && position.y() <= node.max.y();
+
+		// node is far enough to be approximated by its center of mass
+		if (!isInside && size * size < openingAngleSqr * distanceSqr)
+		{
+			attract(node.centerOfMass, node.mass);
+			continue;
+		}
+
+		for (uint32_t i = 0; i < 4; i++)
+			stack[stackSize++] = node.firstChild + i;
+	}
+
+	return result;
+}
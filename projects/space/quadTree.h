@@ -0,0 +1,49 @@
+#pragma once
+#include <Magnum2D.h>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+// Barnes-Hut quadtree over set of bodies. Bodies are stored in tree order so each node
+// covers contiguous range of them, leaves hold up to LeafCapacity bodies.
+struct QuadTree
+{
+	static constexpr uint32_t LeafCapacity = 8;
+	static constexpr uint32_t MaxDepth = 32;
+
+	void Build(std::span<const Magnum2D::vec2d> positions, std::span<const double> masses);
+	// Update positions of bodies while keeping the topology of the tree. Mass distribution
+	// and extents of nodes are recomputed, so the tree stays valid for slightly moved bodies
+	// (e.g. between stages of single runge-kutta step).
+	void Refit(std::span<const Magnum2D::vec2d> positions);
+
+	// index is index of body which must be skipped (body at position itself)
+	Magnum2D::vec2d ComputeAcceleration(const Magnum2D::vec2d& position, size_t index, double openingAngle) const;
+
+	size_t GetNodeCount() const { return nodes.size(); }
+	bool IsEmpty() const { return nodes.empty(); }
+
+private:
+	struct Node
+	{
+		Magnum2D::vec2d centerOfMass;
+		double mass = 0.0;
+		// bounding box of bodies within node
+		Magnum2D::vec2d min;
+		Magnum2D::vec2d max;
+		// index of first of four children, 0 for leaf (root can't be child)
+		uint32_t firstChild = 0;
+		uint32_t first = 0;
+		uint32_t count = 0;
+	};
+
+	void Subdivide(uint32_t node, Magnum2D::vec2d center, double halfSize, uint32_t depth);
+	void ComputeNodes();
+
+	std::vector<Node> nodes;
+
+	// body data in tree order
+	std::vector<uint32_t> indices;
+	std::vector<Magnum2D::vec2d> positions;
+	std::vector<double> masses;
+};
@@ -1,27 +1,48 @@
 #include "ship.h"
 #include "simulation.h"
+#include "patchedConics.h"
 #include <algorithm>
 
 using namespace Magnum2D;
 
 Ship::Ship(const Magnum2D::vec2d& initPos)
-	: burnsHandler(this, &trajectoryVerlet), initialPosition(initPos)
+	: burnsHandler(this, &trajectoryPredicted), initialPosition(initPos)
 {
 }
 
-template<typename T>
-std::tuple<std::vector<vec2>, std::vector<float>> SimulateHelper(T&& point, const std::vector<MassPoint>& massPoints, const std::vector<BurnPtr>& burns, double dt, double seconds, int32_t numPoints)
+void Ship::Simulate(SimulationTask task, const std::vector<MassPoint>& massPoints, const MassPointGrid& grid, double dt, double seconds, int32_t numPoints, bool refine)
 {
-	auto[points, times] = Simulation::Simulate(point, massPoints, burns, dt, seconds, numPoints);
-	return { Utils::ConvertToFloat(points), Utils::ConvertToFloat(times) };
+	switch (task)
+	{
+	case SimulationTask::Predicted:
+		// simulated positions of burns are set only by this one, it's the edited trajectory
+		PatchedConics::Predict((vec2d)initialPosition, {}, massPoints, grid, burns, seconds, numPoints, trajectoryPredicted);
+		break;
+	case SimulationTask::Euler:
+		if (refine)
+		{
+			PointEuler point((vec2d)initialPosition);
+			Simulation::Simulate(point, grid, burns, dt, seconds, numPoints, trajectoryEuler);
+		}
+		else
+			trajectoryEuler.clear();
+		break;
+	case SimulationTask::Verlet:
+		if (refine)
+		{
+			PointVerlet point((vec2d)initialPosition);
+			Simulation::Simulate(point, grid, burns, dt, seconds, numPoints, trajectoryVerlet);
+		}
+		else
+			trajectoryVerlet.clear();
+		break;
+	default:
+		break;
+	}
 }
 
-void Ship::Simulate(const std::vector<MassPoint>& massPoints, double dt, double seconds, int32_t numPoints)
+void Ship::Refresh()
 {
-	std::tie(trajectoryEuler.positions, trajectoryEuler.times) = SimulateHelper(PointEuler((vec2d)initialPosition), massPoints, burns, dt, seconds, numPoints);
-	std::tie(trajectoryVerlet.positions, trajectoryVerlet.times) = SimulateHelper(PointVerlet((vec2d)initialPosition), massPoints, burns, dt, seconds, numPoints);
-	//std::tie(trajectoryRungeKuta.positions, trajectoryRungeKuta.times) = SimulateHelper(PointRungeKutta((vec2d)initialPosition), massPoints, burns, dt, seconds, numPoints);
-
 	burnsHandler.Refresh();
 }
 
@@ -42,6 +63,7 @@ UpdateResult Ship::Update()
 
 void Ship::Draw()
 {
+	trajectoryPredicted.draw(rgb(0, 200, 0));
 	trajectoryEuler.draw(rgb(200, 0, 0));
 	trajectoryVerlet.draw(rgb(0, 0, 200));
 	//trajectoryRungeKuta.draw(rgb(0, 200, 0));
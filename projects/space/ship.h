@@ -3,6 +3,7 @@
 #include "common.h"
 #include "trajectory.h"
 #include "burnsHandler.h"
+#include "massPointGrid.h"
 #include <memory>
 
 struct Ship
@@ -11,10 +12,23 @@ struct Ship
 	void AddBurn(double time, const Magnum2D::vec2& velocity);
 	void Draw();
 	UpdateResult Update();
-	void Simulate(const std::vector<MassPoint>& massPoints, double dt, double seconds, int32_t numPoints);
+	// Trajectory is predicted by patched conics, numerical ones are simulated only when refine is set.
+	// Each trajectory is simulated by independent task writing only to it, so tasks of all ships can run
+	// in parallel (grid is built from massPoints). Refresh must be called when all tasks are done.
+	enum class SimulationTask : int32_t
+	{
+		Predicted = 0,
+		Euler,
+		Verlet,
+		Count
+	};
+	void Simulate(SimulationTask task, const std::vector<MassPoint>& massPoints, const MassPointGrid& grid, double dt, double seconds, int32_t numPoints, bool refine);
+	void Refresh();
 
 	Magnum2D::vec2 initialPosition;
 
+	// burns are edited on this one
+	Trajectory trajectoryPredicted;
 	Trajectory trajectoryEuler;
 	Trajectory trajectoryVerlet;
 	//Trajectory trajectoryRungeKuta;
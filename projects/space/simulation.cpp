@@ -1,3 +1,136 @@
 #include "simulation.h"
+#include "gravityKernel.h"
 
 using namespace Magnum2D;
+
+namespace Simulation
+{
+	void Ephemerides::Accumulate(double time, std::span<const vec2d> positions, std::span<vec2d> accelerations, std::span<const size_t> active)
+	{
+		// stages of integrators often share time (RK4 midpoint, end of step and start of the next one)
+		if (time != positionsTime || store.size() != bodies.size())
+		{
+			if (store.size() != bodies.size())
+				Initialize();
+
+			if (!grid.bodies.empty() && (time < grid.from || time > grid.to))
+				UpdateGrid(time);
+			for (size_t i : grid.others)
+			{
+				if (time < segments[i].from || time > segments[i].to)
+					UpdateSegment(i, time);
+			}
+
+			for (size_t i = 0; i < bodies.size(); i++)
+			{
+				const Segment& segment = segments[i];
+				const double s = std::clamp((time - segment.from) * segment.scale, 0.0, 1.0);
+				const auto& c = segment.coefficients;
+				const vec2d position = c[0] + s * (c[1] + s * (c[2] + s * c[3]));
+				store.x[i] = position.x();
+				store.y[i] = position.y();
+			}
+			positionsTime = time;
+		}
+
+		if (active.empty())
+		{
+			for (size_t j = 0; j < positions.size(); j++)
+				accelerations[j] += GravityKernel::ComputeAcceleration(store, positions[j]);
+		}
+		else
+		{
+			for (size_t j : active)
+				accelerations[j] += GravityKernel::ComputeAcceleration(store, positions[j]);
+		}
+	}
+
+	static bool HaveSameTimes(const Trajectory& first, const Trajectory& second)
+	{
+		if (first.times.size() != second.times.size())
+			return false;
+
+		// chunks of the same size are split the same way
+		for (size_t chunk = 0; chunk < first.times.GetChunkCount(); chunk++)
+		{
+			const auto a = first.times.GetChunkData(chunk), b = second.times.GetChunkData(chunk);
+			if (!std::equal(a.begin(), a.end(), b.begin(), b.end()))
+				return false;
+		}
+		return true;
+	}
+
+	void Ephemerides::Initialize()
+	{
+		segments.assign(bodies.size(), {});
+		store.resize(bodies.size());
+		grid = {};
+
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			store.m[i] = bodies[i].mass;
+
+			if (HaveSameTimes(*bodies[0].trajectory, *bodies[i].trajectory))
+				grid.bodies.push_back(i);
+			else
+				grid.others.push_back(i);
+		}
+	}
+
+	void Ephemerides::UpdateGrid(double time)
+	{
+		Trajectory& reference = *bodies[grid.bodies[0]].trajectory;
+		const size_t next = reference.getPoint(time);
+		const size_t prev = next == 0 ? 0 : next - 1;
+		const size_t n = grid.bodies.size();
+
+		if (prev < grid.begin || next >= grid.begin + grid.count)
+		{
+			grid.begin = prev;
+			grid.count = std::min(GridPoints, reference.times.size() - prev);
+			grid.positions.resize(grid.count * n);
+			grid.velocities.resize(grid.count * n);
+
+			for (size_t j = 0; j < n; j++)
+			{
+				const Trajectory& trajectory = *bodies[grid.bodies[j]].trajectory;
+				trajectory.positions.CopyTo(grid.begin, grid.count, &grid.positions[j * grid.count]);
+				trajectory.velocities.CopyTo(grid.begin, grid.count, &grid.velocities[j * grid.count]);
+			}
+		}
+
+		grid.from = reference.times[prev];
+		grid.to = reference.times[next];
+
+		for (size_t j = 0; j < n; j++)
+		{
+			const size_t first = j * grid.count + prev - grid.begin, second = j * grid.count + next - grid.begin;
+			SetSegment(grid.bodies[j], grid.from, grid.to,
+				(vec2d)grid.positions[first], (vec2d)grid.velocities[first],
+				(vec2d)grid.positions[second], (vec2d)grid.velocities[second]);
+		}
+	}
+
+	void Ephemerides::UpdateSegment(size_t body, double time)
+	{
+		Trajectory& trajectory = *bodies[body].trajectory;
+		const size_t next = trajectory.getPoint(time);
+		const size_t prev = next == 0 ? 0 : next - 1;
+
+		SetSegment(body, trajectory.times[prev], trajectory.times[next],
+			(vec2d)trajectory.positions[prev], (vec2d)trajectory.velocities[prev],
+			(vec2d)trajectory.positions[next], (vec2d)trajectory.velocities[next]);
+	}
+
+	void Ephemerides::SetSegment(size_t body, double from, double to, vec2d p0, vec2d v0, vec2d p1, vec2d v1)
+	{
+		const double h = to - from;
+		const vec2d m0 = v0 * h, m1 = v1 * h;
+
+		Segment& segment = segments[body];
+		segment.from = from;
+		segment.to = to;
+		segment.scale = to > from ? 1.0 / h : 0.0;
+		segment.coefficients = { p0, m0, 3.0 * (p1 - p0) - 2.0 * m0 - m1, 2.0 * (p0 - p1) + m0 + m1 };
+	}
+}
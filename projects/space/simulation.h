@@ -1,12 +1,250 @@
 #pragma once
 #include "point.h"
 #include "trajectory.h"
+#include "gravity.h"
+#include "checkpoints.h"
+#include "massPointGrid.h"
 #include <vector>
+#include <numeric>
+#include <limits>
+#include <algorithm>
+#include <span>
+#include <cmath>
+#include <array>
 
 namespace Simulation
 {
 	using namespace Magnum2D;
 
+	// tolerances of integrators with adaptive time step (PointDormandPrince)
+	struct AdaptiveSettings
+	{
+		double relativeTolerance = 1e-9;
+		double absoluteTolerance = 1e-12;
+		// zero means no limit, steps are always clamped to the time of next trajectory point
+		double minDt = 0.0;
+		double maxDt = 0.0;
+		// new step is scaled by safety * (1 / error)^(1/5), limited to [minScale, maxScale]
+		double safety = 0.9;
+		double minScale = 0.2;
+		double maxScale = 5.0;
+		// consecutive rejected steps after which simulation stops (e.g. non-finite state), trajectories end early
+		int32_t maxRejections = 50;
+	};
+
+	// counters filled by simulation, used for comparing integrators
+	struct Statistics
+	{
+		size_t steps = 0;
+		size_t rejectedSteps = 0;
+		// number of body accelerations computed (bodies * force evaluations)
+		size_t accelerations = 0;
+		// largest relative change of total energy and angular momentum from the beginning
+		// of simulation, measured at trajectory points (burns change both)
+		double energyDrift = 0.0;
+		double angularMomentumDrift = 0.0;
+		// adaptive step could not satisfy tolerance (AdaptiveSettings::maxRejections), simulation stopped early
+		bool failed = false;
+	};
+
+	// hierarchical block time steps of leapfrog (PointLeapfrog)
+	struct BlockTimestepSettings
+	{
+		// steps of points are (dt * 2^maxLevel) / 2^level, level in [0, maxLevel], zero means one shared step of at most dt
+		int32_t maxLevel = 6;
+		// desired step of point is eta * |a| / |da/dt|
+		double eta = 0.02;
+	};
+
+	// composition of kick-drift-kick steps used by PointLeapfrog
+	enum class SymplecticScheme : int32_t
+	{
+		Leapfrog = 0, // 2nd order, supports block time steps
+		Yoshida4,     // 4th order, 3 force evaluations per step
+		Yoshida6      // 6th order, 7 force evaluations per step
+	};
+
+	// precision of sums accumulated over the whole simulation by PointLeapfrog
+	enum class Precision : int32_t
+	{
+		Standard = 0, // plain double sums
+		Compensated   // Neumaier compensated sums of positions, velocities and direct gravity
+	};
+
+	// Policies of Precision, they keep additional state of each point and do its kicks and drifts.
+	// Plain sum loses the low bits of every small increment (v * dt, a * dt) added to large
+	// position or velocity, compensated one keeps them in separate error.
+	struct StandardPrecision
+	{
+		struct State {};
+		static constexpr bool CompensatedForces = false;
+
+		static void Kick(PointLeapfrog& point, State&, double dt) { point.kick(dt); }
+		static void Drift(PointLeapfrog& point, State&, double dt) { point.drift(dt); }
+	};
+
+	// errors are not part of checkpoints, run resumed from checkpoint starts without them
+	struct CompensatedPrecision
+	{
+		struct State
+		{
+			Magnum2D::vec2d positionError;
+			Magnum2D::vec2d velocityError;
+		};
+		static constexpr bool CompensatedForces = true;
+
+		static void Kick(PointLeapfrog& point, State& state, double dt)
+		{
+			Utils::AddCompensated(point.velocity, state.velocityError, point.acceleration * dt);
+		}
+		static void Drift(PointLeapfrog& point, State& state, double dt)
+		{
+			Utils::AddCompensated(point.position, state.positionError, (point.velocity + state.velocityError) * dt);
+		}
+	};
+
+	// Bodies moving along stored trajectories instead of being integrated (prescribed ephemerides).
+	// Simulated points are attracted by them, but they are not affected by simulated points.
+	struct Ephemerides
+	{
+		struct Body
+		{
+			Trajectory* trajectory;
+			double mass;
+		};
+
+		std::vector<Body> bodies;
+
+		// Adds accelerations caused by bodies at given time. When active is not empty, only listed
+		// points are updated.
+		void Accumulate(double time, std::span<const vec2d> positions, std::span<vec2d> accelerations, std::span<const size_t> active = {});
+
+	private:
+		// Interval of trajectory points around last evaluated time of body. Integration asks for
+		// times close to each other, so trajectory is searched only when time leaves the interval.
+		struct Segment
+		{
+			double from = 0.0;
+			double to = -1.0;
+			// 1 / (to - from), zero for single point
+			double scale = 0.0;
+			// Hermite polynomial of position in s = (time - from) * scale, coefficients of s^0 .. s^3
+			std::array<vec2d, 4> coefficients;
+		};
+
+		// Bodies simulated together have the same times of trajectory points. Their points are copied
+		// in blocks ordered by time, so the next interval of all of them is read from consecutive memory
+		// instead of searching trajectories body by body.
+		struct Grid
+		{
+			// bodies with the same times as the first body, the others are searched separately
+			std::vector<size_t> bodies;
+			std::vector<size_t> others;
+			double from = 0.0;
+			double to = -1.0;
+			// points [begin, begin + count) of grid bodies, index is body * count + point
+			size_t begin = 0;
+			size_t count = 0;
+			std::vector<vec2> positions, velocities;
+		};
+
+		// number of points of grid block
+		static const size_t GridPoints = 64;
+
+		void Initialize();
+		void UpdateGrid(double time);
+		void UpdateSegment(size_t body, double time);
+		void SetSegment(size_t body, double from, double to, vec2d p0, vec2d v0, vec2d p1, vec2d v1);
+
+		std::vector<Segment> segments;
+		Grid grid;
+		// positions of bodies at positionsTime, attract points with vectorized kernel
+		BodyStore store;
+		double positionsTime = std::numeric_limits<double>::quiet_NaN();
+	};
+
+	struct Settings
+	{
+		Gravity::Settings gravity;
+		AdaptiveSettings adaptive;
+		BlockTimestepSettings blockTimesteps;
+		SymplecticScheme symplectic = SymplecticScheme::Leapfrog;
+		Precision precision = Precision::Standard;
+		// optional output, counters are added to the existing values
+		Statistics* statistics = nullptr;
+		// optional bodies which are not integrated, their trajectories must cover simulated time
+		Ephemerides* ephemerides = nullptr;
+		// optional output, snapshots of state at trajectory points, later ones are replaced
+		Checkpoints* checkpoints = nullptr;
+	};
+
+	// kinetic and potential energy of all points
+	template<typename T>
+	double ComputeEnergy(std::vector<T>& points)
+	{
+		double result = 0.0;
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			result += 0.5 * points[i].getMass() * points[i].getVelocity().dot();
+
+			for (size_t j = i + 1; j < points.size(); j++)
+			{
+				double distance = (points[j].position - points[i].position).length();
+				if (distance > 0.0)
+					result -= GravitationalConstant * points[i].getMass() * points[j].getMass() / distance;
+			}
+		}
+		return result;
+	}
+
+	// angular momentum of all points around origin
+	template<typename T>
+	double ComputeAngularMomentum(std::vector<T>& points)
+	{
+		double result = 0.0;
+		for (auto& point : points)
+		{
+			vec2d velocity = point.getVelocity();
+			result += point.getMass() * (point.position.x() * velocity.y() - point.position.y() * velocity.x());
+		}
+		return result;
+	}
+
+	// Tracks drift of conserved quantities into statistics, does nothing when they are not requested.
+	// Energy is O(N^2), so it is evaluated only at trajectory points.
+	template<typename T>
+	struct DriftMonitor
+	{
+		DriftMonitor(Statistics* statistics, std::vector<T>& points)
+			: statistics(statistics)
+		{
+			if (!statistics)
+				return;
+
+			initialEnergy = ComputeEnergy(points);
+			initialAngularMomentum = ComputeAngularMomentum(points);
+		}
+
+		void Update(std::vector<T>& points)
+		{
+			if (!statistics)
+				return;
+
+			statistics->energyDrift = std::max(statistics->energyDrift, GetRelativeChange(initialEnergy, ComputeEnergy(points)));
+			statistics->angularMomentumDrift = std::max(statistics->angularMomentumDrift, GetRelativeChange(initialAngularMomentum, ComputeAngularMomentum(points)));
+		}
+
+	private:
+		static double GetRelativeChange(double initial, double current)
+		{
+			return initial != 0.0 ? std::abs((current - initial) / initial) : std::abs(current);
+		}
+
+		Statistics* statistics;
+		double initialEnergy = 0.0;
+		double initialAngularMomentum = 0.0;
+	};
+
 	template<typename T>
 	void ApplyBurnIfNeeded(T& point, const std::vector<BurnPtr>& burns, size_t& currentBurn, double accumulatedTime)
 	{
@@ -34,9 +272,10 @@ namespace Simulation
 
 	// TODO this template can be called instead of runge-kutta
 	template<typename T>
-	std::vector<Trajectory> Simulate(std::vector<T>& points, const std::vector<std::vector<BurnPtr>>& burns, double dt, double seconds, double timeOffset = 0.0, int32_t numPoints = 60)
+	std::vector<Trajectory> Simulate(std::vector<T>& points, const std::vector<std::vector<BurnPtr>>& burns, double dt, double seconds, double timeOffset = 0.0, int32_t numPoints = 60,
+									 const Settings& settings = {})
 	{
-		std::vector<Trajectory> result(points.size(), Trajectory{ {} });
+		std::vector<Trajectory> result(points.size(), Trajectory());
 
 		for (auto& t : result)
 		{
@@ -49,13 +288,25 @@ namespace Simulation
 		{
 			result[i].positions.push_back((vec2)points[i].position);
 			result[i].velocities.push_back((vec2)points[i].getVelocity());
-			result[i].times.push_back(0.0f);
+			result[i].times.push_back(timeOffset);
 		}
 
 		int32_t steps = std::ceil(seconds / dt);
 		std::vector<size_t> burnIndex(burns.size(), 0);
 
-		std::vector<double> accelerations(points.size(), 0.0);
+		if (settings.checkpoints)
+			settings.checkpoints->Capture(timeOffset, dt, points, burnIndex);
+
+		ThreadPool pool(settings.gravity.threads);
+		Gravity::Solver solver(&pool);
+		std::vector<vec2d> positions(points.size());
+		std::vector<double> masses(points.size());
+		std::vector<vec2d> accelerations(points.size());
+
+		for (size_t j = 0; j < points.size(); j++)
+			masses[j] = points[j].getMass();
+
+		DriftMonitor driftMonitor(settings.statistics, points);
 
 		double accumulatedTime = 0.0;
 		for (int i = 0; i < steps; i++)
@@ -65,10 +316,22 @@ namespace Simulation
 
 			// update accelerations
 			for (size_t j = 0; j < points.size(); j++)
+				positions[j] = points[j].position;
+
+			solver.Compute(settings.gravity, positions, masses, accelerations);
+
+			if (settings.ephemerides)
+				settings.ephemerides->Accumulate(timeOffset + accumulatedTime, positions, accelerations);
+
+			if (settings.statistics)
 			{
-				points[j].prepareStep(points, dt, j);
+				settings.statistics->steps++;
+				settings.statistics->accelerations += points.size();
 			}
 
+			for (size_t j = 0; j < points.size(); j++)
+				points[j].acceleration = accelerations[j];
+
 			// update velocities and positions
 			for (size_t j = 0; j < points.size(); j++)
 			{
@@ -87,15 +350,20 @@ namespace Simulation
 					result[j].velocities.push_back((vec2)points[j].getVelocity());
 					result[j].times.push_back(timeOffset + accumulatedTime);
 				}
+				driftMonitor.Update(points);
+
+				if (settings.checkpoints)
+					settings.checkpoints->Capture(timeOffset + accumulatedTime, dt, points, burnIndex);
 			}
 		}
 
 		return result;
 	}
 
-	static std::vector<Trajectory> Simulate(std::vector<PointRungeKutta>& points, const std::vector<std::vector<BurnPtr>>& burns, double dt, double seconds, double timeOffset, int32_t numPoints)
+	static std::vector<Trajectory> Simulate(std::vector<PointRungeKutta>& points, const std::vector<std::vector<BurnPtr>>& burns, double dt, double seconds, double timeOffset, int32_t numPoints,
+											const Settings& settings = {})
 	{
-		std::vector<Trajectory> result(points.size(), Trajectory{ {} });
+		std::vector<Trajectory> result(points.size(), Trajectory());
 
 		for (auto& t : result)
 		{
@@ -108,13 +376,52 @@ namespace Simulation
 		{
 			result[i].positions.push_back((vec2)points[i].position);
 			result[i].velocities.push_back((vec2)points[i].getVelocity());
-			result[i].times.push_back(0.0f);
+			result[i].times.push_back(timeOffset);
 		}
 
 		int32_t steps = std::ceil(seconds / dt);
 		std::vector<size_t> burnIndex(burns.size(), 0);
 
-		std::vector<double> accelerations(points.size(), 0.0);
+		if (settings.checkpoints)
+			settings.checkpoints->Capture(timeOffset, dt, points, burnIndex);
+
+		ThreadPool pool(settings.gravity.threads);
+		Gravity::Solver solver(&pool);
+		std::vector<vec2d> positions(points.size());
+		std::vector<double> masses(points.size());
+		std::vector<vec2d> accelerations(points.size());
+
+		for (size_t j = 0; j < points.size(); j++)
+			masses[j] = points[j].getMass();
+
+		DriftMonitor driftMonitor(settings.statistics, points);
+
+		// each point of the stage is updated independently, pool returns when all are done
+		// so there is a barrier between stages
+		auto forEachPoint = [&](auto&& func)
+		{
+			pool.ParallelFor(points.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t j = begin; j < end; j++)
+					func(points[j], j);
+			});
+		};
+
+		// accelerations at temporary positions of all points, the tree of Barnes-Hut is
+		// built only in the first stage and refitted in the others
+		auto computeAccelerationsTemp = [&](double time, bool rebuild)
+		{
+			for (size_t j = 0; j < points.size(); j++)
+				positions[j] = points[j].positionTemp;
+
+			solver.Compute(settings.gravity, positions, masses, accelerations, rebuild);
+
+			if (settings.ephemerides)
+				settings.ephemerides->Accumulate(timeOffset + time, positions, accelerations);
+
+			if (settings.statistics)
+				settings.statistics->accelerations += points.size();
+		};
 
 		double accumulatedTime = 0.0;
 		for (int i = 0; i < steps; i++)
@@ -122,32 +429,30 @@ namespace Simulation
 			// apply burns
 			ApplyBurns(points, burns, burnIndex, accumulatedTime);
 
-			for (size_t j = 0; j < points.size(); j++)
-				points[j].stepK1Begin(dt);
-			for (size_t j = 0; j < points.size(); j++)
-				points[j].stepK1End(points, dt, j);
+			forEachPoint([dt](PointRungeKutta& p, size_t) { p.stepK1Begin(dt); });
+			computeAccelerationsTemp(accumulatedTime, true);
+			forEachPoint([&](PointRungeKutta& p, size_t j) { p.stepK1End(accelerations[j], dt); });
 
-			for (size_t j = 0; j < points.size(); j++)
-				points[j].stepK2Begin(dt);
-			for (size_t j = 0; j < points.size(); j++)
-				points[j].stepK2End(points, dt, j);
+			forEachPoint([dt](PointRungeKutta& p, size_t) { p.stepK2Begin(dt); });
+			computeAccelerationsTemp(accumulatedTime + 0.5 * dt, false);
+			forEachPoint([&](PointRungeKutta& p, size_t j) { p.stepK2End(accelerations[j], dt); });
 
-			for (size_t j = 0; j < points.size(); j++)
-				points[j].stepK3Begin(dt);
-			for (size_t j = 0; j < points.size(); j++)
-				points[j].stepK3End(points, dt, j);
+			forEachPoint([dt](PointRungeKutta& p, size_t) { p.stepK3Begin(dt); });
+			computeAccelerationsTemp(accumulatedTime + 0.5 * dt, false);
+			forEachPoint([&](PointRungeKutta& p, size_t j) { p.stepK3End(accelerations[j], dt); });
 
-			for (size_t j = 0; j < points.size(); j++)
-				points[j].stepK4Begin(dt);
-			for (size_t j = 0; j < points.size(); j++)
-				points[j].stepK4End(points, dt, j);
+			forEachPoint([dt](PointRungeKutta& p, size_t) { p.stepK4Begin(dt); });
+			computeAccelerationsTemp(accumulatedTime + dt, false);
+			forEachPoint([&](PointRungeKutta& p, size_t j) { p.stepK4End(accelerations[j], dt); });
 
 			// update velocities and positions
-			for (size_t j = 0; j < points.size(); j++)
-				points[j].step(dt);
+			forEachPoint([dt](PointRungeKutta& p, size_t) { p.step(dt); });
 
 			accumulatedTime += dt;
 
+			if (settings.statistics)
+				settings.statistics->steps++;
+
 			// update trajectories
 			int32_t expectedPoints = (accumulatedTime * (double)numPoints) / seconds;
 			if (!result.empty() && expectedPoints > result[0].times.size())
@@ -158,25 +463,579 @@ namespace Simulation
 					result[j].velocities.push_back((vec2)points[j].getVelocity());
 					result[j].times.push_back(timeOffset + accumulatedTime);
 				}
+				driftMonitor.Update(points);
+
+				if (settings.checkpoints)
+					settings.checkpoints->Capture(timeOffset + accumulatedTime, dt, points, burnIndex);
 			}
 		}
 
 		return result;
 	}
 
-	// simulate single point given static mass points
-	template<typename T>
-	std::tuple<std::vector<vec2d>, std::vector<double>> Simulate(T& point, const std::vector<MassPoint>& massPoints, const std::vector<BurnPtr>& burns, double dt, double seconds, int32_t numPoints)
+	// Adaptive time step, dt is only the initial guess. Steps are clamped so they end exactly at
+	// times of trajectory points and burns, all bodies share the same steps, so trajectories
+	// have the same times as with fixed step integrators. Simulation stops with shorter trajectories
+	// when step is rejected more than maxRejections times in a row.
+	static std::vector<Trajectory> Simulate(std::vector<PointDormandPrince>& points, const std::vector<std::vector<BurnPtr>>& burns, double dt, double seconds, double timeOffset, int32_t numPoints,
+											const Settings& settings = {})
 	{
-		std::vector<vec2d> points;
-		std::vector<double> times;
-		points.reserve(numPoints);
-		times.reserve(numPoints);
+		std::vector<Trajectory> result(points.size(), Trajectory());
+
+		for (auto& t : result)
+		{
+			t.positions.reserve(numPoints);
+			t.velocities.reserve(numPoints);
+			t.times.reserve(numPoints);
+		}
+
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			result[i].positions.push_back((vec2)points[i].position);
+			result[i].velocities.push_back((vec2)points[i].getVelocity());
+			result[i].times.push_back(timeOffset);
+		}
+
+		if (points.empty() || seconds <= 0.0)
+			return result;
+
+		std::vector<size_t> burnIndex(burns.size(), 0);
+
+		if (settings.checkpoints)
+			settings.checkpoints->Capture(timeOffset, dt, points, burnIndex);
+		const AdaptiveSettings& adaptive = settings.adaptive;
+
+		ThreadPool pool(settings.gravity.threads);
+		Gravity::Solver solver(&pool);
+		std::vector<vec2d> positions(points.size());
+		std::vector<double> masses(points.size());
+		std::vector<vec2d> accelerations(points.size());
+		std::vector<double> errors(points.size());
+
+		for (size_t j = 0; j < points.size(); j++)
+			masses[j] = points[j].getMass();
+
+		DriftMonitor driftMonitor(settings.statistics, points);
+
+		auto forEachPoint = [&](auto&& func)
+		{
+			pool.ParallelFor(points.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t j = begin; j < end; j++)
+					func(points[j], j);
+			});
+		};
+
+		auto computeStage = [&](size_t stage, double stepStart, double h, bool rebuild)
+		{
+			forEachPoint([stage, h](PointDormandPrince& p, size_t) { p.stepStageBegin(stage, h); });
+
+			for (size_t j = 0; j < points.size(); j++)
+				positions[j] = points[j].positionTemp;
+
+			solver.Compute(settings.gravity, positions, masses, accelerations, rebuild);
+
+			if (settings.ephemerides)
+				settings.ephemerides->Accumulate(timeOffset + stepStart + PointDormandPrince::GetStageTime(stage) * h, positions, accelerations);
+
+			if (settings.statistics)
+				settings.statistics->accelerations += points.size();
+
+			forEachPoint([&, stage](PointDormandPrince& p, size_t j) { p.stepStageEnd(stage, accelerations[j]); });
+		};
+
+		auto getNextBurnTime = [&]()
+		{
+			double time = std::numeric_limits<double>::max();
+			for (size_t j = 0; j < burns.size(); j++)
+			{
+				if (burnIndex[j] < burns[j].size())
+					time = std::min(time, burns[j][burnIndex[j]]->time);
+			}
+			return time;
+		};
+
+		auto getBurnCount = [&]()
+		{
+			return std::accumulate(std::begin(burnIndex), std::end(burnIndex), (size_t)0);
+		};
+
+		const double sampleInterval = seconds / (double)numPoints;
+		int32_t sampleIndex = 1;
+		double h = adaptive.maxDt > 0.0 ? std::min(dt, adaptive.maxDt) : dt;
+		// derivative at the current state is known from the last stage of previous step
+		bool firstStageValid = false;
+		int32_t rejections = 0;
+
+		double accumulatedTime = 0.0;
+		while (sampleIndex <= numPoints)
+		{
+			// apply burns, they change velocity so the first stage has to be recomputed
+			size_t burnCount = getBurnCount();
+			ApplyBurns(points, burns, burnIndex, accumulatedTime);
+			if (getBurnCount() != burnCount)
+				firstStageValid = false;
+
+			// end the step exactly at the next event
+			double sampleTime = sampleIndex == numPoints ? seconds : sampleIndex * sampleInterval;
+			double eventTime = std::min(sampleTime, getNextBurnTime());
+			if (eventTime <= accumulatedTime)
+				eventTime = sampleTime;
+
+			bool reachesEvent = accumulatedTime + h >= eventTime;
+			double stepDt = reachesEvent ? eventTime - accumulatedTime : h;
+
+			// the tree of Barnes-Hut is built in the first computed stage, refitted in the others
+			const size_t firstStage = firstStageValid ? 1 : 0;
+			for (size_t stage = firstStage; stage < PointDormandPrince::Stages; stage++)
+				computeStage(stage, accumulatedTime, stepDt, stage == firstStage);
+
+			forEachPoint([&](PointDormandPrince& p, size_t j)
+			{
+				errors[j] = p.estimateError(stepDt, adaptive.absoluteTolerance, adaptive.relativeTolerance);
+			});
+
+			// rms over all position and velocity components, summed in fixed order
+			double error = 0.0;
+			for (double e : errors)
+				error += e;
+			error = std::sqrt(error / (2.0 * (double)points.size()));
+
+			// non-finite error (overflow or nan in state) is rejected with the largest shrink
+			const bool finite = std::isfinite(error);
+			double scale = !finite ? adaptive.minScale : error == 0.0 ? adaptive.maxScale : std::clamp(adaptive.safety * std::pow(error, -0.2), adaptive.minScale, adaptive.maxScale);
+			bool accept = finite && (error <= 1.0 || stepDt <= adaptive.minDt);
+
+			if (!accept)
+			{
+				if (settings.statistics)
+					settings.statistics->rejectedSteps++;
+
+				if (++rejections > adaptive.maxRejections)
+				{
+					if (settings.statistics)
+						settings.statistics->failed = true;
+					break;
+				}
+
+				// the first stage does not depend on dt, it stays valid
+				firstStageValid = true;
+				h = std::max(stepDt * scale, adaptive.minDt);
+				continue;
+			}
+			rejections = 0;
+
+			forEachPoint([stepDt](PointDormandPrince& p, size_t)
+			{
+				p.step(stepDt);
+				p.reuseLastStage();
+			});
+			firstStageValid = true;
+
+			// step shortened by the event should not limit the next one
+			h = std::max(reachesEvent ? std::max(h, stepDt * scale) : stepDt * scale, adaptive.minDt);
+			if (adaptive.maxDt > 0.0)
+				h = std::min(h, adaptive.maxDt);
+
+			accumulatedTime = reachesEvent ? eventTime : accumulatedTime + stepDt;
+
+			if (settings.statistics)
+				settings.statistics->steps++;
+
+			// update trajectories
+			if (reachesEvent && eventTime == sampleTime)
+			{
+				for (size_t j = 0; j < points.size(); j++)
+				{
+					result[j].positions.push_back((vec2)points[j].position);
+					result[j].velocities.push_back((vec2)points[j].getVelocity());
+					result[j].times.push_back(timeOffset + accumulatedTime);
+				}
+				driftMonitor.Update(points);
+
+				if (settings.checkpoints)
+					settings.checkpoints->Capture(timeOffset + accumulatedTime, h, points, burnIndex);
+				sampleIndex++;
+			}
+		}
+
+		return result;
+	}
+
+	// Kick-drift-kick leapfrog with hierarchical block time steps. Block of length up to
+	// dt * 2^maxLevel is split to power of two steps, each point picks its level from
+	// acceleration and its change. All points drift every substep, but only points at the end
+	// of their step get new acceleration. Points are synchronized at the end of every block,
+	// blocks end exactly at times of trajectory points.
+	template<class P>
+	static std::vector<Trajectory> SimulateBlockTimesteps(std::vector<PointLeapfrog>& points, const std::vector<std::vector<BurnPtr>>& burns, double dt, double seconds, double timeOffset, int32_t numPoints,
+														  const Settings& settings)
+	{
+		std::vector<Trajectory> result(points.size(), Trajectory());
+
+		for (auto& t : result)
+		{
+			t.positions.reserve(numPoints);
+			t.velocities.reserve(numPoints);
+			t.times.reserve(numPoints);
+		}
+
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			result[i].positions.push_back((vec2)points[i].position);
+			result[i].velocities.push_back((vec2)points[i].getVelocity());
+			result[i].times.push_back(timeOffset);
+		}
+
+		if (points.empty() || seconds <= 0.0)
+			return result;
+
+		std::vector<size_t> burnIndex(burns.size(), 0);
+
+		if (settings.checkpoints)
+			settings.checkpoints->Capture(timeOffset, dt, points, burnIndex);
+		const BlockTimestepSettings& block = settings.blockTimesteps;
+		const int32_t maxLevel = std::clamp(block.maxLevel, 0, 30);
+		const uint64_t blockTicks = (uint64_t)1 << maxLevel;
+
+		ThreadPool pool(settings.gravity.threads);
+		Gravity::Solver solver(&pool);
+		Gravity::Settings gravity = settings.gravity;
+		gravity.compensated = gravity.compensated || P::CompensatedForces;
+		std::vector<typename P::State> precision(points.size());
+		std::vector<vec2d> positions(points.size());
+		std::vector<vec2d> positionErrors(P::CompensatedForces ? points.size() : 0);
+		gravity.positionErrors = positionErrors;
+		std::vector<double> masses(points.size());
+		std::vector<vec2d> accelerations(points.size());
+		// tick at which the current step of point ends, tick is the step of the finest level
+		std::vector<uint64_t> stepEnd(points.size());
+		std::vector<size_t> active;
+		active.reserve(points.size());
+
+		for (size_t j = 0; j < points.size(); j++)
+			masses[j] = points[j].getMass();
+
+		DriftMonitor driftMonitor(settings.statistics, points);
+
+		auto computeAccelerations = [&](double time)
+		{
+			for (size_t j = 0; j < points.size(); j++)
+			{
+				positions[j] = points[j].position;
+				if constexpr (P::CompensatedForces)
+					positionErrors[j] = precision[j].positionError;
+			}
+
+			solver.ComputeActive(gravity, positions, masses, accelerations, active);
+
+			if (settings.ephemerides)
+				settings.ephemerides->Accumulate(timeOffset + time, positions, accelerations, active);
+
+			if (settings.statistics)
+			{
+				settings.statistics->steps++;
+				settings.statistics->accelerations += active.size();
+			}
+		};
+
+		auto forEachActive = [&](auto&& func)
+		{
+			pool.ParallelFor(active.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+					func(points[active[i]], active[i]);
+			});
+		};
+
+		// points without acceleration start at the finest level
+		for (size_t j = 0; j < points.size(); j++)
+		{
+			if (points[j].level < 0)
+				active.push_back(j);
+			else
+				points[j].level = std::min(points[j].level, maxLevel);
+		}
+
+		if (!active.empty())
+		{
+			computeAccelerations(0.0);
+			forEachActive([&](PointLeapfrog& p, size_t j)
+			{
+				p.acceleration = accelerations[j];
+				p.level = maxLevel;
+			});
+		}
+
+		const double sampleInterval = seconds / (double)numPoints;
+		const int32_t blocksPerSample = std::max((int32_t)std::ceil(sampleInterval / (dt * (double)blockTicks)), 1);
+		const double blockDt = sampleInterval / (double)blocksPerSample;
+		const double tickDt = blockDt / (double)blockTicks;
+
+		auto getTicks = [&](int32_t level) { return blockTicks >> level; };
+
+		// step from eta * |a| / |da/dt| rounded down to power of two fraction of the block,
+		// coarser level only by one at a time and when the new step is aligned to the block
+		auto selectLevel = [&](const PointLeapfrog& p, const vec2d& jerk, uint64_t tick)
+		{
+			int32_t level = 0;
+			double jerkLength = jerk.length();
+			if (jerkLength > 0.0)
+			{
+				double stepDt = block.eta * p.acceleration.length() / jerkLength;
+				level = stepDt > 0.0 ? (int32_t)std::ceil(std::log2(blockDt / stepDt)) : maxLevel;
+				level = std::clamp(level, 0, maxLevel);
+			}
+
+			if (level >= p.level)
+				return level;
+			if (tick % getTicks(p.level - 1) == 0)
+				return p.level - 1;
+			return p.level;
+		};
+
+		double accumulatedTime = 0.0;
+		for (int32_t sample = 1; sample <= numPoints; sample++)
+		{
+			for (int32_t b = 0; b < blocksPerSample; b++)
+			{
+				// apply burns
+				ApplyBurns(points, burns, burnIndex, accumulatedTime);
+
+				// all points start their step at the beginning of the block
+				for (size_t j = 0; j < points.size(); j++)
+				{
+					P::Kick(points[j], precision[j], 0.5 * (double)getTicks(points[j].level) * tickDt);
+					stepEnd[j] = getTicks(points[j].level);
+				}
+
+				uint64_t tick = 0;
+				while (tick < blockTicks)
+				{
+					uint64_t next = *std::min_element(std::begin(stepEnd), std::end(stepEnd));
+					double driftDt = (double)(next - tick) * tickDt;
+
+					pool.ParallelFor(points.size(), [&](size_t begin, size_t end)
+					{
+						for (size_t j = begin; j < end; j++)
+							P::Drift(points[j], precision[j], driftDt);
+					});
+					tick = next;
+
+					active.clear();
+					for (size_t j = 0; j < points.size(); j++)
+					{
+						if (stepEnd[j] == tick)
+							active.push_back(j);
+					}
+
+					computeAccelerations(accumulatedTime + (double)tick * tickDt);
+
+					// closing kick with new acceleration, then opening kick of the next step
+					forEachActive([&](PointLeapfrog& p, size_t j)
+					{
+						double h = (double)getTicks(p.level) * tickDt;
+						vec2d jerk = (accelerations[j] - p.acceleration) / h;
+
+						p.acceleration = accelerations[j];
+						P::Kick(p, precision[j], 0.5 * h);
+						p.level = selectLevel(p, jerk, tick);
+
+						if (tick < blockTicks)
+						{
+							P::Kick(p, precision[j], 0.5 * (double)getTicks(p.level) * tickDt);
+							stepEnd[j] = tick + getTicks(p.level);
+						}
+					});
+				}
 
-		points.push_back(point.position);
-		times.push_back(0.0f);
+				accumulatedTime = (double)(sample - 1) * sampleInterval + (double)(b + 1) * blockDt;
+			}
+
+			// update trajectories
+			for (size_t j = 0; j < points.size(); j++)
+			{
+				result[j].positions.push_back((vec2)points[j].position);
+				result[j].velocities.push_back((vec2)points[j].getVelocity());
+				result[j].times.push_back(timeOffset + accumulatedTime);
+			}
+			driftMonitor.Update(points);
+
+			if (settings.checkpoints)
+				settings.checkpoints->Capture(timeOffset + accumulatedTime, dt, points, burnIndex);
+		}
+
+		return result;
+	}
+
+	// Leapfrog steps composed with given coefficients (Yoshida), one shared step for all points,
+	// steps are aligned to times of trajectory points.
+	template<class P>
+	static std::vector<Trajectory> SimulateComposition(std::vector<PointLeapfrog>& points, const std::vector<std::vector<BurnPtr>>& burns, double dt, double seconds, double timeOffset, int32_t numPoints,
+													   const Settings& settings, std::span<const double> coefficients)
+	{
+		std::vector<Trajectory> result(points.size(), Trajectory());
+
+		for (auto& t : result)
+		{
+			t.positions.reserve(numPoints);
+			t.velocities.reserve(numPoints);
+			t.times.reserve(numPoints);
+		}
+
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			result[i].positions.push_back((vec2)points[i].position);
+			result[i].velocities.push_back((vec2)points[i].getVelocity());
+			result[i].times.push_back(timeOffset);
+		}
+
+		if (points.empty() || seconds <= 0.0)
+			return result;
+
+		std::vector<size_t> burnIndex(burns.size(), 0);
+
+		if (settings.checkpoints)
+			settings.checkpoints->Capture(timeOffset, dt, points, burnIndex);
+
+		ThreadPool pool(settings.gravity.threads);
+		Gravity::Solver solver(&pool);
+		Gravity::Settings gravity = settings.gravity;
+		gravity.compensated = gravity.compensated || P::CompensatedForces;
+		std::vector<typename P::State> precision(points.size());
+		std::vector<vec2d> positions(points.size());
+		std::vector<vec2d> positionErrors(P::CompensatedForces ? points.size() : 0);
+		gravity.positionErrors = positionErrors;
+		std::vector<double> masses(points.size());
+		std::vector<vec2d> accelerations(points.size());
+
+		for (size_t j = 0; j < points.size(); j++)
+			masses[j] = points[j].getMass();
+
+		DriftMonitor driftMonitor(settings.statistics, points);
+
+		auto forEachPoint = [&](auto&& func)
+		{
+			pool.ParallelFor(points.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t j = begin; j < end; j++)
+					func(points[j], j);
+			});
+		};
+
+		auto computeAccelerations = [&](double time)
+		{
+			for (size_t j = 0; j < points.size(); j++)
+			{
+				positions[j] = points[j].position;
+				if constexpr (P::CompensatedForces)
+					positionErrors[j] = precision[j].positionError;
+			}
+
+			solver.Compute(gravity, positions, masses, accelerations);
+
+			if (settings.ephemerides)
+				settings.ephemerides->Accumulate(timeOffset + time, positions, accelerations);
+
+			if (settings.statistics)
+				settings.statistics->accelerations += points.size();
+
+			forEachPoint([&](PointLeapfrog& p, size_t j) { p.acceleration = accelerations[j]; });
+		};
+
+		// acceleration is kept in points between calls (also by block time steps)
+		if (std::any_of(std::begin(points), std::end(points), [](const PointLeapfrog& p) { return p.level < 0; }))
+			computeAccelerations(0.0);
+
+		const double sampleInterval = seconds / (double)numPoints;
+		const int32_t stepsPerSample = std::max((int32_t)std::ceil(sampleInterval / dt), 1);
+		const double stepDt = sampleInterval / (double)stepsPerSample;
+
+		double accumulatedTime = 0.0;
+		for (int32_t sample = 1; sample <= numPoints; sample++)
+		{
+			for (int32_t i = 0; i < stepsPerSample; i++)
+			{
+				// apply burns
+				ApplyBurns(points, burns, burnIndex, accumulatedTime);
+
+				// time of positions after drifts of the step
+				double driftedTime = accumulatedTime;
+				for (double c : coefficients)
+				{
+					const double h = c * stepDt;
+					forEachPoint([&](PointLeapfrog& p, size_t j)
+					{
+						P::Kick(p, precision[j], 0.5 * h);
+						P::Drift(p, precision[j], h);
+					});
+					driftedTime += h;
+					computeAccelerations(driftedTime);
+					forEachPoint([&](PointLeapfrog& p, size_t j) { P::Kick(p, precision[j], 0.5 * h); });
+				}
+
+				accumulatedTime = (double)(sample - 1) * sampleInterval + (double)(i + 1) * stepDt;
+
+				if (settings.statistics)
+					settings.statistics->steps++;
+			}
+
+			// update trajectories
+			for (size_t j = 0; j < points.size(); j++)
+			{
+				result[j].positions.push_back((vec2)points[j].position);
+				result[j].velocities.push_back((vec2)points[j].getVelocity());
+				result[j].times.push_back(timeOffset + accumulatedTime);
+			}
+			driftMonitor.Update(points);
+
+			if (settings.checkpoints)
+				settings.checkpoints->Capture(timeOffset + accumulatedTime, dt, points, burnIndex);
+		}
+
+		for (auto& p : points)
+			p.level = std::max(p.level, 0);
+
+		return result;
+	}
+
+	static std::vector<Trajectory> Simulate(std::vector<PointLeapfrog>& points, const std::vector<std::vector<BurnPtr>>& burns, double dt, double seconds, double timeOffset, int32_t numPoints,
+											const Settings& settings = {})
+	{
+		// w1 = 1 / (2 - 2^(1/3)), w0 = 1 - 2 * w1
+		static const double Yoshida4[] = { 1.3512071919596578, -1.7024143839193153, 1.3512071919596578 };
+		// solution A of Yoshida (1990), w0 = 1 - 2 * (w1 + w2 + w3)
+		static const double Yoshida6[] = { 0.784513610477560, 0.235573213359357, -1.17767998417887, 1.31518632068391,
+										   -1.17767998417887, 0.235573213359357, 0.784513610477560 };
+
+		auto simulate = [&]<class P>(P)
+		{
+			switch (settings.symplectic)
+			{
+			case SymplecticScheme::Yoshida4:
+				return SimulateComposition<P>(points, burns, dt, seconds, timeOffset, numPoints, settings, Yoshida4);
+			case SymplecticScheme::Yoshida6:
+				return SimulateComposition<P>(points, burns, dt, seconds, timeOffset, numPoints, settings, Yoshida6);
+			default:
+				return SimulateBlockTimesteps<P>(points, burns, dt, seconds, timeOffset, numPoints, settings);
+			}
+		};
+
+		if (settings.precision == Precision::Compensated)
+			return simulate(CompensatedPrecision{});
+		return simulate(StandardPrecision{});
+	}
+
+	// Simulate single point given static mass points, only mass points whose effective radius covers the point
+	// attract it. output(position, time) is called for each trajectory point. Burn positions are set only with
+	// setBurnPositions, so several points can be simulated with the same burns in parallel.
+	template<typename T, typename F>
+	void SimulatePoint(T& point, const MassPointGrid& grid, const std::vector<BurnPtr>& burns, double dt, double seconds, int32_t numPoints, bool setBurnPositions, F&& output)
+	{
+		output(point.position, 0.0);
 
 		int32_t steps = std::ceil(seconds / dt);
+		int32_t outputPoints = 1;
 		size_t burnIndex = 0;
 
 		double accumulatedTime = 0.0;
@@ -187,24 +1046,56 @@ namespace Simulation
 				if (accumulatedTime >= burns[burnIndex]->time)
 				{
 					point.addVelocity(burns[burnIndex]->velocity);
-					burns[burnIndex]->simulatedPosition = point.position;
+					if (setBurnPositions)
+						burns[burnIndex]->simulatedPosition = point.position;
 					burnIndex++;
 				}
 			}
 
-			point.prepareStep(massPoints, dt);
+			point.prepareStep(grid, dt);
 
 			point.step(dt);
 
 			accumulatedTime += dt;
 			int32_t expectedPoints = (accumulatedTime * (double)numPoints) / seconds;
-			if (expectedPoints > times.size())
+			if (expectedPoints > outputPoints)
 			{
-				points.push_back(point.position);
-				times.push_back(accumulatedTime);
+				output(point.position, accumulatedTime);
+				outputPoints++;
 			}
 		}
+	}
+
+	template<typename T>
+	std::tuple<std::vector<vec2d>, std::vector<double>> Simulate(T& point, const std::vector<MassPoint>& massPoints, const std::vector<BurnPtr>& burns, double dt, double seconds, int32_t numPoints)
+	{
+		MassPointGrid grid;
+		grid.Build(massPoints);
+
+		std::vector<vec2d> points;
+		std::vector<double> times;
+		points.reserve(numPoints);
+		times.reserve(numPoints);
+
+		SimulatePoint(point, grid, burns, dt, seconds, numPoints, true, [&](const vec2d& position, double time)
+		{
+			points.push_back(position);
+			times.push_back(time);
+		});
 
 		return { points, times };
 	}
+
+	// trajectory is replaced, positions are written directly as floats
+	template<typename T>
+	void Simulate(T& point, const MassPointGrid& grid, const std::vector<BurnPtr>& burns, double dt, double seconds, int32_t numPoints, Trajectory& trajectory)
+	{
+		trajectory.clear();
+
+		SimulatePoint(point, grid, burns, dt, seconds, numPoints, false, [&](const vec2d& position, double time)
+		{
+			trajectory.positions.push_back((vec2)position);
+			trajectory.times.push_back((float)time);
+		});
+	}
 }
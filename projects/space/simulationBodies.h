@@ -1,18 +1,23 @@
 #include <vector>
 #include <map>
+#include <array>
+#include <limits>
+#include <algorithm>
 #include "bodies.h"
+#include "orbit.h"
+#include "massPointGrid.h"
 
 
 template<class T>
 struct SimulationBodies
 {
-    SimulationBodies(std::vector<Bodies::Body>& bodies, std::set<size_t> indices)
-        : bodies(bodies), indices(indices)
+    SimulationBodies(std::vector<Bodies::Body>& bodies, std::set<size_t> indices, const Simulation::Settings& settings = {})
+        : bodies(bodies), indices(indices), settings(settings)
     {
     }
 
-    SimulationBodies(std::vector<Bodies::Body>& bodies)
-        : bodies(bodies), indices(indices)
+    SimulationBodies(std::vector<Bodies::Body>& bodies, const Simulation::Settings& settings = {})
+        : bodies(bodies), settings(settings)
     {
         for (size_t i = 0; i < bodies.size(); i++)
             indices.insert(i);
@@ -21,16 +26,152 @@ struct SimulationBodies
     std::vector<Bodies::Body>& bodies;
     // indices to bodies vector, should represent bodies included in simulation
     std::set<size_t> indices;
+    // how accelerations between bodies are computed and tolerances of adaptive integrators
+    Simulation::Settings settings;
 
+    // trajectory points on which eccentricities of parent candidates are compared
+    static constexpr size_t ParentSamples = 64;
+
+    // Bodies which are not included follow their stored trajectories, so they still attract
+    // simulated bodies.
     void SimulateClear(double time)
     {
         for (auto& index : indices)
             bodies[index].GetSimulation<T>().Clear();
 
+        auto ephemerides = CreateEphemerides();
+        auto previousSettings = settings;
+        if (!ephemerides.bodies.empty())
+            settings.ephemerides = &ephemerides;
+
         SimulateExtend(time, 0.0);
+
+        settings = previousSettings;
     }
 
-    void SimulateExtend(double time, double simulatedTime)
+    // Points are restored from the last checkpoint at or before time and simulated to endTime, stored
+    // trajectories after the checkpoint are replaced with the same number of points. Without checkpoint
+    // simulation starts from initial points. Bodies have no burns, burn indices of checkpoint are not used.
+    void SimulateFromCheckpoint(double time, double endTime)
+    {
+        auto snapshot = settings.checkpoints ? settings.checkpoints->Get<T>().Find(time) : std::nullopt;
+        if (!snapshot || snapshot->points.size() != indices.size())
+        {
+            SimulateClear(endTime);
+            return;
+        }
+
+        size_t removedPoints = 0;
+        size_t i = 0;
+        for (auto index : indices)
+        {
+            auto& simulation = bodies[index].GetSimulation<T>();
+            auto& trajectory = simulation.trajectoryGlobal;
+
+            size_t count = 0;
+            if (!trajectory.times.empty())
+            {
+                count = trajectory.getPoint(snapshot->time);
+                if (trajectory.times[count] <= (float)snapshot->time)
+                    count++;
+            }
+            removedPoints = std::max(removedPoints, trajectory.times.size() - count);
+
+            trajectory.truncate(count);
+            simulation.trajectoryParent.truncate(count);
+            simulation.currentPoint = std::move(snapshot->points[i++]);
+        }
+
+        const double remainingTime = endTime - snapshot->time;
+        int32_t numPoints = (int32_t)removedPoints + 1;
+        if (removedPoints == 0)
+            numPoints = std::max((int32_t)std::round(TestBodies::TrajectoryPointCount * remainingTime / endTime), 2);
+
+        SimulateExtend(remainingTime, snapshot->time, numPoints, snapshot->step);
+    }
+
+    Simulation::Ephemerides CreateEphemerides()
+    {
+        Simulation::Ephemerides result;
+        for (size_t i = 0; i < bodies.size(); i++)
+        {
+            auto& trajectory = bodies[i].GetSimulation<T>().trajectoryGlobal;
+            if (!indices.contains(i) && !trajectory.times.empty())
+                result.bodies.push_back({ &trajectory, bodies[i].mass });
+        }
+        return result;
+    }
+
+    // trajectory of body before resimulation and mass it was simulated with
+    struct Previous
+    {
+        Trajectory trajectory;
+        double mass = 0.0;
+    };
+
+    Previous GetPrevious(size_t body)
+    {
+        auto& simulation = bodies[body].GetSimulation<T>();
+        // editing initial state doesn't change current point, it keeps mass used by the simulation
+        return { simulation.trajectoryGlobal, simulation.trajectoryGlobal.times.empty() ? 0.0 : simulation.currentPoint.getMass() };
+    }
+
+    // First order estimate of how far would body move from its stored trajectory, if resimulated bodies
+    // attracted it from their new trajectories instead of the previous ones. Change of acceleration at
+    // trajectory points is integrated twice.
+    double EstimatePerturbation(size_t body, const std::map<size_t, Previous>& previous)
+    {
+        const Trajectory& trajectory = bodies[body].GetSimulation<T>().trajectoryGlobal;
+
+        auto attraction = [](const vec2d& from, const vec2d& to, double mass)
+        {
+            vec2d dir = to - from;
+            double distanceSqr = dir.dot();
+            if (distanceSqr == 0.0)
+                return vec2d{};
+            return (GravitationalConstant * mass / (distanceSqr * std::sqrt(distanceSqr))) * dir;
+        };
+
+        // trajectories are copied to contiguous arrays, the body is compared with every resimulated one
+        const size_t count = trajectory.times.size();
+        std::vector<float> times(count);
+        std::vector<vec2> positions(count), sourcePositions(count);
+        trajectory.times.CopyTo(0, count, times.data());
+        trajectory.positions.CopyTo(0, count, positions.data());
+
+        // change of acceleration at trajectory points, previous attraction is subtracted with negative mass
+        std::vector<vec2d> change(count);
+        auto accumulate = [&](const Trajectory& source, double mass)
+        {
+            const size_t sourceCount = std::min(count, source.positions.size());
+            source.positions.CopyTo(0, sourceCount, sourcePositions.data());
+            for (size_t i = 1; i < sourceCount; i++)
+                change[i] += attraction((vec2d)positions[i], (vec2d)sourcePositions[i], mass);
+        };
+
+        for (const auto& entry : previous)
+        {
+            const size_t index = entry.first;
+            accumulate(bodies[index].GetSimulation<T>().trajectoryGlobal, bodies[index].mass);
+            accumulate(entry.second.trajectory, -entry.second.mass);
+        }
+
+        vec2d velocity, displacement;
+        double result = 0.0;
+
+        for (size_t i = 1; i < count; i++)
+        {
+            const double dt = times[i] - times[i - 1];
+
+            velocity += change[i] * dt;
+            displacement += velocity * dt;
+            result = std::max(result, (double)displacement.length());
+        }
+
+        return result;
+    }
+
+    void SimulateExtend(double time, double simulatedTime, int32_t numPoints = TestBodies::TrajectoryPointCount, double dt = SimulationDt)
     {
         std::vector<std::vector<BurnPtr>> burns(indices.size());
         std::vector<T> points;
@@ -45,42 +186,55 @@ struct SimulationBodies
             resultIndices.push_back(index);
         }
 
-        auto newTrajectories = Simulation::Simulate(points, burns, SimulationDt, time, simulatedTime, TestBodies::TrajectoryPointCount);
+        auto newTrajectories = Simulation::Simulate(points, burns, dt, time, simulatedTime, numPoints, settings);
         for (size_t i = 0; i < newTrajectories.size(); i++)
         {
-            bodies[resultIndices[i]].GetSimulation<T>().currentPoint = std::move(points[i]);
-            bodies[resultIndices[i]].GetSimulation<T>().trajectoryGlobal.extend(std::move(newTrajectories[i]), 0);
-            bodies[resultIndices[i]].GetSimulation<T>().trajectoryParent.extend(std::move(newTrajectories[i]), 0);
+            auto& simulation = bodies[resultIndices[i]].GetSimulation<T>();
+            // first point of new trajectory is the current point, which is already the last point of extended one
+            const size_t fromIndex = simulation.trajectoryGlobal.times.empty() ? 0 : 1;
+
+            simulation.currentPoint = std::move(points[i]);
+            simulation.trajectoryGlobal.extend(std::move(newTrajectories[i]), fromIndex);
         }
     }
 
-    void ProcessTrajectoriesParentRecursive(size_t body)
+    // Parent relative trajectory is global trajectory minus parent relative trajectory of parent (global
+    // trajectory without parent). Points are kept while parent is the same, so only points from fromIndex
+    // and points appended to global trajectory are computed, children are updated from the first changed point.
+    void ProcessTrajectoriesParentRecursive(size_t body, size_t fromIndex = std::numeric_limits<size_t>::max())
     {
         auto& simulation = bodies[body].GetSimulation<T>();
         auto& trajectoryGlobal = simulation.trajectoryGlobal;
         auto& trajectoryParent = simulation.trajectoryParent;
 
-        if (bodies[body].parent)
+        if (simulation.trajectoryParentBody != bodies[body].parent)
+        {
+            simulation.trajectoryParentBody = bodies[body].parent;
+            fromIndex = 0;
+        }
+        fromIndex = std::min({ fromIndex, trajectoryParent.positions.size(), trajectoryGlobal.positions.size() });
+        trajectoryParent.truncate(fromIndex);
+
+        for (size_t i = fromIndex; i < trajectoryGlobal.positions.size(); i++)
         {
-            auto& trajectoryOfParent = bodies[*bodies[body].parent].GetSimulation<T>().trajectoryParent;
-            trajectoryParent.clear();
-            for (size_t i = 0; i < simulation.trajectoryGlobal.positions.size(); i++)
+            if (bodies[body].parent)
             {
+                auto& trajectoryOfParent = bodies[*bodies[body].parent].GetSimulation<T>().trajectoryParent;
                 trajectoryParent.positions.push_back(trajectoryGlobal.positions[i] - trajectoryOfParent.positions[i]);
                 trajectoryParent.velocities.push_back(trajectoryGlobal.velocities[i] - trajectoryOfParent.velocities[i]);
             }
-        }
-        else
-        {
-            trajectoryParent = trajectoryGlobal;
+            else
+            {
+                trajectoryParent.positions.push_back(trajectoryGlobal.positions[i]);
+                trajectoryParent.velocities.push_back(trajectoryGlobal.velocities[i]);
+            }
+            trajectoryParent.times.push_back(trajectoryGlobal.times[i]);
         }
 
-        simulation.trajectoryParent.times = trajectoryGlobal.times;
-
         for (size_t child : bodies[body].childs)
         {
             if (indices.contains(child))
-                ProcessTrajectoriesParentRecursive(child);
+                ProcessTrajectoriesParentRecursive(child, fromIndex);
         }
     }
 
@@ -93,75 +247,208 @@ struct SimulationBodies
         }
     }
 
+    // Cost is given by the number of points changed since the last call (appended or replaced
+    // after truncation of global trajectories) and by subtrees of bodies with changed parent.
     void ProcessTrajectoriesParent()
     {
-        for (size_t i = 0; i < bodies.size(); i++)
+        // from the top of each subtree of indices, parent outside of indices is already processed
+        for (auto index : indices)
         {
-            if (bodies[i].parent)
-                continue;
-            // from the root
-            if (indices.contains(i))
-                bodies[i].GetSimulation<T>().trajectoryParent = bodies[i].GetSimulation<T>().trajectoryGlobal;
-
-            for (auto child : bodies[i].childs)
-            {
-                if (indices.contains(child))
-                    ProcessTrajectoriesParentRecursive(child);
-            }
+            if (!bodies[index].parent || !indices.contains(*bodies[index].parent))
+                ProcessTrajectoriesParentRecursive(index);
         }
     }
 
-    std::vector<double> GetEccentricities(Bodies::Body& a, Bodies::Body& b)
+    // eccentricity of orbit of a around b at trajectory point i
+    double GetEccentricity(Bodies::Body& a, Bodies::Body& b, size_t i)
     {
         Trajectory& traja = a.GetSimulation<T>().trajectoryGlobal;
         Trajectory& trajb = b.GetSimulation<T>().trajectoryGlobal;
 
-        const size_t n = traja.positions.size();
         double ma = a.mass, mb = b.mass;
         double rm = (ma * mb) / (ma + mb);
 
         double G = GravitationalConstant;
 
-        std::vector<double> E(n);
-        for (size_t i = 0; i < n; ++i)
-        {
-            vec2d velocity = (vec2d)traja.velocities[i] - (vec2d)trajb.velocities[i];
+        vec2d velocity = (vec2d)traja.velocities[i] - (vec2d)trajb.velocities[i];
+
+        double v = velocity.length();
+        // y of velocity rotated by its angle, v * sin(2 * angle) without trigonometric functions
+        double vt = v > 0.0 ? 2.0 * velocity.x() * velocity.y() / v : 0.0;
+        double r = (traja.positions[i] - trajb.positions[i]).length();
+        double energy = 0.5 * rm * v * v - (G * ma * mb) / r;
 
-            double v = velocity.length();
-            double vt = Utils::RotateVector(velocity, Utils::GetAngle(velocity)).y();
-            double r = (traja.positions[i] - trajb.positions[i]).length();
-            double energy = 0.5 * rm * v * v - (G * ma * mb) / r;
+        double angularMomentum = rm * r * vt; // use tangential part of velocity
+        //double semilatusRectum = pow(angularMomentum, 2) / (rm * G * ma * mb);
+        return sqrt(1 + (2.0 * energy * angularMomentum * angularMomentum) / (rm * (G * ma * mb) * (G * ma * mb)));
+    }
 
-            double angularMomentum = rm * r * vt; // use tangential part of velocity
-            //double semilatusRectum = pow(angularMomentum, 2) / (rm * G * ma * mb);
-            double eccentricity = sqrt(1 + (2.0 * energy * pow(angularMomentum, 2)) / (rm * pow(G * ma * mb, 2)));
+    // mean deviation of eccentricity of orbit of a around b, evaluated on at most
+    // ParentSamples trajectory points (including the first and the last one)
+    double GetEccentricityDeviation(Bodies::Body& a, Bodies::Body& b)
+    {
+        const size_t n = a.GetSimulation<T>().trajectoryGlobal.positions.size();
+        const size_t count = std::min(n, ParentSamples);
 
-            E[i] = eccentricity;
+        std::array<double, ParentSamples> eccentricities;
+        double mean = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            eccentricities[i] = GetEccentricity(a, b, count > 1 ? i * (n - 1) / (count - 1) : 0);
+            mean += eccentricities[i];
         }
+        mean /= (double)count;
 
-        return E;
+        double accumulatedMeanDistances = 0.0;
+        for (size_t i = 0; i < count; i++)
+            accumulatedMeanDistances += fabs(eccentricities[i] - mean);
+
+        return accumulatedMeanDistances / (double)count;
     }
 
-    std::map<size_t, std::optional<size_t>> ComputeParents()
+    // Parent of each simulated body is the body with the most stable eccentricity of relative orbit.
+    // Candidates are stars, the heaviest body and bodies whose Hill sphere (with margin) contains
+    // the child at any of the trajectory points where eccentricity is sampled. Hill spheres are relative
+    // to the heaviest body at the largest distance from it, which is larger than relative to the real
+    // parent of moon's parent. Without pruning all heavier bodies are candidates.
+    std::map<size_t, std::optional<size_t>> ComputeParents(bool prune = true)
     {
         std::map<size_t, std::optional<size_t>> result;
 
         // constant of allowed deviation of eccentricity for elliptical orbit
         static const double PeriodicOrbitFocusSigma = 1.0;
+        // multiple of Hill sphere radius in which parent is searched
+        static const double HillSphereMargin = 3.0;
+
+        auto getTrajectory = [this](size_t index) -> Trajectory& { return bodies[index].GetSimulation<T>().trajectoryGlobal; };
+
+        // positions at trajectory points where eccentricity is sampled (see GetEccentricityDeviation),
+        // sample i of body is samples[body * ParentSamples + i]
+        std::vector<vec2d> samples;
+        std::vector<size_t> sampleCounts(bodies.size(), 0);
+        // the largest distance of sample from the first one
+        std::vector<double> sweeps(bodies.size(), 0.0);
+        if (prune)
+        {
+            samples.resize(bodies.size() * ParentSamples);
+            for (size_t i = 0; i < bodies.size(); i++)
+            {
+                const auto& positions = getTrajectory(i).positions;
+                const size_t n = positions.size();
+                const size_t count = std::min(n, ParentSamples);
+                vec2d* points = samples.data() + i * ParentSamples;
+                for (size_t sample = 0; sample < count; sample++)
+                {
+                    points[sample] = (vec2d)positions[count > 1 ? sample * (n - 1) / (count - 1) : 0];
+                    sweeps[i] = std::max(sweeps[i], (points[sample] - points[0]).length());
+                }
+                sampleCounts[i] = count;
+            }
+        }
+
+        std::optional<size_t> heaviest;
+        for (size_t i = 0; i < bodies.size(); i++)
+        {
+            if (!getTrajectory(i).positions.empty() && (!heaviest || bodies[i].mass > bodies[*heaviest].mass))
+                heaviest = i;
+        }
+
+        std::vector<size_t> roots;
+        std::vector<size_t> others;
+        std::vector<double> radii(bodies.size(), 0.0);
+        for (size_t i = 0; i < bodies.size(); i++)
+        {
+            if (i == heaviest || bodies[i].isStar || !prune)
+            {
+                roots.push_back(i);
+                continue;
+            }
+            if (getTrajectory(i).positions.empty())
+                continue;
+
+            double distance = 0.0;
+            for (size_t sample = 0; sample < std::min(sampleCounts[i], sampleCounts[*heaviest]); sample++)
+                distance = std::max(distance, (samples[i * ParentSamples + sample] - samples[*heaviest * ParentSamples + sample]).length());
+            radii[i] = HillSphereMargin * distance * std::cbrt(bodies[i].mass / (3.0 * bodies[*heaviest].mass));
+            others.push_back(i);
+        }
+
+        auto sphereContains = [&](size_t parent, size_t child)
+        {
+            const vec2d* a = samples.data() + parent * ParentSamples;
+            const vec2d* b = samples.data() + child * ParentSamples;
+            for (size_t sample = 0; sample < std::min(sampleCounts[parent], sampleCounts[child]); sample++)
+            {
+                if ((a[sample] - b[sample]).dot() <= radii[parent] * radii[parent])
+                    return true;
+            }
+            return false;
+        };
+
+        // Sphere can contain the child at some sample only when their first samples are closer than
+        // radius of sphere and sweeps of both bodies. Children are grouped by sweep (bound of each group
+        // is half of the previous one), spheres enlarged by the bound are found in grid and each found
+        // one is checked at all samples.
+        static const int32_t SweepGroups = 8;
+        std::array<std::vector<size_t>, SweepGroups> groups;
+        double maxSweep = 0.0;
+        for (auto child : indices)
+            maxSweep = std::max(maxSweep, sweeps[child]);
+        for (auto child : indices)
+        {
+            if (sampleCounts[child] == 0 || others.empty())
+                continue;
+            const double group = sweeps[child] > 0.0 ? std::floor(std::log2(maxSweep / sweeps[child])) : SweepGroups;
+            groups[(size_t)std::clamp(group, 0.0, (double)SweepGroups - 1)].push_back(child);
+        }
+
+        // bodies other than roots whose spheres contain the child at any sample
+        std::vector<std::vector<size_t>> candidates(bodies.size());
+        MassPointGrid grid;
+        for (int32_t group = 0; group < SweepGroups; group++)
+        {
+            if (groups[group].empty())
+                continue;
+
+            const double bound = std::ldexp(maxSweep, -group);
+            std::vector<MassPointGrid::Source> spheres;
+            for (size_t i : others)
+            {
+                const double radius = radii[i] + sweeps[i] + bound;
+                spheres.push_back({ samples[i * ParentSamples], GravitationalConstant * bodies[i].mass, radius * radius, (uint32_t)i });
+            }
+            grid.Build(std::move(spheres));
+
+            for (size_t child : groups[group])
+            {
+                grid.Query(samples[child * ParentSamples], [&](const MassPointGrid::Source& source, double)
+                {
+                    if (source.index != child && sphereContains(source.index, child))
+                        candidates[child].push_back(source.index);
+                });
+            }
+        }
 
         for (auto child : indices)
         {
             using EccentricityParents = std::pair<double, size_t>;
             std::vector<EccentricityParents> values;
 
-            for (auto parent : indices)
+            // parent may be also body which was not simulated now, its stored trajectory has the same points
+            auto addCandidate = [&](size_t parent)
             {
                 if (parent == child || bodies[parent].mass < bodies[child].mass)
-                    continue;
+                    return;
+                if (getTrajectory(parent).times.size() != getTrajectory(child).times.size())
+                    return;
 
-                double value = Utils::GetMeanDeviation(GetEccentricities(bodies[child], bodies[parent]));
-                values.push_back({ value, parent });
-            }
+                values.push_back({ GetEccentricityDeviation(bodies[child], bodies[parent]), parent });
+            };
+
+            for (size_t root : roots)
+                addCandidate(root);
+            for (size_t parent : candidates[child])
+                addCandidate(parent);
 
             bool parentSet = false;
 
@@ -221,6 +508,19 @@ struct SimulationBodies
         return result;
     }
 
+    // conic with focus at parent, open conics are drawn up to few times the current distance
+    Bodies::Body::Conic CreateConicFromOrbit(const Orbit::Elements& elements, double distance)
+    {
+        static const double OpenConicDistanceScale = 10.0;
+
+        Bodies::Body::Conic result;
+        result.points = Utils::ConvertToFloat(Orbit::GeneratePoints(elements, OpenConicDistanceScale * distance));
+        result.position = { 0.0f, 0.0f };
+        result.rotation = 0.0f;
+
+        return result;
+    }
+
     void ComputeConic(Bodies::Body& body)
     {
         // TODO
@@ -238,8 +538,8 @@ struct SimulationBodies
             auto initialPositionParentRelative = body.initialPosition - bodies[*body.parent].initialPosition;
             auto initialVelocityParentRelative = body.initialVelocity - bodies[*body.parent].initialVelocity;
 
-            auto computedConic = ConicApproximation::ComputeConic(bodies[*body.parent].mass, body.mass, initialPositionParentRelative, initialVelocityParentRelative);
-            body.conicComputedFromParent = CreateConicFromApproximation(computedConic);
+            auto elements = Orbit::FromState(GravitationalConstant * (bodies[*body.parent].mass + body.mass), initialPositionParentRelative, initialVelocityParentRelative);
+            body.conicComputedFromParent = CreateConicFromOrbit(elements, initialPositionParentRelative.length());
         }
     }
 
@@ -259,23 +559,4 @@ struct SimulationBodies
         for (auto index : indices)
             ComputeConic(bodies[index]);
     }
-
-    std::vector<vec2d> ComputeInitialAccelerationsToBody(size_t body)
-    {
-        std::vector<vec2d> result;
-
-        for (auto index : indices)
-        {
-            if (index == body)
-            {
-                result.push_back({ 0.0, 0.0 });
-                continue;
-            }
-
-            auto acc = bodies[body].GetSimulation<T>().initialPoint.attractForce(bodies[index].GetSimulation<T>().initialPoint.position, bodies[index].mass) / bodies[body].mass;
-            result.push_back(acc);
-        }
-
-        return result;
-    }
 };
@@ -0,0 +1,163 @@
+#include "simulationWorker.h"
+#include <algorithm>
+#include <chrono>
+
+SimulationWorker::SimulationWorker()
+{
+	thread = std::thread(&SimulationWorker::WorkerLoop, this);
+}
+
+SimulationWorker::~SimulationWorker()
+{
+	Cancel();
+	{
+		std::lock_guard lock(mutex);
+		quit = true;
+	}
+	condition.notify_one();
+
+	thread.join();
+}
+
+void SimulationWorker::Start(Job&& job)
+{
+	{
+		std::lock_guard lock(mutex);
+		nextJob = std::move(job);
+		nextJobId = ++jobId;
+	}
+	condition.notify_one();
+}
+
+void SimulationWorker::Cancel()
+{
+	std::lock_guard lock(mutex);
+	nextJob.reset();
+	jobId++;
+}
+
+bool SimulationWorker::TryTake(Piece& piece)
+{
+	if (!slotFull.load(std::memory_order_acquire))
+		return false;
+
+	const bool current = !IsCancelled(slotJobId);
+	if (current)
+		piece = std::move(slot);
+	slot = {};
+
+	slotFull.store(false, std::memory_order_release);
+
+	return current;
+}
+
+bool SimulationWorker::TryPublish(Piece& piece, uint64_t id)
+{
+	if (slotFull.load(std::memory_order_acquire))
+		return false;
+
+	slot = std::move(piece);
+	slotJobId = id;
+
+	slotFull.store(true, std::memory_order_release);
+
+	return true;
+}
+
+void SimulationWorker::WorkerLoop()
+{
+	while (true)
+	{
+		Job job;
+		uint64_t id = 0;
+		{
+			std::unique_lock lock(mutex);
+			condition.wait(lock, [this] { return quit || nextJob; });
+			if (quit)
+				return;
+
+			job = std::move(*nextJob);
+			nextJob.reset();
+			id = nextJobId;
+		}
+
+		Run(job, id);
+	}
+}
+
+void SimulationWorker::Run(Job& job, uint64_t id)
+{
+	// steps are split evenly between trajectory points, each piece ends at trajectory point
+	const int64_t steps = std::max<int64_t>((int64_t)std::ceil(job.seconds / job.dt), 1);
+	const int64_t samples = std::max(job.numPoints - 1, 1);
+	const int64_t samplesPerPiece = std::clamp<int64_t>(PieceSteps * samples / steps, 1, MaxPendingPoints / 2);
+
+	auto createPiece = [&job](bool first)
+	{
+		Piece piece;
+		piece.first = first;
+		ForEachIntegrator(piece.integrators, [&job](auto& integrator) { integrator.trajectories.resize(std::get<0>(job.integrators).points.size()); });
+		return piece;
+	};
+
+	Piece pending = createPiece(true);
+	int64_t pendingSamples = 0;
+
+	const std::vector<std::vector<BurnPtr>> burns(std::get<0>(job.integrators).points.size());
+
+	int64_t samplesDone = 0, stepsDone = 0;
+	while (samplesDone < samples)
+	{
+		const int64_t count = std::min(samplesPerPiece, samples - samplesDone);
+		const int64_t stepsEnd = steps * (samplesDone + count) / samples;
+		const double seconds = (double)(stepsEnd - stepsDone) * job.dt;
+		const double timeOffset = job.timeOffset + (double)stepsDone * job.dt;
+
+		// pieces of job and of pending are the same integrators in the same order
+		auto simulate = [&](auto& integrator, auto& result)
+		{
+			auto trajectories = Simulation::Simulate(integrator.points, burns, job.dt, seconds, timeOffset, (int32_t)count + 1, job.settings);
+			for (size_t i = 0; i < trajectories.size(); i++)
+			{
+				// first point is the last point of previous piece
+				const size_t fromIndex = pending.first && result.trajectories[i].times.empty() ? 0 : 1;
+				result.trajectories[i].extend(std::move(trajectories[i]), fromIndex);
+			}
+			result.points = integrator.points;
+		};
+		std::apply([&](auto&... integrator)
+		{
+			std::apply([&](auto&... result) { (simulate(integrator, result), ...); }, pending.integrators);
+		}, job.integrators);
+
+		if (IsCancelled(id))
+			return;
+
+		samplesDone += count;
+		stepsDone = stepsEnd;
+		pendingSamples += count;
+
+		pending.finished = samplesDone == samples;
+		pending.simulatedTime = pending.finished ? job.timeOffset + job.seconds : timeOffset + seconds;
+
+		if (TryPublish(pending, id))
+		{
+			pending = createPiece(false);
+			pendingSamples = 0;
+			continue;
+		}
+
+		// main thread is behind, last piece and full buffer have to wait for it
+		if (pending.finished || pendingSamples + samplesPerPiece > MaxPendingPoints)
+		{
+			while (!TryPublish(pending, id))
+			{
+				if (IsCancelled(id))
+					return;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			pending = createPiece(false);
+			pendingSamples = 0;
+		}
+	}
+}
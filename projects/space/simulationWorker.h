@@ -0,0 +1,97 @@
+#pragma once
+#include "simulation.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+// Extends trajectories of all integrators on background thread. Simulation is split into pieces of
+// few trajectory points, which are handed over to the main thread through single slot. While the slot
+// is taken, worker keeps collecting points in its own buffer (double buffering). Handing over doesn't
+// lock, main thread only polls the slot once per frame.
+// Worker doesn't touch bodies, it gets copies of current points.
+struct SimulationWorker
+{
+	// current points and new trajectory points of one integrator, indexed as bodies
+	template<class T>
+	struct Integrator
+	{
+		using Point = T;
+
+		std::vector<T> points;
+		std::vector<Trajectory> trajectories;
+	};
+	using Integrators = std::tuple<Integrator<PointEuler>, Integrator<PointVerlet>, Integrator<PointRungeKutta>, Integrator<PointDormandPrince>, Integrator<PointLeapfrog>>;
+
+	template<class Func>
+	static void ForEachIntegrator(Integrators& integrators, Func&& func)
+	{
+		std::apply([&](auto&... integrator) { (func(integrator), ...); }, integrators);
+	}
+
+	struct Job
+	{
+		// points of bodies at the end of stored trajectories
+		Integrators integrators;
+		// statistics and ephemerides are not used
+		Simulation::Settings settings;
+		double dt = 0.0;
+		double seconds = 0.0;
+		double timeOffset = 0.0;
+		int32_t numPoints = 0;
+	};
+
+	// trajectory points simulated since previous piece and points at the end of them
+	struct Piece
+	{
+		Integrators integrators;
+		// end of simulated time
+		double simulatedTime = 0.0;
+		// trajectories start with the current point of job, it is already stored unless trajectory is empty
+		bool first = false;
+		// last piece of job
+		bool finished = false;
+	};
+
+	SimulationWorker();
+	~SimulationWorker();
+
+	SimulationWorker(const SimulationWorker&) = delete;
+	SimulationWorker& operator=(const SimulationWorker&) = delete;
+
+	// running job is cancelled
+	void Start(Job&& job);
+	// pieces of cancelled job are never returned, worker stops at the end of current piece
+	void Cancel();
+
+	// returns false if no new piece of current job was published
+	bool TryTake(Piece& piece);
+
+private:
+	void WorkerLoop();
+	void Run(Job& job, uint64_t id);
+	bool TryPublish(Piece& piece, uint64_t id);
+	bool IsCancelled(uint64_t id) const { return id != jobId; }
+
+	// simulation steps of one piece, so the cancellation is quick
+	static const int64_t PieceSteps = 256;
+	// points waiting for the main thread, it stays below chunk size, so worker never seals (and spills) chunks
+	static const int32_t MaxPendingPoints = 1024;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::optional<Job> nextJob;
+	uint64_t nextJobId = 0;
+	bool quit = false;
+
+	std::atomic<uint64_t> jobId = 0;
+
+	// published piece belongs to the main thread while slotFull is set
+	Piece slot;
+	uint64_t slotJobId = 0;
+	std::atomic<bool> slotFull = false;
+};
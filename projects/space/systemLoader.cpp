@@ -0,0 +1,449 @@
+#include "systemLoader.h"
+#include "utils.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+extern double GravitationalConstant;
+extern double SimulationDt;
+
+namespace SystemLoader
+{
+	void SetupSolarSystemUnits()
+	{
+		Unit::SetBaseMeter((1.0 / 1.5e8) * 1e-3);
+		Unit::SetBaseKilogram(1.0 / 2e30);
+		Unit::SetBaseSecond(1e-7 / Utils::Pi);
+
+		GravitationalConstant = 4.0 * Utils::Pi * Utils::Pi;
+		SimulationDt = Unit::Hour;
+	}
+
+	// order of nlohmann::json objects, sorted by name and the last of duplicate names is kept
+	static void SortEntries(std::vector<Entry>& entries)
+	{
+		std::stable_sort(std::begin(entries), std::end(entries), [](const Entry& a, const Entry& b) { return a.name < b.name; });
+
+		size_t count = 0;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			if (i + 1 < entries.size() && entries[i + 1].name == entries[i].name)
+				continue;
+			if (count != i)
+				entries[count] = std::move(entries[i]);
+			count++;
+		}
+		entries.resize(count);
+	}
+
+	std::vector<Entry> GetEntries(const nlohmann::json& data)
+	{
+		std::vector<Entry> result;
+		result.reserve(data.size());
+
+		for (auto& [name, body] : data.items())
+		{
+			Entry entry;
+			entry.name = name;
+			entry.position = { (double)body["position"]["x"], (double)body["position"]["y"] };
+			entry.velocity = { (double)body["velocity"]["x"], (double)body["velocity"]["y"] };
+			entry.mass = (double)body["mass"];
+			entry.star = body.contains("star");
+			result.push_back(std::move(entry));
+		}
+
+		return result;
+	}
+
+	// Single pass over json text reading only the schema of system, other fields are skipped. Json is
+	// validated as far as it is read, numbers are parsed by std::from_chars.
+	class EntriesReader
+	{
+	public:
+		explicit EntriesReader(std::string_view text) : text(text) {}
+
+		std::vector<Entry> Read()
+		{
+			std::vector<Entry> result;
+
+			Expect('{');
+			if (!Consume('}'))
+			{
+				do
+				{
+					Entry& entry = result.emplace_back();
+					entry.name = ReadString();
+					Expect(':');
+					ReadBody(entry);
+				} while (Consume(','));
+				Expect('}');
+			}
+
+			SkipWhitespace();
+			if (offset != text.size())
+				Fail("unexpected data after system");
+
+			return result;
+		}
+
+	private:
+		std::string_view text;
+		size_t offset = 0;
+
+		[[noreturn]] void Fail(const char* message) const
+		{
+			throw std::runtime_error(std::string(message) + " at offset " + std::to_string(offset));
+		}
+
+		void SkipWhitespace()
+		{
+			while (offset < text.size() && (text[offset] == ' ' || text[offset] == '\t' || text[offset] == '\n' || text[offset] == '\r'))
+				offset++;
+		}
+
+		char Peek()
+		{
+			SkipWhitespace();
+			if (offset == text.size())
+				Fail("unexpected end of json");
+			return text[offset];
+		}
+
+		bool Consume(char c)
+		{
+			if (Peek() != c)
+				return false;
+			offset++;
+			return true;
+		}
+
+		void Expect(char c)
+		{
+			if (!Consume(c))
+				Fail((std::string("expected ") + c).c_str());
+		}
+
+		uint32_t ReadHex()
+		{
+			uint32_t result = 0;
+			if (text.size() - offset < 4 || std::from_chars(text.data() + offset, text.data() + offset + 4, result, 16).ptr != text.data() + offset + 4)
+				Fail("invalid escape");
+			offset += 4;
+			return result;
+		}
+
+		std::string ReadString()
+		{
+			Expect('"');
+
+			std::string result;
+			while (true)
+			{
+				const size_t end = text.find_first_of("\"\\", offset);
+				if (end == std::string_view::npos)
+					Fail("unterminated string");
+				result.append(text.data() + offset, end - offset);
+				offset = end + 1;
+				if (text[end] == '"')
+					return result;
+
+				if (offset == text.size())
+					Fail("unterminated string");
+				const char escape = text[offset++];
+				switch (escape)
+				{
+				case '"': case '\\': case '/': result += escape; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'n': result += '\n'; break;
+				case 'r': result += '\r'; break;
+				case 't': result += '\t'; break;
+				case 'u':
+				{
+					// utf-16, surrogate pair is one code point
+					uint32_t code = ReadHex();
+					if (code >= 0xD800 && code < 0xDC00 && text.substr(offset, 2) == "\\u")
+					{
+						offset += 2;
+						code = 0x10000 + ((code - 0xD800) << 10) + (ReadHex() - 0xDC00);
+					}
+					if (code < 0x80)
+						result += (char)code;
+					else if (code < 0x800)
+						result += { (char)(0xC0 | (code >> 6)), (char)(0x80 | (code & 0x3F)) };
+					else if (code < 0x10000)
+						result += { (char)(0xE0 | (code >> 12)), (char)(0x80 | ((code >> 6) & 0x3F)), (char)(0x80 | (code & 0x3F)) };
+					else
+						result += { (char)(0xF0 | (code >> 18)), (char)(0x80 | ((code >> 12) & 0x3F)), (char)(0x80 | ((code >> 6) & 0x3F)), (char)(0x80 | (code & 0x3F)) };
+					break;
+				}
+				default:
+					Fail("invalid escape");
+				}
+			}
+		}
+
+		double ReadNumber()
+		{
+			// from_chars accepts also inf and nan, json number starts with digit after optional minus
+			const size_t digit = Peek() == '-' ? offset + 1 : offset;
+			if (digit >= text.size() || text[digit] < '0' || text[digit] > '9')
+				Fail("expected number");
+
+			double result = 0.0;
+			auto [end, error] = std::from_chars(text.data() + offset, text.data() + text.size(), result);
+			if (error != std::errc() || !std::isfinite(result))
+				Fail("invalid number");
+			offset = end - text.data();
+			return result;
+		}
+
+		void SkipValue()
+		{
+			const char c = Peek();
+			if (c == '"')
+			{
+				ReadString();
+			}
+			else if (c == '{' || c == '[')
+			{
+				const char close = c == '{' ? '}' : ']';
+				offset++;
+				if (Consume(close))
+					return;
+				do
+				{
+					if (c == '{')
+					{
+						ReadString();
+						Expect(':');
+					}
+					SkipValue();
+				} while (Consume(','));
+				Expect(close);
+			}
+			else if (c == '-' || (c >= '0' && c <= '9'))
+			{
+				ReadNumber();
+			}
+			else
+			{
+				for (std::string_view literal : { "true", "false", "null" })
+				{
+					if (text.substr(offset, literal.size()) == literal)
+					{
+						offset += literal.size();
+						return;
+					}
+				}
+				Fail("invalid value");
+			}
+		}
+
+		// calls read(key) for each key of object, read has to read the value
+		template<class F>
+		void ReadObject(F&& read)
+		{
+			Expect('{');
+			if (Consume('}'))
+				return;
+			do
+			{
+				const std::string key = ReadString();
+				Expect(':');
+				read(key);
+			} while (Consume(','));
+			Expect('}');
+		}
+
+		// returns bits of read components
+		uint32_t ReadVector(vec2d& vector)
+		{
+			uint32_t result = 0;
+			ReadObject([&](const std::string& key)
+			{
+				if (key == "x" || key == "y")
+				{
+					const int32_t component = key == "x" ? 0 : 1;
+					vector[component] = ReadNumber();
+					result |= 1 << component;
+				}
+				else
+				{
+					SkipValue();
+				}
+			});
+			return result;
+		}
+
+		void ReadBody(Entry& entry)
+		{
+			// bits of mass and components of position and velocity
+			uint32_t fields = 0;
+			ReadObject([&](const std::string& key)
+			{
+				if (key == "position")
+				{
+					fields |= ReadVector(entry.position) << 1;
+				}
+				else if (key == "velocity")
+				{
+					fields |= ReadVector(entry.velocity) << 3;
+				}
+				else if (key == "mass")
+				{
+					entry.mass = ReadNumber();
+					fields |= 1;
+				}
+				else
+				{
+					entry.star = entry.star || key == "star";
+					SkipValue();
+				}
+			});
+
+			if (fields != 0b11111)
+				throw std::runtime_error("body " + entry.name + " is missing position, velocity or mass");
+		}
+	};
+
+	std::vector<Entry> ParseEntries(std::string_view text)
+	{
+		auto result = EntriesReader(text).Read();
+		SortEntries(result);
+
+		return result;
+	}
+
+	struct CatalogHeader
+	{
+		char magic[4] = { 'S', 'P', 'S', 'C' };
+		uint32_t version = 1;
+		uint64_t count = 0;
+		// bytes of names, each ends with zero
+		uint64_t namesSize = 0;
+		uint64_t reserved[5] = {};
+	};
+	static_assert(sizeof(CatalogHeader) == 64, "records start aligned to cache line");
+
+	struct CatalogRecord
+	{
+		double position[2];
+		double velocity[2];
+		double mass;
+		// offset of name in names
+		uint32_t name;
+		uint32_t star;
+	};
+
+	void WriteCatalog(const std::filesystem::path& path, std::span<const Entry> entries)
+	{
+		CatalogHeader header;
+		header.count = entries.size();
+
+		std::vector<CatalogRecord> records;
+		records.reserve(entries.size());
+		std::string names;
+		for (const auto& entry : entries)
+		{
+			records.push_back({ { entry.position.x(), entry.position.y() }, { entry.velocity.x(), entry.velocity.y() }, entry.mass, (uint32_t)names.size(), entry.star });
+			names.append(entry.name.c_str(), entry.name.size() + 1);
+		}
+		header.namesSize = names.size();
+		if (names.size() > UINT32_MAX)
+			throw std::runtime_error("Names of bodies are too long for catalog");
+
+		std::ofstream stream(path, std::ios::binary);
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(CatalogRecord));
+		stream.write(names.data(), names.size());
+
+		if (!stream)
+			throw std::runtime_error("Cannot write " + path.string());
+	}
+
+	static bool IsCatalog(const CatalogHeader& header)
+	{
+		CatalogHeader expected;
+		return std::memcmp(header.magic, expected.magic, sizeof(expected.magic)) == 0 && header.version == expected.version;
+	}
+
+	std::vector<Entry> ReadCatalog(const std::filesystem::path& path)
+	{
+		std::ifstream stream(path, std::ios::binary);
+		if (!stream)
+			throw std::runtime_error("Cannot open " + path.string());
+
+		CatalogHeader header;
+		stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+		const uint64_t size = std::filesystem::file_size(path);
+		if (!stream || !IsCatalog(header) || header.count > size / sizeof(CatalogRecord) ||
+			sizeof(CatalogHeader) + header.count * sizeof(CatalogRecord) + header.namesSize != size)
+			throw std::runtime_error(path.string() + " is not catalog of bodies");
+
+		std::vector<CatalogRecord> records((size_t)header.count);
+		std::string names((size_t)header.namesSize, '\0');
+		stream.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(CatalogRecord));
+		stream.read(names.data(), names.size());
+		if (!stream || (!names.empty() && names.back() != '\0'))
+			throw std::runtime_error(path.string() + " is not catalog of bodies");
+
+		std::vector<Entry> result(records.size());
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			const CatalogRecord& record = records[i];
+			if (record.name >= names.size())
+				throw std::runtime_error(path.string() + " is not catalog of bodies");
+
+			Entry& entry = result[i];
+			entry.name = names.c_str() + record.name;
+			entry.position = { record.position[0], record.position[1] };
+			entry.velocity = { record.velocity[0], record.velocity[1] };
+			entry.mass = record.mass;
+			entry.star = record.star != 0;
+		}
+
+		return result;
+	}
+
+	std::vector<Entry> Read(const std::filesystem::path& path)
+	{
+		std::ifstream stream(path, std::ios::binary);
+		if (!stream)
+			throw std::runtime_error("Cannot open " + path.string());
+
+		CatalogHeader header;
+		stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (stream && IsCatalog(header))
+			return ReadCatalog(path);
+
+		std::string text((size_t)std::filesystem::file_size(path), '\0');
+		stream.clear();
+		stream.seekg(0);
+		stream.read(text.data(), text.size());
+
+		return ParseEntries(text);
+	}
+
+	std::vector<size_t> Load(Bodies& bodies, std::span<const Entry> entries)
+	{
+		std::vector<Bodies::BodyDesc> descs;
+		descs.reserve(entries.size());
+		for (const auto& entry : entries)
+			descs.push_back({ entry.name, entry.position * Unit::Meter, entry.velocity * Unit::Meter / Unit::Second, entry.mass * Unit::Kilogram, entry.star });
+
+		std::vector<size_t> result(entries.size());
+		std::iota(std::begin(result), std::end(result), bodies.AddBodies(descs));
+
+		return result;
+	}
+
+	std::vector<size_t> Load(Bodies& bodies, const nlohmann::json& data)
+	{
+		return Load(bodies, GetEntries(data));
+	}
+}
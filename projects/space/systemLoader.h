@@ -0,0 +1,42 @@
+#pragma once
+#include "bodies.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+// Systems of bodies stored as json (assets/systems) or as binary catalog converted from json (see
+// space-catalog tool), shared by the application and command line tools. Json of system is
+// { "name": { "position": { "x", "y" }, "velocity": { "x", "y" }, "mass", "star" } } with values in SI units.
+namespace SystemLoader
+{
+	// body of system in SI units
+	struct Entry
+	{
+		std::string name;
+		vec2d position;
+		vec2d velocity;
+		double mass = 0.0;
+		bool star = false;
+	};
+
+	// base units where AU, year and solar mass are close to 1, sets also gravitational constant and dt
+	void SetupSolarSystemUnits();
+
+	// Bodies of json document, in order of its objects (sorted by name).
+	std::vector<Entry> GetEntries(const nlohmann::json& data);
+	// Single pass over json text without building document, the result is the same as
+	// GetEntries(nlohmann::json::parse(text)). Throws std::runtime_error when text isn't system.
+	std::vector<Entry> ParseEntries(std::string_view text);
+
+	// Catalog is header, fixed size records and names, it's read without parsing. Both throw
+	// std::runtime_error on failure.
+	void WriteCatalog(const std::filesystem::path& path, std::span<const Entry> entries);
+	std::vector<Entry> ReadCatalog(const std::filesystem::path& path);
+	// catalog or json, recognized by content
+	std::vector<Entry> Read(const std::filesystem::path& path);
+
+	// Adds bodies, returns indices of added bodies.
+	std::vector<size_t> Load(Bodies& bodies, std::span<const Entry> entries);
+	std::vector<size_t> Load(Bodies& bodies, const nlohmann::json& data);
+}
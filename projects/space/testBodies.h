@@ -4,6 +4,9 @@
 #include "utils.h"
 #include "simulation.h"
 #include "bodies.h"
+#include "bodiesHandles.h"
+#include "systemLoader.h"
+#include "trajectoryStorage.h"
 
 extern double SimulationDt;
 extern Camera camera;
@@ -11,13 +14,14 @@ extern Camera camera;
 namespace TestBodies
 {
 	int32_t TrajectoryPointCount = 300;
+	// requested time, bodies.simulatedTime is the part already simulated in background
 	float SimulatedTime = 0.0f;
 	float CurrentTime = 0.0f;
 	bool IsPlaying = false;
 	bool IsParentSelect = false;
 	bool IsCameraFollow = false;
 
-	enum DrawFlag { DrawFlagEuler = 0x1, DrawFlagVerlet = 0x2, DrawFlagRungeKutta = 0x4, DrawFlagApproximated = 0x8, DrawFlagComputed = 0x10 };
+	enum DrawFlag { DrawFlagEuler = 0x1, DrawFlagVerlet = 0x2, DrawFlagRungeKutta = 0x4, DrawFlagApproximated = 0x8, DrawFlagComputed = 0x10, DrawFlagDormandPrince = 0x20, DrawFlagLeapfrog = 0x40 };
 	int32_t DrawFlags = DrawFlagEuler | DrawFlagVerlet | DrawFlagRungeKutta | DrawFlagApproximated | DrawFlagComputed;
 
 	std::optional<size_t> CurrentBody;
@@ -34,6 +38,7 @@ namespace TestBodies
 	using namespace Magnum2D;
 
 	Bodies bodies;
+	BodiesHandles handles(bodies);
 
 	void RefreshEffectiveRadius()
 	{
@@ -43,7 +48,7 @@ namespace TestBodies
 
 	void Resimulate()
 	{
-		bodies.SimulateClear(SimulatedTime);
+		bodies.SimulateClearAsync(SimulatedTime);
 	}
 
 	void Resimulate(size_t body)
@@ -53,18 +58,39 @@ namespace TestBodies
 
 	void SimulateExtend(double time)
 	{
-		bodies.SimulateExtend(time);
+		bodies.SimulateExtendAsync(time);
 		SimulatedTime += time;
 	}
 
 	void Gui()
 	{
-		if (ImGui::SliderInt("Trajectory Point Count", &TrajectoryPointCount, 100, 1000))
+		if (ImGui::SliderInt("Trajectory Point Count", &TrajectoryPointCount, 100, 100000, "%d", ImGuiSliderFlags_Logarithmic))
 			Resimulate();
 
-		ImGui::Text("Simulated days: %.3f [days]", TestBodies::SimulatedTime / Unit::Day);
+		auto storage = TrajectoryStorage::GetSettings();
+		int32_t budget = (int32_t)(storage.ramBudget / (1024 * 1024));
+		bool storageChanged = ImGui::SliderInt("Trajectory Memory [MB]", &budget, 0, 4096);
+		ImGui::SameLine();
+		storageChanged |= ImGui::Checkbox("Spill", &storage.spillToDisk);
+		if (storageChanged)
+		{
+			storage.ramBudget = (size_t)budget * 1024 * 1024;
+			TrajectoryStorage::SetSettings(storage);
+		}
+
+		auto storageStatistics = TrajectoryStorage::GetStatistics();
+		ImGui::Text("Trajectories: %.1f MB in memory, %.1f MB on disk", storageStatistics.residentBytes / (1024.0f * 1024.0f), storageStatistics.spilledBytes / (1024.0f * 1024.0f));
+
+		ImGui::Text("Simulated days: %.3f [days]", bodies.simulatedTime / Unit::Day);
 		ImGui::SameLine();
 		ImGui::Checkbox("Playing", &TestBodies::IsPlaying);
+		if (bodies.IsSimulating())
+		{
+			ImGui::ProgressBar(bodies.GetSimulationProgress());
+			ImGui::SameLine();
+			if (ImGui::Button("Cancel"))
+				SimulatedTime -= (float)bodies.CancelSimulation();
+		}
 
 		static float simulateDays = 365.0f;
 		ImGui::InputFloat("Days: ", &simulateDays, 0.5f, 15.0f);
@@ -72,14 +98,60 @@ namespace TestBodies
 		if (ImGui::Button("Simulate"))
 			SimulateExtend((double)simulateDays * Unit::Day);
 
+		// simulated run is saved with trajectories, opening it doesn't simulate again
+		static const char* ArchivePath = "trajectories.spta";
+		if (ImGui::Button("Save Run"))
+			bodies.WriteArchive(ArchivePath);
+		ImGui::SameLine();
+		if (ImGui::Button("Open Run") && bodies.ReadArchive(ArchivePath))
+			SimulatedTime = (float)bodies.simulatedTime;
+
+		if (ImGui::Combo("Gravity", (int32_t*)&bodies.settings.gravity.method, "Direct\0Barnes-Hut\0Vectorized\0Symmetric\0"))
+			Resimulate();
+		if (bodies.settings.gravity.method == Gravity::Method::BarnesHut)
+		{
+			float openingAngle = (float)bodies.settings.gravity.openingAngle;
+			if (ImGui::SliderFloat("Opening Angle", &openingAngle, 0.1f, 1.5f))
+			{
+				bodies.settings.gravity.openingAngle = openingAngle;
+				Resimulate();
+			}
+		}
+
+		int32_t threads = (int32_t)bodies.settings.gravity.threads;
+		if (ImGui::SliderInt("Threads", &threads, 1, (int32_t)ThreadPool::GetHardwareThreads()))
+		{
+			bodies.settings.gravity.threads = (size_t)threads;
+			Resimulate();
+		}
+
+		float tolerance = (float)std::log10(bodies.settings.adaptive.relativeTolerance);
+		if (ImGui::SliderFloat("RK45 Tolerance (log10)", &tolerance, -14.0f, -4.0f))
+		{
+			bodies.settings.adaptive.relativeTolerance = std::pow(10.0, (double)tolerance);
+			Resimulate();
+		}
+
+		if (ImGui::Combo("Leapfrog Scheme", (int32_t*)&bodies.settings.symplectic, "Leapfrog\0Yoshida 4\0Yoshida 6\0"))
+			Resimulate();
+		if (bodies.settings.symplectic == Simulation::SymplecticScheme::Leapfrog)
+		{
+			if (ImGui::SliderInt("Leapfrog Block Levels", &bodies.settings.blockTimesteps.maxLevel, 0, 10))
+				Resimulate();
+		}
+		if (ImGui::Combo("Leapfrog Precision", (int32_t*)&bodies.settings.precision, "Standard\0Compensated\0"))
+			Resimulate();
+
 		ImGui::CheckboxFlags("Euler", &DrawFlags, DrawFlagEuler); ImGui::SameLine();
 		ImGui::CheckboxFlags("Verlet", &DrawFlags, DrawFlagVerlet); ImGui::SameLine();
 		ImGui::CheckboxFlags("RungeKutta", &DrawFlags, DrawFlagRungeKutta); ImGui::SameLine();
+		ImGui::CheckboxFlags("RK45", &DrawFlags, DrawFlagDormandPrince); ImGui::SameLine();
+		ImGui::CheckboxFlags("Leapfrog", &DrawFlags, DrawFlagLeapfrog); ImGui::SameLine();
 		ImGui::CheckboxFlags("Approximated", &DrawFlags, DrawFlagApproximated); ImGui::SameLine();
 		ImGui::CheckboxFlags("Computed", &DrawFlags, DrawFlagComputed);
 
 		float currentDay = CurrentTime / Unit::Day;
-		ImGui::SliderFloat("Current Time", &currentDay, 0.0f, TestBodies::SimulatedTime / Unit::Day); ImGui::SameLine(); ImGui::Text("[days]");
+		ImGui::SliderFloat("Current Time", &currentDay, 0.0f, bodies.simulatedTime / Unit::Day); ImGui::SameLine(); ImGui::Text("[days]");
 		TestBodies::CurrentTime = currentDay * Unit::Day;
 
 		ImGui::RadioButton("View", (int32_t*)&CurrentState, 0); ImGui::SameLine();
@@ -106,14 +178,14 @@ namespace TestBodies
 			}
 
 			auto& trajectory = body.GetSimulation<PointRungeKutta>().trajectoryGlobal;
-			auto position = trajectory.times.empty() ? (vec2)body.initialPosition : trajectory.positions[trajectory.getPoint(CurrentTime)];
-			auto velocity = trajectory.times.empty() ? (vec2)body.initialVelocity : trajectory.velocities[trajectory.getPoint(CurrentTime)];
+			auto position = trajectory.times.empty() ? (vec2)body.initialPosition : trajectory.getState(CurrentTime).position;
+			auto velocity = trajectory.times.empty() ? (vec2)body.initialVelocity : trajectory.getState(CurrentTime).velocity;
 
 			if (body.parent)
 			{
 				auto& trajectoryParent = bodies.bodies[*body.parent].GetSimulation<PointRungeKutta>().trajectoryGlobal;
-				position -= trajectoryParent.times.empty() ? (vec2)bodies.bodies[*body.parent].initialPosition : trajectoryParent.positions[trajectoryParent.getPoint(CurrentTime)];
-				velocity -= trajectoryParent.times.empty() ? (vec2)bodies.bodies[*body.parent].initialVelocity : trajectoryParent.velocities[trajectoryParent.getPoint(CurrentTime)];
+				position -= trajectoryParent.times.empty() ? (vec2)bodies.bodies[*body.parent].initialPosition : trajectoryParent.getState(CurrentTime).position;
+				velocity -= trajectoryParent.times.empty() ? (vec2)bodies.bodies[*body.parent].initialVelocity : trajectoryParent.getState(CurrentTime).velocity;
 			}
 
 			ImGui::Text("Position"); ImGui::SameLine(100); ImGui::Text("%.3f %.3f 10^6 [km]", (float)(position.x() / (Unit::Kilometer * 1e6)), (float)(position.y() / (Unit::Kilometer * 1e6)));
@@ -148,59 +220,41 @@ namespace TestBodies
 
 	void SetupSolarSystemWip()
 	{
-		Unit::SetBaseMeter((1.0 / 1.5e8) * 1e-3);
-		Unit::SetBaseKilogram(1.0 / 2e30);
-		Unit::SetBaseSecond(1e-7 / Utils::Pi);
-
-		GravitationalConstant = 4.0 * Utils::Pi * Utils::Pi;
-		SimulationDt = Unit::Hour;
-
-		auto createBody = [](const char* name, vec2d position, vec2d velocity, double mass)
-		{
-			bodies.AddBody(name, position, velocity, mass);
-		};
-
-		auto data = Utils::ReadJsonFromResource("systems", "solar_system.json");
-		//auto data = Utils::ReadJsonFromResource("systems", "test_system.json");
+		SystemLoader::SetupSolarSystemUnits();
 
-		for (auto&[nameJson, body] : data.items())
-		{
-			const char* name = nameJson.c_str();
-			vec2d position = { (double)body["position"]["x"] * Unit::Meter, (double)body["position"]["y"] * Unit::Meter };
-			vec2d velocity = { (double)body["velocity"]["x"] * Unit::Meter / Unit::Second, (double)body["velocity"]["y"] * Unit::Meter / Unit::Second };
-			double mass = (double)body["mass"] * Unit::Kilogram;
+		auto entries = SystemLoader::ParseEntries(Utils::ReadResource("systems", "solar_system.json"));
+		//auto entries = SystemLoader::ParseEntries(Utils::ReadResource("systems", "test_system.json"));
 
-			bodies.AddBody(name, position, velocity, mass);
-			bodies.bodies.back().isStar = body.contains("star");
-		}
+		SystemLoader::Load(bodies, entries);
 	}
 
 	void Setup()
 	{
 		SetupSolarSystemWip();
 
-		bodies.vectorHandler.thresholdDistanceZoomIndependent = 0.03f;
+		handles.vectorHandler.thresholdDistanceZoomIndependent = 0.03f;
 
 		//bodiesEuler.currentPoints[1].initializeCircularOrbit({ 0.0,0.0 }, massSun / massScaler);
 	}
 
 	void UdpateCurrentTime()
 	{
-		if (IsPlaying && CurrentTime < SimulatedTime)
+		if (IsPlaying && CurrentTime < bodies.simulatedTime)
 			CurrentTime += (Unit::Day / getDeltaTimeMs()) * 0.1;
-		if (CurrentTime > SimulatedTime)
-			CurrentTime = SimulatedTime;
+		if (CurrentTime > bodies.simulatedTime)
+			CurrentTime = bodies.simulatedTime;
 	}
 
 	void Draw()
 	{
-		if (SimulatedTime != 0.0)
+		if (bodies.simulatedTime != 0.0)
 		{
 			for (size_t i = 0; i < bodies.bodies.size(); i++)
 				bodies.bodies[i].SetCurrentTime(CurrentTime);
 		}
 
-		bodies.Draw(DrawFlags & DrawFlagEuler, DrawFlags & DrawFlagVerlet, DrawFlags & DrawFlagRungeKutta, DrawFlags & DrawFlagApproximated, DrawFlags & DrawFlagComputed);
+		handles.Draw();
+		bodies.Draw(DrawFlags & DrawFlagEuler, DrawFlags & DrawFlagVerlet, DrawFlags & DrawFlagRungeKutta, DrawFlags & DrawFlagDormandPrince, DrawFlags & DrawFlagLeapfrog, DrawFlags & DrawFlagApproximated, DrawFlags & DrawFlagComputed);
 
 		for (size_t i = 0; i < bodies.bodies.size(); i++)
 		{
@@ -225,7 +279,7 @@ namespace TestBodies
 			drawCircleOutline(position, effectiveRadius, rgb(50, 50, 50));
 
 			// draw vector for circular orbit
-			if (body.parent && bodies.vectorHandler.IsGrab(body.initialVector))
+			if (body.parent && handles.IsGrab(*CurrentBody))
 			{
 				Bodies::Body& parent = bodies.bodies[*body.parent];
 
@@ -239,6 +293,7 @@ namespace TestBodies
 
 	bool Update()
 	{
+		bodies.UpdateSimulation();
 		UdpateCurrentTime();
 
 		if (IsCameraFollow)
@@ -253,6 +308,7 @@ namespace TestBodies
 				auto position = (vec2d)getMousePositionWorld();
 				auto name = Utils::GetRandomString(5);
 				auto body = bodies.AddBody(name.c_str(), position, {}, 1e24 * Unit::Kilogram);
+				CurrentBody = body;
 
 				Resimulate(body);
 
@@ -260,11 +316,12 @@ namespace TestBodies
 			}
 		}
 
-		auto[inputGrabbed, vectorChanged] = bodies.vectorHandler.Update();
+		handles.Select(CurrentBody);
+		auto[inputGrabbed, vectorChanged] = handles.Update();
 
-		if (bodies.vectorHandler.IsGrab() && !CurrentBody)
+		if (handles.GetGrabbedBody() && !CurrentBody)
 		{
-			CurrentBody = bodies.GetBodyOfGrab(*bodies.vectorHandler.GetGrab());
+			CurrentBody = handles.GetGrabbedBody();
 		}
 
 		if (clickHandler.IsClick())
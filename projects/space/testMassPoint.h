@@ -1,5 +1,6 @@
 #pragma once
 #include "ship.h"
+#include "threadPool.h"
 #include <vector>
 #include <optional>
 
@@ -18,6 +19,12 @@ namespace TestMassPoint
 	static std::optional<size_t> selectTimepoint;
 
 	Ship* currentShip = nullptr;
+	// while burn is dragged only patched conics are predicted, numerical trajectories follow when it's released
+	static bool RefineNumerically = true;
+	static Ship* refineShip = nullptr;
+
+	static int32_t Threads = (int32_t)ThreadPool::GetHardwareThreads();
+	static std::unique_ptr<ThreadPool> pool;
 
 	static void RefreshEffectiveRadius()
 	{
@@ -25,15 +32,37 @@ namespace TestMassPoint
 			m.recomputeEffectiveRadius();
 	}
 
-	static void Simulate(Ship& t)
+	// tasks of ships (trajectory of each integrator) on the pool, mass points are only read
+	static void Simulate(const std::vector<Ship*>& targets, bool refine)
+	{
+		if (!pool || pool->GetThreadCount() != (size_t)Threads)
+			pool = std::make_unique<ThreadPool>((size_t)Threads);
+
+		MassPointGrid grid;
+		grid.Build(massPoints);
+
+		const size_t tasks = (size_t)Ship::SimulationTask::Count;
+		pool->ParallelFor(targets.size() * tasks, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				targets[i / tasks]->Simulate((Ship::SimulationTask)(i % tasks), massPoints, grid, SimulationDt, SimulationSeconds, TrajectoryPointCount, refine && RefineNumerically);
+		});
+
+		for (auto t : targets)
+			t->Refresh();
+	}
+
+	static void Simulate(Ship& t, bool refine = true)
 	{
-		t.Simulate(massPoints, SimulationDt, SimulationSeconds, TrajectoryPointCount);
+		Simulate(std::vector<Ship*>{ &t }, refine);
 	}
 
 	static void Simulate()
 	{
+		std::vector<Ship*> targets;
 		for (auto& t : ships)
-			Simulate(*t);
+			targets.push_back(t.get());
+		Simulate(targets, true);
 	}
 
 	static void Setup()
@@ -63,11 +92,17 @@ namespace TestMassPoint
 		switch (updateResult)
 		{
 		case UpdateResult::Modified:
-			Simulate(*ship);
+			Simulate(*ship, false);
+			refineShip = ship;
 		case UpdateResult::InputGrab:
 			currentShip = ship;
 			break;
 		default:
+			if (refineShip == ship)
+			{
+				Simulate(*ship);
+				refineShip = nullptr;
+			}
 			currentShip = nullptr;
 		}
 	}
@@ -83,6 +118,12 @@ namespace TestMassPoint
 
 		if (ImGui::SliderInt("Trajectory Point Count", &TrajectoryPointCount, 100, 1000))
 			Simulate();
+
+		if (ImGui::Checkbox("Refine Numerically", &RefineNumerically))
+			Simulate();
+
+		if (ImGui::SliderInt("Threads", &Threads, 1, (int32_t)ThreadPool::GetHardwareThreads()))
+			Simulate();
 	}
 
 	static bool Update()
@@ -124,9 +165,9 @@ namespace TestMassPoint
 		for (auto& t : ships)
 		{
 			if (hoverTimepoint)
-				drawCircle(t->trajectoryVerlet.positions[*hoverTimepoint], Common::GetZoomIndependentSize(0.06f), rgb(50, 255, 50));
+				drawCircle(t->trajectoryPredicted.positions[*hoverTimepoint], Common::GetZoomIndependentSize(0.06f), rgb(50, 255, 50));
 			if (selectTimepoint)
-				drawCircle(t->trajectoryVerlet.positions[*selectTimepoint], Common::GetZoomIndependentSize(0.06f), rgb(50, 50, 255));
+				drawCircle(t->trajectoryPredicted.positions[*selectTimepoint], Common::GetZoomIndependentSize(0.06f), rgb(50, 50, 255));
 		}
 
 		// draw ships
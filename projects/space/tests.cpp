@@ -0,0 +1,127 @@
+#include "gravity.h"
+#include "simulation.h"
+#include "systemLoader.h"
+#include "simulationBodies.h"
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+// Checks of simulation against reference computations, run by ctest (space-tests). Bundled systems
+// are read from SPACE_ASSETS_DIR.
+
+using namespace Magnum2D;
+
+double SimulationDt = 0.01;
+
+namespace TestBodies
+{
+	int32_t TrajectoryPointCount = 300;
+	float CurrentTime = 0.0f;
+}
+
+namespace
+{
+	const char* SolarSystemPath = SPACE_ASSETS_DIR "/solar_system.json";
+
+	bool Check(bool condition, const std::string& message)
+	{
+		if (!condition)
+			std::cerr << "  " << message << "\n";
+		return condition;
+	}
+
+	// Barnes-Hut accelerations of bodies of solar system are close to exact pairwise sum
+	bool TestBarnesHutSolarSystem()
+	{
+		SystemLoader::SetupSolarSystemUnits();
+		auto entries = SystemLoader::Read(SolarSystemPath);
+
+		std::vector<vec2d> positions;
+		std::vector<double> masses;
+		for (const auto& entry : entries)
+		{
+			positions.push_back(entry.position * Unit::Meter);
+			masses.push_back(entry.mass * Unit::Kilogram);
+		}
+
+		std::vector<vec2d> direct(positions.size()), barnesHut(positions.size());
+		Gravity::Solver solver;
+		Gravity::Settings settings;
+		settings.method = Gravity::Method::Direct;
+		solver.Compute(settings, positions, masses, direct);
+		settings.method = Gravity::Method::BarnesHut;
+		solver.Compute(settings, positions, masses, barnesHut);
+
+		const double tolerance = 1e-2;
+		bool result = true;
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			const double error = (barnesHut[i] - direct[i]).length() / direct[i].length();
+			result &= Check(error <= tolerance, entries[i].name + ": relative error " + std::to_string(error));
+		}
+		return result;
+	}
+
+	// candidates pruned by Hill spheres over the whole trajectory give the same parents as scoring all bodies
+	bool TestParentsPruning()
+	{
+		SystemLoader::SetupSolarSystemUnits();
+
+		Bodies bodies;
+		SystemLoader::Load(bodies, SystemLoader::Read(SolarSystemPath));
+
+		SimulationBodies<PointRungeKutta> simulation(bodies.bodies);
+		simulation.SimulateClear(Unit::Year);
+
+		const auto pruned = simulation.ComputeParents();
+		const auto all = simulation.ComputeParents(false);
+
+		bool result = Check(pruned.size() == bodies.bodies.size(), "parents of " + std::to_string(pruned.size()) + " bodies");
+		for (const auto& [child, parent] : all)
+		{
+			const auto found = pruned.find(child);
+			result &= Check(found != std::end(pruned) && found->second == parent, bodies.bodies[child].name + ": parent differs");
+		}
+		return result;
+	}
+
+	// state which is not finite is rejected until simulation gives up, only the initial point is left
+	bool TestAdaptiveNonFinite()
+	{
+		SystemLoader::SetupSolarSystemUnits();
+
+		std::vector<PointDormandPrince> points = {
+			PointDormandPrince({ 0.0, 0.0 }, { 0.0, 0.0 }, 1.0),
+			PointDormandPrince({ std::numeric_limits<double>::quiet_NaN(), 1.0 }, { 1.0, 0.0 }, 1e-6)
+		};
+		std::vector<std::vector<BurnPtr>> burns(points.size());
+
+		Simulation::Statistics statistics;
+		Simulation::Settings settings;
+		settings.statistics = &statistics;
+		auto trajectories = Simulation::Simulate(points, burns, SimulationDt, Unit::Year, 0.0, 100, settings);
+
+		return Check(statistics.failed, "simulation did not fail") &
+			   Check(statistics.rejectedSteps == (size_t)settings.adaptive.maxRejections + 1, "rejected steps " + std::to_string(statistics.rejectedSteps)) &
+			   Check(trajectories[0].times.size() == 1, "trajectory points were added");
+	}
+}
+
+int main()
+{
+	const std::pair<const char*, std::function<bool()>> tests[] = {
+		{ "BarnesHutSolarSystem", TestBarnesHutSolarSystem },
+		{ "AdaptiveNonFinite", TestAdaptiveNonFinite },
+		{ "ParentsPruning", TestParentsPruning },
+	};
+
+	int failed = 0;
+	for (const auto& [name, test] : tests)
+	{
+		const bool passed = test();
+		std::cout << (passed ? "passed " : "FAILED ") << name << "\n";
+		failed += passed ? 0 : 1;
+	}
+
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#include "threadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	threads = std::max<size_t>(threads, 1);
+
+	for (size_t i = 0; i < threads; i++)
+		queues.push_back(std::make_unique<Queue>());
+
+	// queue 0 belongs to the thread calling ParallelFor
+	for (size_t i = 1; i < threads; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(mutex);
+		stop = true;
+	}
+	wakeCondition.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+size_t ThreadPool::GetHardwareThreads()
+{
+	return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void ThreadPool::ParallelFor(size_t count, const Func& func)
+{
+	if (count == 0)
+		return;
+
+	const size_t threads = queues.size();
+
+	if (threads == 1)
+	{
+		func(0, count);
+		return;
+	}
+
+	// few chunks per thread, so there is something to steal when work is not balanced
+	const size_t chunkCount = std::min(count, threads * 4);
+	const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+	const size_t tasks = (count + chunkSize - 1) / chunkSize;
+
+	pendingTasks = tasks;
+
+	// neighbouring chunks go to the same queue
+	for (size_t i = 0; i < tasks; i++)
+	{
+		Queue& queue = *queues[i * threads / tasks];
+
+		std::lock_guard lock(queue.mutex);
+		queue.tasks.push_back({ &func, i * chunkSize, std::min(count, (i + 1) * chunkSize) });
+	}
+
+	{
+		std::lock_guard lock(mutex);
+		generation++;
+	}
+	wakeCondition.notify_all();
+
+	RunTasks(0);
+
+	// barrier, chunks stolen by workers may be still running
+	std::unique_lock lock(mutex);
+	doneCondition.wait(lock, [this] { return pendingTasks == 0; });
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+	uint64_t seenGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock lock(mutex);
+			wakeCondition.wait(lock, [&] { return stop || generation != seenGeneration; });
+
+			if (stop)
+				return;
+
+			seenGeneration = generation;
+		}
+
+		RunTasks(index);
+	}
+}
+
+void ThreadPool::RunTasks(size_t index)
+{
+	Task task;
+	while (PopTask(index, task))
+	{
+		(*task.func)(task.begin, task.end);
+
+		if (pendingTasks.fetch_sub(1) == 1)
+		{
+			std::lock_guard lock(mutex);
+			doneCondition.notify_all();
+		}
+	}
+}
+
+bool ThreadPool::PopTask(size_t index, Task& task)
+{
+	{
+		Queue& own = *queues[index];
+		std::lock_guard lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = own.tasks.front();
+			own.tasks.pop_front();
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < queues.size(); i++)
+	{
+		Queue& other = *queues[(index + i) % queues.size()];
+		std::lock_guard lock(other.mutex);
+		if (!other.tasks.empty())
+		{
+			task = other.tasks.back();
+			other.tasks.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// Work-stealing pool for parallel loops. Every worker has its own queue of chunks,
+// idle worker steals chunks from the back of other queues. The calling thread works
+// as one of the workers, so pool with single thread runs everything inline.
+struct ThreadPool
+{
+	using Func = std::function<void(size_t begin, size_t end)>;
+
+	explicit ThreadPool(size_t threads = 1);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t GetThreadCount() const { return queues.size(); }
+
+	// Call func for chunks of range [0, count) and wait until all of them are done.
+	// Results are independent of the thread count as long as func for one index
+	// does not depend on other indices.
+	void ParallelFor(size_t count, const Func& func);
+
+	static size_t GetHardwareThreads();
+
+private:
+	struct Task
+	{
+		const Func* func;
+		size_t begin;
+		size_t end;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	void WorkerLoop(size_t index);
+	// run tasks from own queue and stolen ones, returns when there is nothing left to do
+	void RunTasks(size_t index);
+	bool PopTask(size_t index, Task& task);
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+	uint64_t generation = 0;
+	bool stop = false;
+
+	std::atomic<size_t> pendingTasks = 0;
+};
@@ -1,13 +1,15 @@
 #include "trajectory.h"
 #include "utils.h"
-#include "common.h"
 #include "simulation.h"
 #include <algorithm>
 #include <cassert>
+#include <limits>
 
 using namespace Magnum2D;
 
 static const float GrabBurnCircleRadius = 0.3f;
+// points after the last result of getPoint checked before falling back to binary search
+static const size_t CursorSteps = 8;
 
 std::vector<vec2> ConvertToFloat(const std::vector<vec2d>& arr)
 {
@@ -60,7 +62,7 @@ size_t Trajectory::getClosestPointOnTrajectoryAroundIndex(const vec2& point, siz
 	if (prevDistSqr < leftDistSqr && prevDistSqr < rightDistSqr)
 		return previousIndex;
 
-	auto iterateCloser = [](size_t index, float distSqr, const vec2& point, const std::vector<vec2>& positions, auto inc)
+	auto iterateCloser = [](size_t index, float distSqr, const vec2& point, const ChunkedVector<vec2>& positions, auto inc)
 	{
 		size_t indexNext = inc(index, positions.size());
 		float distSqrNext = Utils::DistanceSqr(point, (vec2)positions[indexNext]);
@@ -103,65 +105,86 @@ size_t Trajectory::getClosestPointOnTrajectoryAroundIndex(const vec2& point, siz
 	return size_t();
 }
 
-void Trajectory::draw(size_t fromIndex, size_t toIndex, Magnum2D::col3 color)
+size_t Trajectory::getPoint(double time)
 {
-	Common::DrawPolyline(std::span(std::begin(positions) + fromIndex, toIndex - fromIndex + 1), Common::GetZoomIndependentSize(0.05f), color);
+	if (time >= times.back())
+		return times.size() - 1;
 
-	Utils::DrawCross(positions[fromIndex], Common::GetZoomIndependentSize(0.3f), rgb(200, 200, 200));
-}
+	// from here on time is before the last point, so the searched point exists
 
-void Trajectory::draw(double fromTime, double toTime, Magnum2D::col3 color)
-{
-	if (fromTime == toTime || times.empty())
-		return;
+	if (cursor < times.size() && (cursor == 0 || times[cursor - 1] < time))
+	{
+		const size_t end = std::min(cursor + CursorSteps, times.size());
+		for (size_t i = cursor; i < end; i++)
+		{
+			if (times[i] >= time)
+				return cursor = i;
+		}
+	}
+
+	using Times = ChunkedVector<float>;
 
-	draw(getPoint(fromTime), getPoint(toTime), color);
+	if (chunkTimesGeneration != times.GetGeneration())
+	{
+		chunkTimes.clear();
+		chunkTimesGeneration = times.GetGeneration();
+	}
+	while (chunkTimes.size() < times.GetChunkCount())
+		chunkTimes.push_back(times.GetChunkData(chunkTimes.size()).front());
+
+	// chunks starting before time, the point is in the last of them or it is the first point of the next one
+	size_t chunk = std::partition_point(chunkTimes.begin(), chunkTimes.end(), [time](float t) { return t < time; }) - chunkTimes.begin();
+	if (chunk == 0)
+		return cursor = 0;
+	chunk--;
+
+	auto data = times.GetChunkData(chunk);
+	size_t offset = std::partition_point(data.begin(), data.end(), [time](float t) { return t < time; }) - data.begin();
+
+	return cursor = (chunk << Times::ChunkShift) + offset;
 }
 
-void Trajectory::draw(col3 color)
+Trajectory::State Trajectory::getState(double time)
 {
-	Common::DrawPolyline(positions, Common::GetZoomIndependentSize(0.05f), color);
+	const size_t next = getPoint(time);
+	if (next == 0 || time >= times[next])
+		return { positions[next], velocities[next] };
 
-	Utils::DrawCross(positions[0], Common::GetZoomIndependentSize(0.3f), rgb(200, 200, 200));
+	const size_t prev = next - 1;
+	return Interpolate({ positions[prev], velocities[prev] }, times[prev], { positions[next], velocities[next] }, times[next], time);
 }
 
-size_t Trajectory::getPoint(double time)
+Trajectory::State Trajectory::Interpolate(const State& first, double from, const State& second, double to, double time)
 {
-	if (time >= times.back())
-		return times.size() - 1;
+	if (to <= from)
+		return first;
 
-	size_t result = 0;
+	const float h = (float)(to - from);
+	const float s = (float)std::clamp((time - from) / (to - from), 0.0, 1.0);
+	const float s2 = s * s, s3 = s2 * s;
 
-	while (times[result] < time && result != times.size())
-		result++;
+	// Hermite basis and its derivative (with respect to s)
+	const float h00 = 2.0f * s3 - 3.0f * s2 + 1.0f, h10 = s3 - 2.0f * s2 + s, h01 = -2.0f * s3 + 3.0f * s2, h11 = s3 - s2;
+	const float d00 = 6.0f * s2 - 6.0f * s, d10 = 3.0f * s2 - 4.0f * s + 1.0f, d01 = -d00, d11 = 3.0f * s2 - 2.0f * s;
 
-	assert(result != times.size());
+	State result;
+	result.position = first.position * h00 + first.velocity * (h10 * h) + second.position * h01 + second.velocity * (h11 * h);
+	result.velocity = (first.position * d00 + second.position * d01) / h + first.velocity * d10 + second.velocity * d11;
 
 	return result;
 }
 
 void Trajectory::extend(Trajectory&& trajectory, size_t fromIndex)
 {
-	positions.reserve(positions.size() + trajectory.positions.size());
-	positions.insert(positions.end(), std::make_move_iterator(trajectory.positions.begin() + fromIndex), std::make_move_iterator(trajectory.positions.end()));
-
-	velocities.reserve(velocities.size() + trajectory.velocities.size());
-	velocities.insert(velocities.end(), std::make_move_iterator(trajectory.velocities.begin() + fromIndex), std::make_move_iterator(trajectory.velocities.end()));
-
-	times.reserve(times.size() + trajectory.times.size());
-	times.insert(times.end(), std::make_move_iterator(trajectory.times.begin() + fromIndex), std::make_move_iterator(trajectory.times.end()));
+	extend(static_cast<const Trajectory&>(trajectory), fromIndex);
+	trajectory.clear();
 }
 
 void Trajectory::extend(const Trajectory& trajectory, size_t fromIndex)
 {
-	positions.reserve(positions.size() + trajectory.positions.size());
-	positions.insert(positions.end(), (trajectory.positions.begin() + fromIndex), (trajectory.positions.end()));
-
-	velocities.reserve(velocities.size() + trajectory.velocities.size());
-	velocities.insert(velocities.end(), (trajectory.velocities.begin() + fromIndex), (trajectory.velocities.end()));
-
-	times.reserve(times.size() + trajectory.times.size());
-	times.insert(times.end(), (trajectory.times.begin() + fromIndex), (trajectory.times.end()));
+	positions.append(trajectory.positions, fromIndex);
+	velocities.append(trajectory.velocities, fromIndex);
+	times.append(trajectory.times, fromIndex);
 }
 
 void Trajectory::clear()
@@ -170,3 +193,164 @@ void Trajectory::clear()
 	velocities.clear();
 	times.clear();
 }
+
+void Trajectory::truncate(size_t count)
+{
+	positions.truncate(count);
+	velocities.truncate(count);
+	times.truncate(count);
+}
+
+void Trajectory::unmap()
+{
+	positions.unmap();
+	velocities.unmap();
+	times.unmap();
+}
+
+void Trajectory::getDecimated(size_t fromIndex, size_t toIndex, float tolerance, std::vector<vec2>& result) const
+{
+	result.clear();
+	if (positions.empty() || fromIndex > toIndex)
+		return;
+
+	toIndex = std::min(toIndex, positions.size() - 1);
+
+	using Positions = ChunkedVector<vec2>;
+
+	if (lodsGeneration != positions.GetGeneration())
+	{
+		lods.clear();
+		lodsGeneration = positions.GetGeneration();
+	}
+
+	for (size_t chunk = fromIndex >> Positions::ChunkShift; chunk <= (toIndex >> Positions::ChunkShift); chunk++)
+	{
+		const size_t chunkBegin = chunk << Positions::ChunkShift;
+		const size_t from = std::max(fromIndex, chunkBegin) - chunkBegin;
+		const size_t to = std::min(toIndex, chunkBegin + Positions::ChunkSize - 1) - chunkBegin;
+
+		auto data = positions.GetChunkData(chunk);
+
+		if (!positions.IsChunkSealed(chunk))
+		{
+			result.insert(result.end(), data.begin() + from, data.begin() + to + 1);
+			continue;
+		}
+
+		// chunks before the range are not touched, spilled ones stay on disk
+		if (lods.size() <= chunk)
+			lods.resize(chunk + 1);
+		if (!lods[chunk])
+			lods[chunk] = TrajectoryLod::Build(data);
+
+		const TrajectoryLod& lod = *lods[chunk];
+
+		// coarsest level which is still precise enough
+		size_t level = 0;
+		while (level + 1 < lod.levels.size() && lod.extent / (float)(2 << level) > tolerance)
+			level++;
+
+		const auto& indices = lod.levels[level];
+
+		result.push_back(data[from]);
+		auto it = std::upper_bound(indices.begin(), indices.end(), (uint16_t)from);
+		for (; it != indices.end() && *it < to; it++)
+			result.push_back(data[*it]);
+		if (to != from)
+			result.push_back(data[to]);
+	}
+}
+
+TrajectoryLod TrajectoryLod::Build(std::span<const vec2> positions)
+{
+	TrajectoryLod result;
+
+	const size_t count = positions.size();
+	if (count == 0)
+		return result;
+
+	vec2 min = positions[0], max = positions[0];
+	for (const auto& p : positions)
+	{
+		min = { std::min(min.x(), p.x()), std::min(min.y(), p.y()) };
+		max = { std::max(max.x(), p.x()), std::max(max.y(), p.y()) };
+	}
+	result.extent = std::max(max.x() - min.x(), max.y() - min.y());
+
+	// Importance of point is the largest tolerance at which Douglas-Peucker keeps it. It is limited
+	// by importance of the segment split, so levels are nested.
+	std::vector<float> importance(count, 0.0f);
+	importance[0] = importance[count - 1] = std::numeric_limits<float>::max();
+
+	struct Segment
+	{
+		size_t first;
+		size_t last;
+		float limit;
+	};
+	std::vector<Segment> stack = { { 0, count - 1, std::numeric_limits<float>::max() } };
+
+	while (!stack.empty())
+	{
+		Segment segment = stack.back();
+		stack.pop_back();
+
+		if (segment.last <= segment.first + 1)
+			continue;
+
+		const vec2 a = positions[segment.first];
+		const vec2 direction = positions[segment.last] - a;
+		const float lengthSqr = direction.dot();
+
+		float distance = -1.0f;
+		size_t split = segment.first + 1;
+
+		for (size_t i = segment.first + 1; i < segment.last; i++)
+		{
+			vec2 offset = positions[i] - a;
+			float d;
+			if (lengthSqr > 0.0f)
+			{
+				float t = std::clamp((offset.x() * direction.x() + offset.y() * direction.y()) / lengthSqr, 0.0f, 1.0f);
+				d = (offset - direction * t).length();
+			}
+			else
+			{
+				d = offset.length();
+			}
+
+			if (d > distance)
+			{
+				distance = d;
+				split = i;
+			}
+		}
+
+		float value = std::min(distance, segment.limit);
+		importance[split] = value;
+		stack.push_back({ segment.first, split, value });
+		stack.push_back({ split, segment.last, value });
+	}
+
+	// level l keeps points with importance above extent / 2^(l + 1), stop when all points are kept
+	for (int32_t level = 0; ; level++)
+	{
+		const float tolerance = result.extent / (float)(2 << level);
+
+		std::vector<uint16_t> indices;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (importance[i] > tolerance || level >= 24)
+				indices.push_back((uint16_t)i);
+		}
+
+		const bool complete = indices.size() == count;
+		result.levels.push_back(std::move(indices));
+
+		if (complete)
+			break;
+	}
+
+	return result;
+}
@@ -1,28 +1,71 @@
 #pragma once
 #include "point.h"
 #include "utils.h"
+#include "chunkedVector.h"
 #include <vector>
 #include <memory>
 #include <optional>
 
+// Douglas-Peucker pyramid of one full chunk of trajectory positions. Level l contains indices
+// (relative to the chunk) of points needed to keep the polyline within extent / 2^(l + 1)
+// of the full one, the last level contains all points.
+struct TrajectoryLod
+{
+	float extent = 0.0f;
+	std::vector<std::vector<uint16_t>> levels;
+
+	static TrajectoryLod Build(std::span<const Magnum2D::vec2> positions);
+};
+
 struct Trajectory
 {
+	// position and velocity at arbitrary time
+	struct State
+	{
+		Magnum2D::vec2 position;
+		Magnum2D::vec2 velocity;
+	};
+
 	void draw(Magnum2D::col3 color);
 	void draw(double fromTime, double toTime, Magnum2D::col3 color);
 	void draw(size_t fromIndex, size_t toIndex, Magnum2D::col3 color);
 
 	size_t getClosestPointOnTrajectory(const Magnum2D::vec2& point);
 	size_t getClosestPointOnTrajectoryAroundIndex(const Magnum2D::vec2& point, size_t previousIndex); // get closest point given previous index
+	// index of first point at or after time (last point if time is past the end)
 	size_t getPoint(double time);
+	// cubic Hermite interpolation between points around time using stored velocities
+	State getState(double time);
+	// interpolation between states at times from and to, time is clamped to the interval
+	static State Interpolate(const State& first, double from, const State& second, double to, double time);
 
 	void extend(Trajectory&& trajectory, size_t fromIndex = 0);
 	void extend(const Trajectory& trajectory, size_t fromIndex = 0);
 
 	void clear();
+	// keeps first count points
+	void truncate(size_t count);
+	// points in file mapped by TrajectoryArchive::Read are copied to memory
+	void unmap();
+
+	// Positions [fromIndex, toIndex] decimated so that the polyline deviates at most by tolerance
+	// from the full one (used for drawing at current zoom). First and last points are always included.
+	void getDecimated(size_t fromIndex, size_t toIndex, float tolerance, std::vector<Magnum2D::vec2>& result) const;
+
+	ChunkedVector<Magnum2D::vec2> positions;
+	ChunkedVector<Magnum2D::vec2> velocities;
+	ChunkedVector<float> times;
+
+private:
+	// built lazily for sealed chunks of positions, only for chunks which were drawn
+	mutable std::vector<std::optional<TrajectoryLod>> lods;
+	mutable uint64_t lodsGeneration = 0;
 
-	std::vector<Magnum2D::vec2> positions;
-	std::vector<Magnum2D::vec2> velocities;
-	std::vector<float> times;
+	// time of first point of each chunk, binary search doesn't touch (and load) chunks outside of result
+	std::vector<float> chunkTimes;
+	uint64_t chunkTimesGeneration = 0;
+	// result of last getPoint, playback usually asks for the same or following point
+	size_t cursor = 0;
 };
 
 using TrajectoryPtr = std::unique_ptr<Trajectory>;
@@ -0,0 +1,152 @@
+#include "trajectoryArchive.h"
+#include "mappedFile.h"
+#include <fstream>
+#include <algorithm>
+#include <memory>
+#include <cstring>
+
+using namespace Magnum2D;
+
+namespace TrajectoryArchive
+{
+	// columns start aligned to cache line
+	static const uint64_t ColumnAlignment = 64;
+
+	static uint64_t Align(uint64_t offset)
+	{
+		return (offset + ColumnAlignment - 1) / ColumnAlignment * ColumnAlignment;
+	}
+
+	template<class T>
+	static void WriteColumn(std::ostream& stream, const ChunkedVector<T>& column)
+	{
+		for (size_t i = 0; i < column.GetChunkCount(); i++)
+		{
+			auto data = column.GetChunkData(i);
+			stream.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+		}
+	}
+
+	template<class T>
+	static bool ReadColumn(const std::shared_ptr<MappedFile>& file, uint64_t offset, uint64_t count, ChunkedVector<T>& column)
+	{
+		if (offset % alignof(T) != 0 || offset > file->size || count > (file->size - offset) / sizeof(T))
+			return false;
+
+		T* data = reinterpret_cast<T*>(file->data + offset);
+
+		column.clear();
+		for (size_t i = 0; i < (size_t)count; i += ChunkedVector<T>::ChunkSize)
+			column.appendMapped(data + i, std::min((size_t)count - i, ChunkedVector<T>::ChunkSize), file);
+
+		return true;
+	}
+
+	bool Write(const std::filesystem::path& path, std::span<const Trajectory* const> trajectories, std::span<const double> values)
+	{
+		FileHeader header;
+		header.trajectories = trajectories.size();
+		header.values = values.size();
+
+		std::vector<Columns> directory(trajectories.size());
+		uint64_t offset = sizeof(FileHeader) + values.size() * sizeof(double) + directory.size() * sizeof(Columns);
+		for (size_t i = 0; i < trajectories.size(); i++)
+		{
+			const Trajectory& trajectory = *trajectories[i];
+			Columns& columns = directory[i];
+			columns.count = trajectory.times.size();
+			if (trajectory.positions.size() != columns.count || trajectory.velocities.size() != columns.count)
+				return false;
+
+			columns.times = offset = Align(offset);
+			offset += columns.count * sizeof(float);
+			columns.positions = offset = Align(offset);
+			offset += columns.count * sizeof(vec2);
+			columns.velocities = offset = Align(offset);
+			offset += columns.count * sizeof(vec2);
+		}
+
+		auto temporary = path;
+		temporary += ".tmp";
+		{
+			std::ofstream stream(temporary, std::ios::binary);
+
+			auto pad = [&](uint64_t columnOffset)
+			{
+				static const char zeros[ColumnAlignment] = {};
+				stream.write(zeros, (std::streamsize)(columnOffset - (uint64_t)stream.tellp()));
+			};
+
+			stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+			stream.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(Columns));
+
+			for (size_t i = 0; i < trajectories.size(); i++)
+			{
+				pad(directory[i].times);
+				WriteColumn(stream, trajectories[i]->times);
+				pad(directory[i].positions);
+				WriteColumn(stream, trajectories[i]->positions);
+				pad(directory[i].velocities);
+				WriteColumn(stream, trajectories[i]->velocities);
+			}
+
+			if (!stream)
+			{
+				stream.close();
+				std::error_code error;
+				std::filesystem::remove(temporary, error);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+		if (!error)
+			return true;
+
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+
+	bool Read(const std::filesystem::path& path, std::vector<Trajectory>& trajectories, std::vector<double>& values)
+	{
+		auto file = MappedFile::Open(path);
+		if (!file || file->size < sizeof(FileHeader))
+			return false;
+
+		FileHeader header, expected;
+		std::memcpy(&header, file->data, sizeof(header));
+		if (!std::equal(std::begin(header.magic), std::end(header.magic), std::begin(expected.magic)) || header.version != expected.version ||
+			header.chunkSize != expected.chunkSize)
+			return false;
+
+		const uint64_t directoryOffset = sizeof(FileHeader) + header.values * sizeof(double);
+		if (header.values > file->size / sizeof(double) || header.trajectories > file->size / sizeof(Columns) ||
+			directoryOffset + header.trajectories * sizeof(Columns) > file->size)
+			return false;
+
+		values.resize((size_t)header.values);
+		std::memcpy(values.data(), file->data + sizeof(FileHeader), values.size() * sizeof(double));
+
+		std::vector<Columns> directory((size_t)header.trajectories);
+		std::memcpy(directory.data(), file->data + directoryOffset, directory.size() * sizeof(Columns));
+
+		trajectories.clear();
+		trajectories.resize(directory.size());
+		for (size_t i = 0; i < directory.size(); i++)
+		{
+			const Columns& columns = directory[i];
+			Trajectory& trajectory = trajectories[i];
+			if (!ReadColumn(file, columns.times, columns.count, trajectory.times) || !ReadColumn(file, columns.positions, columns.count, trajectory.positions) ||
+				!ReadColumn(file, columns.velocities, columns.count, trajectory.velocities))
+			{
+				trajectories.clear();
+				values.clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "trajectory.h"
+#include <filesystem>
+#include <span>
+#include <vector>
+
+// Columnar file of trajectories. Columns of each trajectory (times, positions, velocities) are
+// stored one after another in the layout of ChunkedVector chunks, so reading maps the file to
+// memory and full chunks point directly to it. Nothing is read before it is accessed (drawn,
+// interpolated), the system loads and releases pages of the file.
+// File is a header, values of caller, directory of columns and aligned columns.
+namespace TrajectoryArchive
+{
+	struct FileHeader
+	{
+		char magic[4] = { 'S', 'P', 'T', 'A' };
+		uint32_t version = 1;
+		// elements of chunk, columns can be mapped only by the same ChunkedVector
+		uint32_t chunkSize = (uint32_t)ChunkedVector<float>::ChunkSize;
+		uint32_t reserved0 = 0;
+		uint64_t trajectories = 0;
+		uint64_t values = 0;
+		uint64_t reserved[4] = {};
+	};
+	static_assert(sizeof(FileHeader) == 64, "values start aligned to cache line");
+
+	// byte offsets of columns in file, count of elements is the same in all columns
+	struct Columns
+	{
+		uint64_t count = 0;
+		uint64_t times = 0;
+		uint64_t positions = 0;
+		uint64_t velocities = 0;
+	};
+
+	// Values are any additional data of caller (e.g. state of simulation). File is written to
+	// temporary one first, which is removed on failure. Path must not be mapped by Read anymore
+	// (see Trajectory::unmap), mapped file can't be replaced on Windows.
+	bool Write(const std::filesystem::path& path, std::span<const Trajectory* const> trajectories, std::span<const double> values = {});
+
+	// Trajectories and values are replaced, fails when file is not archive of the same version
+	// and chunk size. Mapping is kept until all trajectories pointing to it are cleared or destroyed.
+	bool Read(const std::filesystem::path& path, std::vector<Trajectory>& trajectories, std::vector<double>& values);
+}
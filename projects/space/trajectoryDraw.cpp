@@ -0,0 +1,34 @@
+#include "trajectory.h"
+#include "utils.h"
+#include "common.h"
+
+using namespace Magnum2D;
+
+// polyline may deviate from trajectory by fraction of its width
+static const float DecimationTolerance = 0.01f;
+
+void Trajectory::draw(size_t fromIndex, size_t toIndex, Magnum2D::col3 color)
+{
+	std::vector<vec2> points;
+	getDecimated(fromIndex, toIndex, Common::GetZoomIndependentSize(DecimationTolerance), points);
+
+	Common::DrawPolyline(points, Common::GetZoomIndependentSize(0.05f), color);
+
+	Utils::DrawCross(positions[fromIndex], Common::GetZoomIndependentSize(0.3f), rgb(200, 200, 200));
+}
+
+void Trajectory::draw(double fromTime, double toTime, Magnum2D::col3 color)
+{
+	if (fromTime == toTime || times.empty())
+		return;
+
+	draw(getPoint(fromTime), getPoint(toTime), color);
+}
+
+void Trajectory::draw(col3 color)
+{
+	if (positions.empty())
+		return;
+
+	draw(0, positions.size() - 1, color);
+}
@@ -0,0 +1,183 @@
+#include "trajectoryStorage.h"
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <atomic>
+#include <thread>
+
+namespace TrajectoryStorage
+{
+	// sealed resident chunks in order of clock eviction, spilled chunks are not listed
+	struct Registry
+	{
+		std::mutex mutex;
+		Settings settings;
+		Statistics statistics;
+		std::list<Chunk*> resident;
+		std::atomic<uint64_t> nextFile = 0;
+		// the only thread which spills chunks
+		std::thread::id owner;
+
+		static Registry& Get()
+		{
+			static Registry registry;
+			return registry;
+		}
+
+		std::filesystem::path GetDirectory()
+		{
+			if (!settings.directory.empty())
+				return settings.directory;
+			return std::filesystem::temp_directory_path() / "space-trajectories";
+		}
+
+		void Trim()
+		{
+			if (!settings.spillToDisk || settings.ramBudget == 0 || std::this_thread::get_id() != owner)
+				return;
+
+			// every chunk gets at most one second chance, so the loop ends
+			size_t remaining = resident.size() * 2;
+
+			while (statistics.residentBytes > settings.ramBudget && !resident.empty() && remaining-- > 0)
+			{
+				Chunk* chunk = resident.front();
+				resident.pop_front();
+
+				if (chunk->accessed)
+				{
+					chunk->accessed = false;
+					resident.push_back(chunk);
+					chunk->position = std::prev(resident.end());
+					continue;
+				}
+
+				chunk->Spill();
+			}
+		}
+	};
+
+	void SetSettings(const Settings& settings)
+	{
+		auto& registry = Registry::Get();
+		std::lock_guard lock(registry.mutex);
+		registry.settings = settings;
+		registry.owner = std::this_thread::get_id();
+		registry.Trim();
+	}
+
+	const Settings& GetSettings()
+	{
+		return Registry::Get().settings;
+	}
+
+	Statistics GetStatistics()
+	{
+		auto& registry = Registry::Get();
+		std::lock_guard lock(registry.mutex);
+		return registry.statistics;
+	}
+
+	void Trim()
+	{
+		auto& registry = Registry::Get();
+		std::lock_guard lock(registry.mutex);
+		registry.Trim();
+	}
+
+	Chunk::~Chunk()
+	{
+		if (sealed && !mapped)
+		{
+			auto& registry = Registry::Get();
+			std::lock_guard lock(registry.mutex);
+
+			if (resident)
+			{
+				registry.resident.erase(position);
+				registry.statistics.residentBytes -= bytes;
+			}
+			else
+			{
+				registry.statistics.spilledBytes -= bytes;
+			}
+		}
+
+		if (!file.empty())
+		{
+			std::error_code error;
+			std::filesystem::remove(file, error);
+		}
+	}
+
+	void Chunk::Seal()
+	{
+		auto& registry = Registry::Get();
+		std::lock_guard lock(registry.mutex);
+
+		sealed = true;
+		accessed = true;
+		bytes = GetBytes();
+		registry.resident.push_back(this);
+		position = std::prev(registry.resident.end());
+		registry.statistics.residentBytes += bytes;
+
+		registry.Trim();
+	}
+
+	void Chunk::SealMapped()
+	{
+		sealed = true;
+		mapped = true;
+	}
+
+	// called with locked registry on owner thread
+	void Chunk::Spill()
+	{
+		auto& registry = Registry::Get();
+
+		if (file.empty())
+		{
+			auto directory = registry.GetDirectory();
+			std::filesystem::create_directories(directory);
+
+			auto path = directory / ("chunk_" + std::to_string(registry.nextFile++) + ".bin");
+			std::ofstream stream(path, std::ios::binary);
+			Write(stream);
+
+			if (!stream)
+				throw std::runtime_error("Failed to spill trajectory chunk to " + path.string());
+
+			file = path.string();
+		}
+
+		Release();
+		resident = false;
+		registry.statistics.residentBytes -= bytes;
+		registry.statistics.spilledBytes += bytes;
+		registry.statistics.spills++;
+	}
+
+	void Chunk::Load()
+	{
+		auto& registry = Registry::Get();
+		std::lock_guard lock(registry.mutex);
+
+		// other thread loaded it while this one waited for the lock
+		if (resident)
+			return;
+
+		std::ifstream stream(file, std::ios::binary);
+		Read(stream);
+
+		if (!stream)
+			throw std::runtime_error("Failed to load trajectory chunk from " + file);
+
+		resident = true;
+		registry.resident.push_back(this);
+		position = std::prev(registry.resident.end());
+		registry.statistics.residentBytes += bytes;
+		registry.statistics.spilledBytes -= bytes;
+		registry.statistics.loads++;
+	}
+}
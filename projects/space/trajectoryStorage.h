@@ -0,0 +1,92 @@
+#pragma once
+#include <filesystem>
+#include <iosfwd>
+#include <list>
+#include <string>
+#include <cstdint>
+#include <atomic>
+
+// Memory budget of trajectories. Trajectory data is stored in chunks of fixed size, full chunks
+// are never modified again, so they can be written to disk and released when resident chunks
+// exceed the budget. Spilled chunk is loaded back on first access, on any thread.
+// Chunks are spilled only on the owner thread (the one which set the settings) when it seals a chunk
+// or calls Trim, other threads may read trajectories while the owner waits for them (thread pool).
+namespace TrajectoryStorage
+{
+	struct Settings
+	{
+		// bytes of full chunks kept in memory, zero means unlimited
+		size_t ramBudget = 0;
+		// without spilling the budget is only reported, nothing is released
+		bool spillToDisk = false;
+		// where spilled chunks are written, empty means temporary directory of the system
+		std::filesystem::path directory;
+	};
+
+	struct Statistics
+	{
+		size_t residentBytes = 0;
+		size_t spilledBytes = 0;
+		size_t spills = 0;
+		size_t loads = 0;
+	};
+
+	// calling thread becomes the owner which spills chunks
+	void SetSettings(const Settings& settings);
+	const Settings& GetSettings();
+	Statistics GetStatistics();
+
+	// spill least recently used full chunks until resident ones fit the budget, no-op on other than owner thread
+	void Trim();
+
+	// Base of chunks of ChunkedVector, keeps track of residency. Derived class provides the data.
+	struct Chunk
+	{
+		Chunk() = default;
+		Chunk(const Chunk&) = delete;
+		Chunk& operator=(const Chunk&) = delete;
+		virtual ~Chunk();
+
+		// called on every access, loads spilled data back to memory
+		void Touch()
+		{
+			if (!resident.load(std::memory_order_acquire))
+				Load();
+			// store only when needed, so readers on many threads don't write the same cache line
+			if (!accessed.load(std::memory_order_relaxed))
+				accessed.store(true, std::memory_order_relaxed);
+		}
+
+		bool IsSealed() const { return sealed; }
+
+	protected:
+		// chunk is full, it can be spilled from now on
+		void Seal();
+		// chunk is full and its data is in file mapped to memory, the system loads and releases it,
+		// so it is neither spilled nor counted in budget
+		void SealMapped();
+
+		virtual size_t GetBytes() const = 0;
+		virtual void Write(std::ostream& stream) const = 0;
+		virtual void Read(std::istream& stream) = 0;
+		virtual void Release() = 0;
+
+	private:
+		friend struct Registry;
+
+		void Load();
+		void Spill();
+
+		// changed only with locked registry, read without lock by Touch
+		std::atomic<bool> resident = true;
+		bool sealed = false;
+		bool mapped = false;
+		// second chance of clock eviction, chunk accessed since last pass is skipped
+		std::atomic<bool> accessed = false;
+		// size of data, known since sealing (virtual GetBytes can't be called from destructor)
+		size_t bytes = 0;
+		// sealed data does not change, file written once is reused by later spills
+		std::string file;
+		std::list<Chunk*>::iterator position;
+	};
+}
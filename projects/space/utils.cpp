@@ -1,17 +1,20 @@
 #include "utils.h"
-#include "common.h"
 #include <random>
-#include <Corrade/Utility/Resource.h>
+#include <fstream>
 
 using namespace Magnum2D;
 
-std::random_device g_randDev;
-std::mt19937 g_rand(g_randDev());
+std::mt19937 g_rand(Utils::DefaultRandomSeed);
 
 extern double GravitationalConstant;
 
 namespace Utils
 {
+	void SetRandomSeed(uint32_t seed)
+	{
+		g_rand.seed(seed);
+	}
+
 	vec2 GetRandomPosition(float xmin, float xmax, float ymin, float ymax)
 	{
 		std::uniform_real_distribution<float> distx(xmin, xmax);
@@ -22,7 +25,9 @@ namespace Utils
 
 	col3 GetRandomColor()
 	{
-		return rgb(rand() % 255, rand() % 255 , rand() % 255);
+		std::uniform_int_distribution<int32_t> dist(0, 254);
+
+		return col3(dist(g_rand) / 255.0f, dist(g_rand) / 255.0f, dist(g_rand) / 255.0f);
 	}
 
 	vec2 RotateVector(const vec2& vector, float radians)
@@ -40,35 +45,6 @@ namespace Utils
 		return atan2(vector.y(), vector.x());
 	}
 
-	void DrawVector(const vec2& position, const vec2& vector, const col3& color)
-	{
-		static const float ArrowAngle = 10 * Deg2Rad;
-		static const float ArrowSize = 0.2f;
-		static const float GrabCircleRadius = 0.3f;
-
-		vec2 destPosition = position + vector;
-		
-		const float LineWidth = Common::GetZoomIndependentSize(0.03f);
-
-		Common::DrawLines({ position, destPosition }, LineWidth, color);
-
-		auto arrowDir = (-vector).normalized();
-		auto arrowLeft = RotateVector(arrowDir, ArrowAngle) * Common::GetZoomIndependentSize(ArrowSize);
-		auto arrowRight = RotateVector(arrowDir, -ArrowAngle) * Common::GetZoomIndependentSize(ArrowSize);
-
-		Common::DrawLines({ destPosition, destPosition + arrowLeft }, LineWidth, color);
-		Common::DrawLines({ destPosition, destPosition + arrowRight }, LineWidth, color);
-	}
-
-	void DrawCross(const vec2& position, float size, const col3& color)
-	{
-		const float LineWidth = Common::GetZoomIndependentSize(0.03f);
-		float hsize = size / 2.0f;
-
-		Common::DrawLines({ position - vec2(0.0f, hsize), position + vec2(0.0f, hsize) }, LineWidth, color);
-		Common::DrawLines({ position - vec2(hsize, 0.0f), position + vec2(hsize, 0.0f) }, LineWidth, color);
-	}
-
 	std::vector<vec2> ConvertToFloat(const std::vector<vec2d>& arr)
 	{
 		std::vector<vec2> result;
@@ -113,41 +89,24 @@ namespace Utils
 		return p.x() * p.x() + p.y() * p.y();
 	}
 
-	bool ClickHandler::IsClick()
-	{
-		return isMouseReleased() && accumulatedMouseDelta < Common::GetZoomIndependentSize(MouseDeltaSqrThreshold);
-	}
-
-	void ClickHandler::Update()
-	{
-		if (isMouseDown())
-		{
-			accumulatedMouseDelta += LenghtSqr(convertWindowToWorldVector(getMouseDeltaWindow()));
-		}
-
-		if (isMouseReleased())
-		{
-			accumulatedMouseDelta = 0.0f;
-		}
-	}
-
 	std::string GetRandomString(size_t chars)
 	{
 		std::string result(chars, '\0');
+		std::uniform_int_distribution<int32_t> dist('a', 'y');
 
 		for (size_t i = 0; i < chars; i++)
-			result[i] = rand() % 25 + 97;
+			result[i] = (char)dist(g_rand);
 
 		return result;
 	}
 
-	nlohmann::json ReadJsonFromResource(std::string_view group, std::string_view file)
+	nlohmann::json ReadJsonFromFile(const std::string& path)
 	{
-		Corrade::Utility::Resource resource(group.data());
-
-		auto data = resource.getString(file.data());
+		std::ifstream file(path);
+		if (!file)
+			throw std::runtime_error("Cannot open " + path);
 
-		return nlohmann::json::parse((std::string)data);
+		return nlohmann::json::parse(file);
 	}
 
 	double GetMeanDeviation(const std::vector<double>& data)
@@ -1,6 +1,7 @@
 #pragma once
 #include <Magnum2D.h>
 #include <nlohmann/json.hpp>
+#include <cmath>
 
 namespace Unit
 {
@@ -32,6 +33,10 @@ namespace Utils
 	const double Deg2Rad = 0.0174533;
 	const double Pi = 3.1415926535897931;
 
+	// random functions use single generator with fixed seed, so runs (and benchmarks) are reproducible
+	const uint32_t DefaultRandomSeed = 5489u;
+	void SetRandomSeed(uint32_t seed);
+
 	Magnum2D::vec2 GetRandomPosition(float xmin, float xmax, float ymin, float ymax); // ranges are inclusive
 	Magnum2D::col3 GetRandomColor();
 	std::string GetRandomString(size_t chars);
@@ -61,6 +66,24 @@ namespace Utils
 
 	bool SigmaCompare(double a, double b, double sigma = 0.0000000001);
 
+	// Neumaier (improved Kahan) summation, rounding error of each addition is accumulated in error,
+	// sum + error is the precise value. Compiler must not reassociate floating point math (no fast-math).
+	inline void AddCompensated(double& sum, double& error, double value)
+	{
+		const double result = sum + value;
+		if (std::abs(sum) >= std::abs(value))
+			error += (sum - result) + value;
+		else
+			error += (value - result) + sum;
+		sum = result;
+	}
+
+	inline void AddCompensated(Magnum2D::vec2d& sum, Magnum2D::vec2d& error, const Magnum2D::vec2d& value)
+	{
+		AddCompensated(sum.x(), error.x(), value.x());
+		AddCompensated(sum.y(), error.y(), value.y());
+	}
+
 	struct ClickHandler
 	{
 		static constexpr float MouseDeltaSqrThreshold = 0.015f * 0.015f;
@@ -74,6 +97,9 @@ namespace Utils
 	};
 
 	nlohmann::json ReadJsonFromResource(std::string_view group, std::string_view file);
+	// data of compiled resource, valid for the whole run
+	std::string_view ReadResource(std::string_view group, std::string_view file);
+	nlohmann::json ReadJsonFromFile(const std::string& path);
 
 	std::vector<Magnum2D::vec2d> GenerateEllipsePoints(double a, double b);
 	std::vector<Magnum2D::vec2d> GenerateHyperbolaPoints(double a, double b);
@@ -0,0 +1,75 @@
+#include "utils.h"
+#include "common.h"
+#include <Corrade/Utility/Resource.h>
+
+// utilities depending on Magnum2D application (drawing, input and compiled resources)
+
+using namespace Magnum2D;
+
+namespace Utils
+{
+	void DrawVector(const vec2& position, const vec2& vector, const col3& color)
+	{
+		static const float ArrowAngle = 10 * Deg2Rad;
+		static const float ArrowSize = 0.2f;
+		static const float GrabCircleRadius = 0.3f;
+
+		vec2 destPosition = position + vector;
+		
+		const float LineWidth = Common::GetZoomIndependentSize(0.03f);
+
+		Common::DrawLines({ position, destPosition }, LineWidth, color);
+
+		auto arrowDir = (-vector).normalized();
+		auto arrowLeft = RotateVector(arrowDir, ArrowAngle) * Common::GetZoomIndependentSize(ArrowSize);
+		auto arrowRight = RotateVector(arrowDir, -ArrowAngle) * Common::GetZoomIndependentSize(ArrowSize);
+
+		Common::DrawLines({ destPosition, destPosition + arrowLeft }, LineWidth, color);
+		Common::DrawLines({ destPosition, destPosition + arrowRight }, LineWidth, color);
+	}
+
+	void DrawCross(const vec2& position, float size, const col3& color)
+	{
+		const float LineWidth = Common::GetZoomIndependentSize(0.03f);
+		float hsize = size / 2.0f;
+
+		Common::DrawLines({ position - vec2(0.0f, hsize), position + vec2(0.0f, hsize) }, LineWidth, color);
+		Common::DrawLines({ position - vec2(hsize, 0.0f), position + vec2(hsize, 0.0f) }, LineWidth, color);
+	}
+
+	bool ClickHandler::IsClick()
+	{
+		return isMouseReleased() && accumulatedMouseDelta < Common::GetZoomIndependentSize(MouseDeltaSqrThreshold);
+	}
+
+	void ClickHandler::Update()
+	{
+		if (isMouseDown())
+		{
+			accumulatedMouseDelta += LenghtSqr(convertWindowToWorldVector(getMouseDeltaWindow()));
+		}
+
+		if (isMouseReleased())
+		{
+			accumulatedMouseDelta = 0.0f;
+		}
+	}
+
+	nlohmann::json ReadJsonFromResource(std::string_view group, std::string_view file)
+	{
+		Corrade::Utility::Resource resource(group.data());
+
+		auto data = resource.getString(file.data());
+
+		return nlohmann::json::parse((std::string)data);
+	}
+
+	std::string_view ReadResource(std::string_view group, std::string_view file)
+	{
+		Corrade::Utility::Resource resource(group.data());
+
+		auto data = resource.getRaw(file.data());
+
+		return { data.data(), data.size() };
+	}
+}
@@ -143,6 +143,15 @@ VectorHandler::Vector VectorHandler::Push(Magnum2D::vec2 from, Magnum2D::vec2 to
 	return vector;
 }
 
+void VectorHandler::Remove(Vector vector)
+{
+	vectors.erase(vector);
+	if (grabVec == vector)
+		grabVec.reset();
+	if (highlightVec == vector)
+		highlightVec.reset();
+}
+
 void VectorHandler::Clear()
 {
 	vectors.clear();
@@ -33,6 +33,7 @@ struct VectorHandler
 	bool IsGrab();
 	std::optional<Vector> GetGrab();
 
+	void Remove(Vector vector);
 	void Clear();
 	void ClearGrab();
 	void ClearOnlyVectors();